@@ -0,0 +1,945 @@
+//
+// Copyright (c) 2013 Mikko Mononen memon@inside.org
+//
+// This software is provided 'as-is', without any express or implied
+// warranty.  In no event will the authors be held liable for any damages
+// arising from the use of this software.
+// Permission is granted to anyone to use this software for any purpose,
+// including commercial applications, and to alter it and redistribute it
+// freely, subject to the following restrictions:
+// 1. The origin of this software must not be misrepresented; you must not
+//    claim that you wrote the original software. If you use this software
+//    in a product, an acknowledgment in the product documentation would be
+//    appreciated but is not required.
+// 2. Altered source versions must be plainly marked as such, and must not be
+//    misrepresented as being the original software.
+// 3. This notice may not be removed or altered from any source distribution.
+//
+
+// Headless benchmark, renders the demo and synthetic scenes without a GPU and reports
+// per phase timings, allocations and vertex counts as JSON.
+//
+//	bench [--sw] [--threads n] [--raster-threads n [--raster-policy name]] [--frames n] [--warmup n] [--size w h] [--scene name]
+//
+// By default the frames are submitted to a null back-end which only copies the vertices,
+// so that the timings show the CPU cost of nanovg.c. With --sw the frames are rasterized
+// with the software back-end. With --raster-threads the glyphs are rasterized on that many
+// threads, the policy is block, placeholder or fallback, see nvgTextRasterThreads().
+// Run from the build directory, like the other examples.
+//
+// nanovg.c and demo.c are compiled into this file so that allocations can be counted and
+// the text calls can be timed. nanovg.c is built with NVG_FRAME_TIMINGS, the flatten, expand
+// and glyph rasterization times come from nvgGetFrameStats().
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <time.h>
+#include <pthread.h>
+#include <unistd.h>
+#endif
+
+static double benchTime(void)
+{
+#ifdef _WIN32
+	LARGE_INTEGER freq, t;
+	QueryPerformanceFrequency(&freq);
+	QueryPerformanceCounter(&t);
+	return (double)t.QuadPart / (double)freq.QuadPart;
+#else
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+#endif
+}
+
+struct BenchCounters {
+	double flatten;
+	double expand;
+	double text;
+	double glyph;
+	double submit;
+	double flush;
+	double allocs;
+	double allocBytes;
+	double fillVerts;
+	double strokeVerts;
+	double triangleVerts;
+	double shapeVerts;
+	double fillCalls;
+	double strokeCalls;
+	double triangleCalls;
+	double shapeCalls;
+	double fillTris;
+	double strokeTris;
+	double textTris;
+	double drawCalls;
+	double commands;
+	double points;
+	double bezierSegments;
+	double expandedVerts;
+	double glyphHits;
+	double glyphMisses;
+	double textRunHits;
+	double uploads;
+	double uploadBytes;
+	double culledPaths;
+	double culledTexts;
+};
+typedef struct BenchCounters BenchCounters;
+
+static BenchCounters bench;
+
+static void* benchMalloc(size_t size)
+{
+	bench.allocs++;
+	bench.allocBytes += (double)size;
+	return malloc(size);
+}
+
+static void* benchRealloc(void* ptr, size_t size)
+{
+	bench.allocs++;
+	bench.allocBytes += (double)size;
+	return realloc(ptr, size);
+}
+
+#define malloc(size) benchMalloc(size)
+#define realloc(ptr, size) benchRealloc(ptr, size)
+
+#define NVG_FRAME_TIMINGS
+#include "nanovg.c"
+#define NANOVG_SW_IMPLEMENTATION
+#include "nanovg_sw.h"
+
+//
+// Timed wrappers for the calls which layout text.
+// The time spent in the back-end is accounted separately.
+
+static NVGparams benchBackend;
+
+static double benchBegin(void)
+{
+	return benchTime() - bench.submit;
+}
+
+static double benchEnd(double start)
+{
+	return benchTime() - bench.submit - start;
+}
+
+static float benchText(NVGcontext* ctx, float x, float y, const char* string, const char* end)
+{
+	double t = benchBegin();
+	float ret = nvgText(ctx, x, y, string, end);
+	bench.text += benchEnd(t);
+	return ret;
+}
+
+static void benchTextBox(NVGcontext* ctx, float x, float y, float breakRowWidth, const char* string, const char* end)
+{
+	double t = benchBegin();
+	nvgTextBox(ctx, x, y, breakRowWidth, string, end);
+	bench.text += benchEnd(t);
+}
+
+static float benchTextBounds(NVGcontext* ctx, float x, float y, const char* string, const char* end, float* bounds)
+{
+	double t = benchBegin();
+	float ret = nvgTextBounds(ctx, x, y, string, end, bounds);
+	bench.text += benchEnd(t);
+	return ret;
+}
+
+static void benchTextBoxBounds(NVGcontext* ctx, float x, float y, float breakRowWidth, const char* string, const char* end, float* bounds)
+{
+	double t = benchBegin();
+	nvgTextBoxBounds(ctx, x, y, breakRowWidth, string, end, bounds);
+	bench.text += benchEnd(t);
+}
+
+static int benchTextGlyphPositions(NVGcontext* ctx, float x, float y, const char* string, const char* end, NVGglyphPosition* positions, int maxPositions)
+{
+	double t = benchBegin();
+	int ret = nvgTextGlyphPositions(ctx, x, y, string, end, positions, maxPositions);
+	bench.text += benchEnd(t);
+	return ret;
+}
+
+static int benchTextBreakLines(NVGcontext* ctx, const char* string, const char* end, float breakRowWidth, NVGtextRow* rows, int maxRows, int skipSpaces)
+{
+	double t = benchBegin();
+	int ret = nvgTextBreakLines(ctx, string, end, breakRowWidth, rows, maxRows, skipSpaces);
+	bench.text += benchEnd(t);
+	return ret;
+}
+
+#define nvgText(ctx, x, y, string, end) benchText(ctx, x, y, string, end)
+#define nvgTextBox(ctx, x, y, w, string, end) benchTextBox(ctx, x, y, w, string, end)
+#define nvgTextBounds(ctx, x, y, string, end, bounds) benchTextBounds(ctx, x, y, string, end, bounds)
+#define nvgTextBoxBounds(ctx, x, y, w, string, end, bounds) benchTextBoxBounds(ctx, x, y, w, string, end, bounds)
+#define nvgTextGlyphPositions(ctx, x, y, string, end, positions, max) benchTextGlyphPositions(ctx, x, y, string, end, positions, max)
+#define nvgTextBreakLines(ctx, string, end, w, rows, max, skip) benchTextBreakLines(ctx, string, end, w, rows, max, skip)
+
+#define DEMO_NO_GL
+#include "demo.c"
+
+//
+// Back-end wrappers, measure the time spent in the back-end and count the submitted geometry.
+
+static void benchRenderFill(void* uptr, NVGpaint* paint, NVGcompositeOperationState compositeOperation, NVGscissor* scissor, float fringe,
+							const float* bounds, const NVGpath* paths, int npaths)
+{
+	double t = benchTime();
+	int i;
+	for (i = 0; i < npaths; i++)
+		bench.fillVerts += paths[i].nfill + paths[i].nstroke;
+	bench.fillCalls++;
+	benchBackend.renderFill(uptr, paint, compositeOperation, scissor, fringe, bounds, paths, npaths);
+	bench.submit += benchTime() - t;
+}
+
+static void benchRenderStroke(void* uptr, NVGpaint* paint, NVGcompositeOperationState compositeOperation, NVGscissor* scissor, float fringe,
+							  float strokeWidth, int lineStyle, const NVGpath* paths, int npaths)
+{
+	double t = benchTime();
+	int i;
+	for (i = 0; i < npaths; i++)
+		bench.strokeVerts += paths[i].nstroke;
+	bench.strokeCalls++;
+	benchBackend.renderStroke(uptr, paint, compositeOperation, scissor, fringe, strokeWidth, lineStyle, paths, npaths);
+	bench.submit += benchTime() - t;
+}
+
+static void benchRenderTriangles(void* uptr, NVGpaint* paint, NVGcompositeOperationState compositeOperation, NVGscissor* scissor,
+								 const NVGvertex* verts, int nverts, float fringe)
+{
+	double t = benchTime();
+	bench.triangleVerts += nverts;
+	bench.triangleCalls++;
+	benchBackend.renderTriangles(uptr, paint, compositeOperation, scissor, verts, nverts, fringe);
+	bench.submit += benchTime() - t;
+}
+
+static void benchRenderShapes(void* uptr, NVGcompositeOperationState compositeOperation, NVGscissor* scissor, float fringe,
+							  const NVGshapeVertex* verts, int nverts)
+{
+	double t = benchTime();
+	bench.shapeVerts += nverts;
+	bench.shapeCalls++;
+	benchBackend.renderShapes(uptr, compositeOperation, scissor, fringe, verts, nverts);
+	bench.submit += benchTime() - t;
+}
+
+static int benchRenderUpdateTexture(void* uptr, int image, int x, int y, int w, int h, const unsigned char* data)
+{
+	double t = benchTime();
+	int ret = benchBackend.renderUpdateTexture(uptr, image, x, y, w, h, data);
+	bench.submit += benchTime() - t;
+	return ret;
+}
+
+static void benchRenderFlush(void* uptr)
+{
+	double t = benchTime();
+	benchBackend.renderFlush(uptr);
+	bench.flush += benchTime() - t;
+}
+
+static void benchWrapBackend(NVGcontext* vg)
+{
+	NVGparams* params = nvgInternalParams(vg);
+	benchBackend = *params;
+	params->renderFill = benchRenderFill;
+	params->renderStroke = benchRenderStroke;
+	params->renderTriangles = benchRenderTriangles;
+	if (params->renderShapes != NULL)
+		params->renderShapes = benchRenderShapes;
+	params->renderUpdateTexture = benchRenderUpdateTexture;
+	params->renderFlush = benchRenderFlush;
+}
+
+//
+// Null back-end, copies the geometry like a GPU back-end would, but does not render it.
+
+struct NullTexture {
+	int width, height;
+};
+typedef struct NullTexture NullTexture;
+
+struct NullContext {
+	NullTexture* textures;
+	int ntextures;
+	int ctextures;
+	NVGvertex* verts;
+	int nverts;
+	int cverts;
+	NVGshapeVertex* shapeVerts;
+	int nshapeVerts;
+	int cshapeVerts;
+};
+typedef struct NullContext NullContext;
+
+static int nullRenderCreate(void* uptr)
+{
+	NVG_NOTUSED(uptr);
+	return 1;
+}
+
+static int nullRenderCreateTexture(void* uptr, int type, int w, int h, int imageFlags, const unsigned char* data)
+{
+	NullContext* null = (NullContext*)uptr;
+	NVG_NOTUSED(type);
+	NVG_NOTUSED(imageFlags);
+	NVG_NOTUSED(data);
+	if (null->ntextures+1 > null->ctextures) {
+		NullTexture* textures;
+		int ctextures = null->ntextures+1 + null->ctextures/2;
+		textures = (NullTexture*)realloc(null->textures, sizeof(NullTexture) * ctextures);
+		if (textures == NULL) return 0;
+		null->textures = textures;
+		null->ctextures = ctextures;
+	}
+	null->textures[null->ntextures].width = w;
+	null->textures[null->ntextures].height = h;
+	return ++null->ntextures;
+}
+
+static int nullRenderDeleteTexture(void* uptr, int image)
+{
+	NVG_NOTUSED(uptr);
+	NVG_NOTUSED(image);
+	return 1;
+}
+
+static int nullRenderUpdateTexture(void* uptr, int image, int x, int y, int w, int h, const unsigned char* data)
+{
+	NVG_NOTUSED(uptr);
+	NVG_NOTUSED(image);
+	NVG_NOTUSED(x);
+	NVG_NOTUSED(y);
+	NVG_NOTUSED(w);
+	NVG_NOTUSED(h);
+	NVG_NOTUSED(data);
+	return 1;
+}
+
+static int nullRenderGetTextureSize(void* uptr, int image, int* w, int* h)
+{
+	NullContext* null = (NullContext*)uptr;
+	if (image < 1 || image > null->ntextures) return 0;
+	*w = null->textures[image-1].width;
+	*h = null->textures[image-1].height;
+	return 1;
+}
+
+static int nullRenderGetImageTextureId(void* uptr, int image)
+{
+	NVG_NOTUSED(uptr);
+	return image;
+}
+
+static void nullRenderViewport(void* uptr, float width, float height, float devicePixelRatio)
+{
+	NVG_NOTUSED(uptr);
+	NVG_NOTUSED(width);
+	NVG_NOTUSED(height);
+	NVG_NOTUSED(devicePixelRatio);
+}
+
+static void nullRenderCancel(void* uptr)
+{
+	NullContext* null = (NullContext*)uptr;
+	null->nverts = 0;
+	null->nshapeVerts = 0;
+}
+
+static void nullRenderFlush(void* uptr)
+{
+	NullContext* null = (NullContext*)uptr;
+	null->nverts = 0;
+	null->nshapeVerts = 0;
+}
+
+static void nullCopyVerts(NullContext* null, const NVGvertex* verts, int nverts)
+{
+	if (null->nverts+nverts > null->cverts) {
+		NVGvertex* buf;
+		int cverts = null->nverts+nverts + null->cverts/2;
+		buf = (NVGvertex*)realloc(null->verts, sizeof(NVGvertex) * cverts);
+		if (buf == NULL) return;
+		null->verts = buf;
+		null->cverts = cverts;
+	}
+	memcpy(&null->verts[null->nverts], verts, sizeof(NVGvertex) * nverts);
+	null->nverts += nverts;
+}
+
+static void nullRenderFill(void* uptr, NVGpaint* paint, NVGcompositeOperationState compositeOperation, NVGscissor* scissor, float fringe,
+						   const float* bounds, const NVGpath* paths, int npaths)
+{
+	NullContext* null = (NullContext*)uptr;
+	int i;
+	NVG_NOTUSED(paint);
+	NVG_NOTUSED(compositeOperation);
+	NVG_NOTUSED(scissor);
+	NVG_NOTUSED(fringe);
+	NVG_NOTUSED(bounds);
+	for (i = 0; i < npaths; i++) {
+		nullCopyVerts(null, paths[i].fill, paths[i].nfill);
+		nullCopyVerts(null, paths[i].stroke, paths[i].nstroke);
+	}
+}
+
+static void nullRenderStroke(void* uptr, NVGpaint* paint, NVGcompositeOperationState compositeOperation, NVGscissor* scissor, float fringe,
+							 float strokeWidth, int lineStyle, const NVGpath* paths, int npaths)
+{
+	NullContext* null = (NullContext*)uptr;
+	int i;
+	NVG_NOTUSED(paint);
+	NVG_NOTUSED(compositeOperation);
+	NVG_NOTUSED(scissor);
+	NVG_NOTUSED(fringe);
+	NVG_NOTUSED(strokeWidth);
+	NVG_NOTUSED(lineStyle);
+	for (i = 0; i < npaths; i++)
+		nullCopyVerts(null, paths[i].stroke, paths[i].nstroke);
+}
+
+static void nullRenderTriangles(void* uptr, NVGpaint* paint, NVGcompositeOperationState compositeOperation, NVGscissor* scissor,
+								const NVGvertex* verts, int nverts, float fringe)
+{
+	NullContext* null = (NullContext*)uptr;
+	NVG_NOTUSED(paint);
+	NVG_NOTUSED(compositeOperation);
+	NVG_NOTUSED(scissor);
+	NVG_NOTUSED(fringe);
+	nullCopyVerts(null, verts, nverts);
+}
+
+static void nullRenderShapes(void* uptr, NVGcompositeOperationState compositeOperation, NVGscissor* scissor, float fringe,
+							 const NVGshapeVertex* verts, int nverts)
+{
+	NullContext* null = (NullContext*)uptr;
+	NVG_NOTUSED(compositeOperation);
+	NVG_NOTUSED(scissor);
+	NVG_NOTUSED(fringe);
+	if (null->nshapeVerts+nverts > null->cshapeVerts) {
+		NVGshapeVertex* buf;
+		int cverts = null->nshapeVerts+nverts + null->cshapeVerts/2;
+		buf = (NVGshapeVertex*)realloc(null->shapeVerts, sizeof(NVGshapeVertex) * cverts);
+		if (buf == NULL) return;
+		null->shapeVerts = buf;
+		null->cshapeVerts = cverts;
+	}
+	memcpy(&null->shapeVerts[null->nshapeVerts], verts, sizeof(NVGshapeVertex) * nverts);
+	null->nshapeVerts += nverts;
+}
+
+static void nullRenderDelete(void* uptr)
+{
+	NullContext* null = (NullContext*)uptr;
+	if (null == NULL) return;
+	free(null->textures);
+	free(null->verts);
+	free(null->shapeVerts);
+	free(null);
+}
+
+static NVGcontext* nvgCreateNull(void)
+{
+	NVGparams params;
+	NullContext* null = (NullContext*)malloc(sizeof(NullContext));
+	if (null == NULL) return NULL;
+	memset(null, 0, sizeof(NullContext));
+
+	memset(&params, 0, sizeof(params));
+	params.renderCreate = nullRenderCreate;
+	params.renderCreateTexture = nullRenderCreateTexture;
+	params.renderDeleteTexture = nullRenderDeleteTexture;
+	params.renderUpdateTexture = nullRenderUpdateTexture;
+	params.renderGetTextureSize = nullRenderGetTextureSize;
+	params.renderGetImageTextureId = nullRenderGetImageTextureId;
+	params.renderViewport = nullRenderViewport;
+	params.renderCancel = nullRenderCancel;
+	params.renderFlush = nullRenderFlush;
+	params.renderFill = nullRenderFill;
+	params.renderStroke = nullRenderStroke;
+	params.renderTriangles = nullRenderTriangles;
+	params.renderShapes = nullRenderShapes;
+	params.renderDelete = nullRenderDelete;
+	params.userPtr = null;
+	params.edgeAntiAlias = 1;
+
+	return nvgCreateInternal(&params);
+}
+
+//
+// Scenes
+
+static unsigned int benchSeed = 1;
+
+static float benchRandom(void)
+{
+	benchSeed = benchSeed * 1664525u + 1013904223u;
+	return (float)(benchSeed >> 8) / 16777216.0f;
+}
+
+static void renderCables(NVGcontext* vg, float width, float height, float t, DemoData* data)
+{
+	int i;
+	NVG_NOTUSED(data);
+	benchSeed = 1;
+	for (i = 0; i < 10000; i++) {
+		float x0 = benchRandom() * width, y0 = benchRandom() * height;
+		float x1 = benchRandom() * width, y1 = benchRandom() * height;
+		float sag = 40.0f + 30.0f * sinf(t + i * 0.1f);
+		nvgBeginPath(vg);
+		nvgMoveTo(vg, x0, y0);
+		nvgBezierTo(vg, x0 + 60.0f, y0 + sag, x1 - 60.0f, y1 + sag, x1, y1);
+		nvgStrokeColor(vg, nvgHSLA(benchRandom(), 0.7f, 0.5f, 200));
+		nvgStrokeWidth(vg, 3.0f);
+		nvgStroke(vg);
+	}
+}
+
+static void renderRects(NVGcontext* vg, float width, float height, float t, DemoData* data)
+{
+	int i, cols = 250;
+	float w = width / cols, h = height / (50000 / cols);
+	NVG_NOTUSED(data);
+	for (i = 0; i < 50000; i++) {
+		float x = (i % cols) * w, y = (i / cols) * h;
+		nvgBeginPath(vg);
+		if (i & 3)
+			nvgRect(vg, x + 0.5f, y + 0.5f, w - 1.0f, h - 1.0f);
+		else
+			nvgRoundedRect(vg, x + 0.5f, y + 0.5f, w - 1.0f, h - 1.0f, 1.5f);
+		nvgFillColor(vg, nvgHSLA(fmodf(i * 0.0001f + t * 0.1f, 1.0f), 0.6f, 0.5f, 255));
+		nvgFill(vg);
+	}
+}
+
+// Same rectangles as above, drawn as shape batches.
+static void renderRectsBatched(NVGcontext* vg, float width, float height, float t, DemoData* data)
+{
+	static float rects[50000*4];
+	static float radii[50000];
+	static NVGcolor colors[50000];
+	int i, cols = 250;
+	float w = width / cols, h = height / (50000 / cols);
+	NVG_NOTUSED(data);
+	for (i = 0; i < 50000; i++) {
+		rects[i*4+0] = (i % cols) * w + 0.5f;
+		rects[i*4+1] = (i / cols) * h + 0.5f;
+		rects[i*4+2] = w - 1.0f;
+		rects[i*4+3] = h - 1.0f;
+		radii[i] = (i & 3) ? 0.0f : 1.5f;
+		colors[i] = nvgHSLA(fmodf(i * 0.0001f + t * 0.1f, 1.0f), 0.6f, 0.5f, 255);
+	}
+	nvgDrawRoundedRects(vg, rects, radii, colors, 50000);
+}
+
+static void renderTextPages(NVGcontext* vg, float width, float height, float t, DemoData* data)
+{
+	const char* text = "Lorem ipsum dolor sit amet, consectetur adipiscing elit, sed do eiusmod tempor incididunt ut labore "
+		"et dolore magna aliqua. Ut enim ad minim veniam, quis nostrud exercitation ullamco laboris nisi ut aliquip ex ea "
+		"commodo consequat. Duis aute irure dolor in reprehenderit in voluptate velit esse cillum dolore eu fugiat nulla "
+		"pariatur. Excepteur sint occaecat cupidatat non proident, sunt in culpa qui officia deserunt mollit anim id est laborum.";
+	float sizes[4] = {11.0f, 13.0f, 14.0f, 17.0f};
+	float colw = 240.0f, x, y;
+	int col = 0;
+	NVG_NOTUSED(t);
+
+	nvgFontFaceId(vg, data->fontNormal);
+	nvgTextAlign(vg, NVG_ALIGN_LEFT|NVG_ALIGN_TOP);
+	nvgFillColor(vg, nvgRGBA(255,255,255,220));
+	for (x = 10.0f; x + colw < width; x += colw + 10.0f, col++) {
+		float bounds[4];
+		nvgFontSize(vg, sizes[col % 4]);
+		for (y = 10.0f; y < height; y = bounds[3] + 8.0f) {
+			nvgTextBoxBounds(vg, x, y, colw, text, NULL, bounds);
+			nvgTextBox(vg, x, y, colw, text, NULL);
+		}
+	}
+}
+
+// A patch of 10000 labelled and connected objects.
+static void renderPatch(NVGcontext* vg, float width, float height, float t, DemoData* data, float zoom)
+{
+	int i, cols = 100;
+
+	nvgSave(vg);
+	nvgTranslate(vg, width*0.5f, height*0.5f);
+	nvgScale(vg, zoom, zoom);
+	nvgTranslate(vg, -cols*10.0f*0.5f + sinf(t)*20.0f, -cols*6.0f*0.5f);
+	nvgFontFaceId(vg, data->fontNormal);
+	nvgFontSize(vg, 3.0f);
+	nvgTextAlign(vg, NVG_ALIGN_LEFT|NVG_ALIGN_MIDDLE);
+	nvgStrokeWidth(vg, 0.3f);
+	for (i = 0; i < 10000; i++) {
+		float x = (i % cols) * 10.0f, y = (i / cols) * 6.0f;
+		nvgBeginPath(vg);
+		nvgRoundedRect(vg, x, y, 8.0f, 4.0f, 1.0f);
+		nvgFillColor(vg, nvgHSLA((i % 7) / 7.0f, 0.5f, 0.4f, 255));
+		nvgFill(vg);
+		nvgStrokeColor(vg, nvgRGBA(0,0,0,160));
+		nvgStroke(vg);
+
+		nvgBeginPath(vg);
+		nvgMoveTo(vg, x + 8.0f, y + 2.0f);
+		nvgBezierTo(vg, x + 9.0f, y + 2.0f, x + 9.0f, y + 5.0f, x + 10.0f, y + 5.0f);
+		nvgStroke(vg);
+
+		nvgFillColor(vg, nvgRGBA(255,255,255,220));
+		nvgText(vg, x + 1.0f, y + 2.0f, "object", NULL);
+	}
+	nvgRestore(vg);
+}
+
+// Zoomed in, so that most of the patch is culled.
+static void renderPatchZoomed(NVGcontext* vg, float width, float height, float t, DemoData* data)
+{
+	renderPatch(vg, width, height, t, data, 8.0f);
+}
+
+// Zoomed out to show the whole patch, objects are a few pixels and strokes thinner than a pixel.
+static void renderPatchOverview(NVGcontext* vg, float width, float height, float t, DemoData* data)
+{
+	renderPatch(vg, width, height, t, data, 0.25f);
+}
+
+static void renderPatchOverviewLod(NVGcontext* vg, float width, float height, float t, DemoData* data)
+{
+	nvgSave(vg);
+	nvgShapeLevelOfDetail(vg, 1);
+	renderPatch(vg, width, height, t, data, 0.25f);
+	nvgRestore(vg);
+}
+
+// A long document of paragraphs and margin labels scrolled to its middle, most of it off screen.
+static void renderTextScrolled(NVGcontext* vg, float width, float height, float t, DemoData* data)
+{
+	const char* text = "Lorem ipsum dolor sit amet, consectetur adipiscing elit, sed do eiusmod tempor incididunt ut labore "
+		"et dolore magna aliqua. Ut enim ad minim veniam, quis nostrud exercitation ullamco laboris nisi ut aliquip.";
+	float colw = width - 120.0f < 480.0f ? width - 120.0f : 480.0f;
+	int i;
+
+	nvgSave(vg);
+	nvgTranslate(vg, 0.0f, height*0.5f - 2000*70.0f*0.5f + sinf(t)*100.0f);
+	nvgFontFaceId(vg, data->fontNormal);
+	nvgFontSize(vg, 14.0f);
+	nvgTextAlign(vg, NVG_ALIGN_LEFT|NVG_ALIGN_TOP);
+	nvgFillColor(vg, nvgRGBA(255,255,255,220));
+	for (i = 0; i < 2000; i++) {
+		nvgTextBox(vg, 100.0f, i*70.0f, colw, text, NULL);
+		nvgText(vg, 10.0f, i*70.0f, "section", NULL);
+	}
+	nvgRestore(vg);
+}
+
+// A zooming document next to a panel of labels at a fixed size. Every zoom level adds glyphs
+// to the atlas, the panel labels should stay cached when it fills up.
+static void renderTextZoom(NVGcontext* vg, float width, float height, float t, DemoData* data)
+{
+	const char* text = "The quick brown fox jumps over the lazy dog. 0123456789 ABCDEFGHIJKLMNOPQRSTUVWXYZ";
+	float y;
+	int i;
+
+	nvgFontFaceId(vg, data->fontNormal);
+	nvgTextAlign(vg, NVG_ALIGN_LEFT|NVG_ALIGN_TOP);
+	nvgFillColor(vg, nvgRGBA(255,255,255,220));
+	nvgFontSize(vg, 14.0f);
+	for (i = 0; i < 40; i++) {
+		char label[32];
+		snprintf(label, sizeof(label), "Parameter %d: %.2f", i, i * 0.37f);
+		nvgText(vg, 10.0f, 10.0f + i * 18.0f, label, NULL);
+	}
+
+	nvgFontSize(vg, floorf(12.0f + 36.0f * (0.5f + 0.5f * sinf(t * 2.0f))));
+	for (y = 10.0f; y < height; y += 60.0f)
+		nvgTextBox(vg, 220.0f, y, width - 230.0f, text, NULL);
+}
+
+// A text view appearing at a size not drawn before every frame, all of its glyphs are rasterized.
+static void renderTextFresh(NVGcontext* vg, float width, float height, float t, DemoData* data)
+{
+	const char* text = "The quick brown fox jumps over the lazy dog. Sphinx of black quartz, judge my vow! 0123456789 "
+		"ABCDEFGHIJKLMNOPQRSTUVWXYZ abcdefghijklmnopqrstuvwxyz ({[<>]}) @#$%&*+-=/?";
+	int frame = (int)floorf(t * 60.0f + 0.5f);
+	float y;
+
+	nvgFontFaceId(vg, data->fontNormal);
+	nvgTextAlign(vg, NVG_ALIGN_LEFT|NVG_ALIGN_TOP);
+	nvgFillColor(vg, nvgRGBA(255,255,255,220));
+	nvgFontSize(vg, 12.0f + (float)((frame + 1000) % 160) * 0.25f);
+	for (y = 10.0f; y < height; y += 120.0f)
+		nvgTextBox(vg, 10.0f, y, width - 20.0f, text, NULL);
+}
+
+#define PLOT_SAMPLES 48000
+#define PLOT_TRACES 4
+
+static float plotSamples[PLOT_TRACES][PLOT_SAMPLES*2];
+
+static void renderPlotTraces(NVGcontext* vg, float width, float height, float t, int flags)
+{
+	int i, j;
+	float h = height / PLOT_TRACES;
+	for (j = 0; j < PLOT_TRACES; j++) {
+		float* xy = plotSamples[j];
+		if (xy[PLOT_SAMPLES*2-2] != width) {
+			benchSeed = j + 1;
+			for (i = 0; i < PLOT_SAMPLES; i++) {
+				float s = sinf(i * 0.002f * (j + 1)) * 0.6f + sinf(i * 0.05f) * 0.2f + (benchRandom() - 0.5f) * 0.3f;
+				xy[i*2] = width * i / (PLOT_SAMPLES - 1);
+				xy[i*2+1] = h * (j + 0.5f) - s * h * 0.45f;
+			}
+		}
+		// Move the traces a little so that each frame is transformed again.
+		nvgSave(vg);
+		nvgTranslate(vg, 0.0f, sinf(t + j) * 2.0f);
+		nvgBeginPath(vg);
+		nvgPolylineStrided(vg, &xy[0], &xy[1], PLOT_SAMPLES, sizeof(float)*2, flags);
+		nvgStrokeColor(vg, nvgHSLA(j / (float)PLOT_TRACES, 0.7f, 0.6f, 255));
+		nvgStrokeWidth(vg, 1.0f);
+		nvgStroke(vg);
+		nvgRestore(vg);
+	}
+}
+
+static void renderPlot(NVGcontext* vg, float width, float height, float t, DemoData* data)
+{
+	NVG_NOTUSED(data);
+	renderPlotTraces(vg, width, height, t, 0);
+}
+
+static void renderPlotDecimated(NVGcontext* vg, float width, float height, float t, DemoData* data)
+{
+	NVG_NOTUSED(data);
+	renderPlotTraces(vg, width, height, t, NVG_POLYLINE_DECIMATE);
+}
+
+static DemoData* benchDemoData;
+
+static void renderDemoScene(NVGcontext* vg, float width, float height, float t, DemoData* data)
+{
+	renderDemo(vg, width*0.5f, height*0.5f, width, height, t, 0, data);
+}
+
+struct BenchScene {
+	const char* name;
+	void (*render)(NVGcontext* vg, float width, float height, float t, DemoData* data);
+};
+typedef struct BenchScene BenchScene;
+
+static BenchScene benchScenes[] = {
+	{ "demo", renderDemoScene },
+	{ "cables", renderCables },
+	{ "rects", renderRects },
+	{ "rects_batched", renderRectsBatched },
+	{ "text", renderTextPages },
+	{ "patch_zoomed", renderPatchZoomed },
+	{ "patch_overview", renderPatchOverview },
+	{ "patch_overview_lod", renderPatchOverviewLod },
+	{ "text_scrolled", renderTextScrolled },
+	{ "text_zoom", renderTextZoom },
+	{ "text_fresh", renderTextFresh },
+	{ "plot", renderPlot },
+	{ "plot_decimated", renderPlotDecimated },
+};
+
+static int compareDouble(const void* a, const void* b)
+{
+	double da = *(const double*)a, db = *(const double*)b;
+	return da < db ? -1 : (da > db ? 1 : 0);
+}
+
+static void printPhases(const BenchCounters* c, double frameTime, int frames)
+{
+	double append = frameTime - (c->flatten + c->expand + c->text + c->submit + c->flush);
+	printf("\t\t\t\"phases_ms\": { \"append\": %.4f, \"flatten\": %.4f, \"expand\": %.4f, \"text_layout\": %.4f, \"glyph_raster\": %.4f, \"submit\": %.4f, \"flush\": %.4f },\n",
+		append / frames * 1000.0, c->flatten / frames * 1000.0, c->expand / frames * 1000.0,
+		(c->text - c->glyph) / frames * 1000.0, c->glyph / frames * 1000.0,
+		c->submit / frames * 1000.0, c->flush / frames * 1000.0);
+	printf("\t\t\t\"paths\": { \"commands\": %.0f, \"points\": %.0f, \"bezier_segments\": %.0f, \"expanded_verts\": %.0f },\n",
+		c->commands / frames, c->points / frames, c->bezierSegments / frames, c->expandedVerts / frames);
+	printf("\t\t\t\"glyphs\": { \"hits\": %.0f, \"misses\": %.0f, \"text_run_hits\": %.0f, \"uploads\": %.1f, \"upload_bytes\": %.0f },\n",
+		c->glyphHits / frames, c->glyphMisses / frames, c->textRunHits / frames, c->uploads / frames, c->uploadBytes / frames);
+	printf("\t\t\t\"allocs\": { \"count\": %.1f, \"bytes\": %.1f },\n", c->allocs / frames, c->allocBytes / frames);
+	printf("\t\t\t\"verts\": { \"fill\": %.0f, \"stroke\": %.0f, \"triangles\": %.0f, \"shapes\": %.0f },\n",
+		c->fillVerts / frames, c->strokeVerts / frames, c->triangleVerts / frames, c->shapeVerts / frames);
+	printf("\t\t\t\"calls\": { \"fill\": %.0f, \"stroke\": %.0f, \"triangles\": %.0f, \"shapes\": %.0f, \"culled_paths\": %.0f, \"culled_texts\": %.0f },\n",
+		c->fillCalls / frames, c->strokeCalls / frames, c->triangleCalls / frames, c->shapeCalls / frames,
+		c->culledPaths / frames, c->culledTexts / frames);
+	printf("\t\t\t\"tris\": { \"fill\": %.0f, \"stroke\": %.0f, \"text\": %.0f, \"draw_calls\": %.0f }\n",
+		c->fillTris / frames, c->strokeTris / frames, c->textTris / frames, c->drawCalls / frames);
+}
+
+static void accumCounters(BenchCounters* dst, const BenchCounters* src)
+{
+	double* d = (double*)dst;
+	const double* s = (const double*)src;
+	int i;
+	for (i = 0; i < (int)(sizeof(BenchCounters) / sizeof(double)); i++)
+		d[i] += s[i];
+}
+
+static void runScene(NVGcontext* vg, const BenchScene* scene, unsigned char* pixels, int width, int height,
+					 int warmup, int frames, int first)
+{
+	BenchCounters total;
+	double* times = (double*)calloc(frames, sizeof(double));
+	double sum = 0.0;
+	int i;
+
+	memset(&total, 0, sizeof(total));
+
+	for (i = -warmup; i < frames; i++) {
+		NVGframeStats stats;
+		double start;
+		if (pixels != NULL)
+			memset(pixels, 0, width*height*4);
+		memset(&bench, 0, sizeof(bench));
+
+		start = benchTime();
+		nvgBeginFrame(vg, (float)width, (float)height, 1.0f);
+		scene->render(vg, (float)width, (float)height, i / 60.0f, benchDemoData);
+		nvgEndFrame(vg);
+
+		if (i < 0) continue;
+		times[i] = benchTime() - start;
+		sum += times[i];
+		nvgGetFrameStats(vg, &stats);
+		bench.flatten = stats.flattenTime / 1000.0;
+		bench.expand = stats.expandTime / 1000.0;
+		bench.glyph = stats.glyphTime / 1000.0;
+		bench.fillTris = stats.fillTris;
+		bench.strokeTris = stats.strokeTris;
+		bench.textTris = stats.textTris;
+		bench.drawCalls = stats.drawCalls;
+		bench.commands = stats.commands;
+		bench.points = stats.points;
+		bench.bezierSegments = stats.bezierSegments;
+		bench.expandedVerts = stats.verts;
+		bench.glyphHits = stats.glyphHits;
+		bench.glyphMisses = stats.glyphMisses;
+		bench.textRunHits = stats.textRunHits;
+		bench.uploads = stats.uploads;
+		bench.uploadBytes = stats.uploadBytes;
+		bench.culledPaths = stats.culledPaths;
+		bench.culledTexts = stats.culledTexts;
+		accumCounters(&total, &bench);
+	}
+
+	qsort(times, frames, sizeof(double), compareDouble);
+
+	printf("%s\t\t\"%s\": {\n", first ? "" : ",\n", scene->name);
+	printf("\t\t\t\"frame_ms\": { \"mean\": %.4f, \"median\": %.4f, \"min\": %.4f, \"max\": %.4f },\n",
+		sum / frames * 1000.0, times[frames/2] * 1000.0, times[0] * 1000.0, times[frames-1] * 1000.0);
+	printPhases(&total, sum, frames);
+	printf("\t\t}");
+
+	free(times);
+}
+
+int main(int argc, char** argv)
+{
+	NVGcontext* vg = NULL;
+	DemoData data;
+	unsigned char* pixels = NULL;
+	const char* sceneName = NULL;
+	int width = 1280, height = 720, frames = 100, warmup = 10, sw = 0, threads = 1;
+	int rasterThreads = 0, rasterPolicy = NVG_RASTER_BLOCK;
+	int i, first = 1;
+
+	for (i = 1; i < argc; i++) {
+		if (strcmp(argv[i], "--sw") == 0) {
+			sw = 1;
+		} else if (strcmp(argv[i], "--threads") == 0 && i+1 < argc) {
+			threads = atoi(argv[++i]);
+		} else if (strcmp(argv[i], "--raster-threads") == 0 && i+1 < argc) {
+			rasterThreads = atoi(argv[++i]);
+		} else if (strcmp(argv[i], "--raster-policy") == 0 && i+1 < argc) {
+			i++;
+			if (strcmp(argv[i], "placeholder") == 0)
+				rasterPolicy = NVG_RASTER_PLACEHOLDER;
+			else if (strcmp(argv[i], "fallback") == 0)
+				rasterPolicy = NVG_RASTER_FALLBACK;
+			else
+				rasterPolicy = NVG_RASTER_BLOCK;
+		} else if (strcmp(argv[i], "--frames") == 0 && i+1 < argc) {
+			frames = atoi(argv[++i]);
+		} else if (strcmp(argv[i], "--warmup") == 0 && i+1 < argc) {
+			warmup = atoi(argv[++i]);
+		} else if (strcmp(argv[i], "--size") == 0 && i+2 < argc) {
+			width = atoi(argv[++i]);
+			height = atoi(argv[++i]);
+		} else if (strcmp(argv[i], "--scene") == 0 && i+1 < argc) {
+			sceneName = argv[++i];
+		} else {
+			fprintf(stderr, "usage: %s [--sw] [--threads n] [--raster-threads n [--raster-policy name]] [--frames n] [--warmup n] [--size w h] [--scene name]\n", argv[0]);
+			return 1;
+		}
+	}
+	if (frames < 1 || width < 1 || height < 1) {
+		fprintf(stderr, "Invalid arguments.\n");
+		return 1;
+	}
+
+	if (sw) {
+		vg = nvgCreateSW(0);
+		pixels = (unsigned char*)malloc(width*height*4);
+		if (vg == NULL || pixels == NULL) {
+			fprintf(stderr, "Could not init software renderer.\n");
+			return -1;
+		}
+		nvgswSetFramebuffer(vg, pixels, width, height, width*4);
+		threads = nvgswSetThreadCount(vg, threads);
+	} else {
+		vg = nvgCreateNull();
+		if (vg == NULL) {
+			fprintf(stderr, "Could not init nanovg.\n");
+			return -1;
+		}
+		threads = 1;
+	}
+
+	rasterThreads = nvgTextRasterThreads(vg, rasterThreads, rasterPolicy);
+
+	if (loadDemoData(vg, &data) == -1)
+		return -1;
+	benchDemoData = &data;
+	benchWrapBackend(vg);
+
+	printf("{\n");
+	printf("\t\"backend\": \"%s\",\n", sw ? "sw" : "null");
+	printf("\t\"threads\": %d,\n", threads);
+	printf("\t\"raster_threads\": %d,\n", rasterThreads);
+	printf("\t\"width\": %d,\n", width);
+	printf("\t\"height\": %d,\n", height);
+	printf("\t\"frames\": %d,\n", frames);
+	printf("\t\"scenes\": {\n");
+	for (i = 0; i < (int)(sizeof(benchScenes) / sizeof(benchScenes[0])); i++) {
+		if (sceneName != NULL && strcmp(sceneName, benchScenes[i].name) != 0) continue;
+		runScene(vg, &benchScenes[i], pixels, width, height, warmup, frames, first);
+		first = 0;
+	}
+	printf("\n\t}\n");
+	printf("}\n");
+
+	freeDemoData(vg, &data);
+
+	if (sw)
+		nvgDeleteSW(vg);
+	else
+		nvgDeleteInternal(vg);
+	free(pixels);
+
+	return 0;
+}
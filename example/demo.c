@@ -2,13 +2,15 @@
 #include <stdio.h>
 #include <string.h>
 #include <math.h>
+#include "nanovg.h"
+#ifndef DEMO_NO_GL
 #ifdef NANOVG_GLEW
 #  include <GL/glew.h>
 #endif
 #include <GLFW/glfw3.h>
-#include "nanovg.h"
 #define STB_IMAGE_WRITE_IMPLEMENTATION
 #include "stb_image_write.h"
+#endif
 
 
 #ifdef _MSC_VER
@@ -1210,6 +1212,7 @@ void renderDemo(NVGcontext* vg, float mx, float my, float width, float height,
 	nvgRestore(vg);
 }
 
+#ifndef DEMO_NO_GL
 static int mini(int a, int b) { return a < b ? a : b; }
 
 static void unpremultiplyAlpha(unsigned char* image, int w, int h, int stride)
@@ -1311,3 +1314,4 @@ void saveScreenShot(int w, int h, int premult, const char* name)
  	stbi_write_png(name, w, h, 4, image, w*4);
  	free(image);
 }
+#endif
@@ -224,3 +224,22 @@ solution "nanovg"
 		configuration "Release"
 			defines { "NDEBUG" }
 			flags { "Optimize", "ExtraWarnings"}
+
+	project "bench"
+		kind "ConsoleApp"
+		language "C"
+		files { "example/bench.c" }
+		includedirs { "src", "example" }
+		targetdir("build")
+		defines { "_CRT_SECURE_NO_WARNINGS" }
+
+		configuration { "linux" }
+			 links { "m", "pthread" }
+
+		configuration "Debug"
+			defines { "DEBUG" }
+			flags { "Symbols", "ExtraWarnings"}
+
+		configuration "Release"
+			defines { "NDEBUG" }
+			flags { "Optimize", "ExtraWarnings"}
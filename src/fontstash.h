@@ -24,8 +24,21 @@
 enum FONSflags {
 	FONS_ZERO_TOPLEFT = 1,
 	FONS_ZERO_BOTTOMLEFT = 2,
+	// Glyphs are cached once as signed distance fields of FONS_SDF_SIZE pixels and scaled to every size.
+	// Blur and dilate are left to the renderer. Ignored with FreeType.
+	FONS_SDF = 4,
 };
 
+// Signed distance field glyphs store FONS_SDF_ONEDGE on the outline, the value falls by
+// FONS_SDF_ONEDGE/FONS_SDF_PADDING per pixel outwards and reaches zero FONS_SDF_PADDING pixels out.
+#ifndef FONS_SDF_SIZE
+#	define FONS_SDF_SIZE 32
+#endif
+#ifndef FONS_SDF_PADDING
+#	define FONS_SDF_PADDING 6
+#endif
+#define FONS_SDF_ONEDGE 128
+
 enum FONSalign {
 	// Horizontal align
 	FONS_ALIGN_LEFT          = 1<<0, // Default
@@ -55,6 +68,15 @@ enum FONSerrorCode {
 	FONS_STATES_UNDERFLOW = 4,
 };
 
+enum FONSrasterPolicy {
+	// Drawing waits for the queued glyphs when the text is flushed or at fonsCommitGlyphs().
+	FONS_RASTER_BLOCK = 0,
+	// Queued glyphs are drawn as empty quads, their advance is kept.
+	FONS_RASTER_PLACEHOLDER = 1,
+	// Queued glyphs are drawn scaled from the closest size already in the atlas, or as empty quads.
+	FONS_RASTER_FALLBACK = 2,
+};
+
 struct FONSparams {
 	int width, height;
 	unsigned char flags;
@@ -71,6 +93,7 @@ struct FONSquad
 {
 	float x0,y0,s0,t0;
 	float x1,y1,s1,t1;
+	int page;	// Atlas page of the glyph bitmap, see fonsSetMaxPages().
 };
 typedef struct FONSquad FONSquad;
 
@@ -80,6 +103,7 @@ struct FONStextIter {
 	short isize, iblur, idilate;
 	struct FONSfont* font;
 	int prevGlyphIndex;
+	int glyph;	// Slot of the glyph in the glyph cache of the font, see fonsTouchGlyph().
 	const char* str;
 	const char* next;
 	const char* end;
@@ -101,6 +125,21 @@ void fonsGetAtlasSize(FONScontext* s, int* width, int* height);
 int fonsExpandAtlas(FONScontext* s, int width, int height);
 // Resets the whole stash.
 int fonsResetAtlas(FONScontext* stash, int width, int height);
+// Repacks the most recently used glyphs into one page of the given size and evicts the rest,
+// evicted glyphs are rasterized again when next drawn. Use instead of fonsResetAtlas() when full.
+int fonsCompactAtlas(FONScontext* stash, int width, int height);
+// Lets the atlas add pages of its size, up to maxPages, before it is full. Glyphs are added to the
+// last page only. The default is one page, the renderer must support pages to draw the quads.
+void fonsSetMaxPages(FONScontext* s, int maxPages);
+// Returns the number of atlas pages in use.
+int fonsGetAtlasPages(FONScontext* s);
+// Rasterizes new glyphs on count threads, zero rasterizes them on the calling thread and negative uses
+// one thread per CPU. Queued glyphs get their atlas spot right away and their bitmap at fonsCommitGlyphs(),
+// policy is one of FONSrasterPolicy. Returns the number of threads, zero with FONS_NO_THREADS or FreeType.
+int fonsSetRasterThreads(FONScontext* s, int count, int policy);
+// Copies the glyphs finished by the raster threads to the atlas, or waits for all queued glyphs
+// when wait is set. Returns the number of glyphs still queued.
+int fonsCommitGlyphs(FONScontext* s, int wait);
 
 // Add fonts
 int fonsAddFont(FONScontext* s, const char* name, const char* path, int fontIndex);
@@ -128,15 +167,26 @@ float fonsDrawText(FONScontext* s, float x, float y, const char* string, const c
 float fonsTextBounds(FONScontext* s, float x, float y, const char* string, const char* end, float* bounds);
 void fonsLineBounds(FONScontext* s, float y, float* miny, float* maxy);
 void fonsVertMetrics(FONScontext* s, float* ascender, float* descender, float* lineh);
+// Largest advance of any glyph of the current font and its fallbacks at the current size,
+// letter spacing not included. Bounds the width of a string without looking up its glyphs.
+float fonsMaxAdvance(FONScontext* s);
 
 // Text iterator
 int fonsTextIterInit(FONScontext* stash, FONStextIter* iter, float x, float y, const char* str, const char* end, int bitmapOption);
 int fonsTextIterNext(FONScontext* stash, FONStextIter* iter, struct FONSquad* quad);
 
-// Pull texture changes
+// Marks the glyph in the slot FONStextIter.glyph of the font as used, for callers which keep its quad.
+// Glyphs which are not used are the first to go when the atlas is compacted.
+void fonsTouchGlyph(FONScontext* s, int font, int glyph);
+
+// Pull texture changes, the pages are one below the other in the data and the dirty rectangle.
 const unsigned char* fonsGetTextureData(FONScontext* stash, int* width, int* height);
 int fonsValidateTexture(FONScontext* s, int* dirty);
 
+// Glyph cache hits, misses and seconds spent rasterizing since the last call.
+// Only gathered when compiled with FONS_STATS, the time also needs FONS_CLOCK().
+void fonsGetStats(FONScontext* s, int* hits, int* misses, double* rasterTime);
+
 // Draws the stash texture for debugging
 void fonsDrawDebug(FONScontext* s, float x, float y);
 
@@ -147,6 +197,10 @@ void fonsDrawDebug(FONScontext* s, float x, float y);
 
 #define FONS_NOTUSED(v)  (void)sizeof(v)
 
+#if defined(FONS_STATS) && !defined(FONS_CLOCK)
+#define FONS_CLOCK() 0.0
+#endif
+
 #ifdef FONS_USE_FREETYPE
 
 #include <ft2build.h>
@@ -176,6 +230,23 @@ typedef struct FONSttFontImpl FONSttFontImpl;
 
 #endif
 
+// FreeType faces can not be used from several threads.
+#if defined(FONS_USE_FREETYPE) && !defined(FONS_NO_THREADS)
+#define FONS_NO_THREADS
+#endif
+
+#ifndef FONS_NO_THREADS
+#ifdef _WIN32
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+#else
+#include <pthread.h>
+#include <unistd.h>
+#endif
+#endif
+
 #ifndef FONS_SCRATCH_BUF_SIZE
 #	define FONS_SCRATCH_BUF_SIZE 96000
 #endif
@@ -191,6 +262,9 @@ typedef struct FONSttFontImpl FONSttFontImpl;
 #ifndef FONS_INIT_ATLAS_NODES
 #	define FONS_INIT_ATLAS_NODES 256
 #endif
+#ifndef FONS_COMPACT_KEEP_AREA
+#	define FONS_COMPACT_KEEP_AREA 0.5f // Fraction of the atlas fonsCompactAtlas() fills with recent glyphs.
+#endif
 #ifndef FONS_VERTEX_COUNT
 #	define FONS_VERTEX_COUNT 1024
 #endif
@@ -200,6 +274,9 @@ typedef struct FONSttFontImpl FONSttFontImpl;
 #ifndef FONS_MAX_FALLBACKS
 #	define FONS_MAX_FALLBACKS 20
 #endif
+#ifndef FONS_MAX_RASTER_THREADS
+#	define FONS_MAX_RASTER_THREADS 16
+#endif
 
 static unsigned int fons__hashint(unsigned int a)
 {
@@ -227,8 +304,11 @@ struct FONSglyph
 	unsigned int codepoint;
 	int index;
 	int next;
+	unsigned int lastUsed;	// Lookup tick of the last use.
 	short size, blur, dilate;
 	short x0,y0,x1,y1;
+	short page;
+	short pending;	// Queued for a raster thread, see fonsSetRasterThreads().
 	short xadv,xoff,yoff;
 };
 typedef struct FONSglyph FONSglyph;
@@ -243,6 +323,7 @@ struct FONSfont
 	float ascender;
 	float descender;
 	float lineh;
+	float maxAdvance;
 	FONSglyph* glyphs;
 	int cglyphs;
 	int nglyphs;
@@ -278,6 +359,42 @@ struct FONSatlas
 };
 typedef struct FONSatlas FONSatlas;
 
+struct FONSscratch
+{
+	FONScontext* stash;	// Reports a full buffer, NULL on the raster threads.
+	unsigned char* data;
+	int n;
+};
+typedef struct FONSscratch FONSscratch;
+
+#ifndef FONS_NO_THREADS
+// Glyph rasterized on a thread, its gw*gh bitmap follows the job.
+struct FONSjob
+{
+	FONSfont* font;	// Font caching the glyph.
+	int glyph;	// Index of the glyph in the font.
+	FONSttFontImpl* renderFont;
+	int index;
+	int gw, gh, pad, blur, dilate;
+	float scale;
+	int done;
+	unsigned char* bitmap;
+};
+typedef struct FONSjob FONSjob;
+
+struct FONSworker
+{
+	FONScontext* stash;
+	FONSscratch scratch;
+#ifdef _WIN32
+	HANDLE thread;
+#else
+	pthread_t thread;
+#endif
+};
+typedef struct FONSworker FONSworker;
+#endif
+
 struct FONScontext
 {
 	FONSparams params;
@@ -285,19 +402,43 @@ struct FONScontext
 	unsigned char* texData;
 	int dirtyRect[4];
 	FONSfont** fonts;
-	FONSatlas* atlas;
+	FONSatlas* atlas;	// Free space of the last page.
+	int npages, maxPages;
 	int cfonts;
 	int nfonts;
 	float verts[FONS_VERTEX_COUNT*2];
 	float tcoords[FONS_VERTEX_COUNT*2];
 	unsigned int colors[FONS_VERTEX_COUNT];
 	int nverts;
-	unsigned char* scratch;
-	int nscratch;
+	FONSscratch scratch;
 	FONSstate states[FONS_MAX_STATES];
 	int nstates;
 	void (*handleError)(void* uptr, int error, int val);
 	void* errorUptr;
+	unsigned int tick;
+	int rasterPolicy;
+#ifndef FONS_NO_THREADS
+	FONSworker* workers;
+	int nworkers;
+	FONSjob** jobs;
+	int njobs, cjobs;
+	int nextJob;	// The jobs before it are taken by a thread.
+	int quit;
+#ifdef _WIN32
+	CRITICAL_SECTION lock;
+	CONDITION_VARIABLE start;
+	CONDITION_VARIABLE done;
+#else
+	pthread_mutex_t lock;
+	pthread_cond_t start;
+	pthread_cond_t done;
+#endif
+#endif
+#ifdef FONS_STATS
+	int nhits;
+	int nmisses;
+	double rasterTime;
+#endif
 #ifdef FONS_USE_FREETYPE
 	FT_Library ftLibrary;
 #endif
@@ -342,6 +483,11 @@ float fons__tt_getPixelHeightScale(FONSttFontImpl *font, float size)
 	return size / font->font->units_per_EM;
 }
 
+int fons__tt_getMaxAdvance(FONSttFontImpl *font)
+{
+	return font->font->max_advance_width;
+}
+
 int fons__tt_getGlyphIndex(FONSttFontImpl *font, int codepoint)
 {
 	return FT_Get_Char_Index(font->font, codepoint);
@@ -390,6 +536,20 @@ void fons__tt_renderGlyphBitmap(FONSttFontImpl *font, unsigned char *output, int
 	}
 }
 
+void fons__tt_renderGlyphSDF(FONSttFontImpl *font, unsigned char *output, int outWidth, int outHeight, int outStride,
+							 float scale, int padding, int glyph)
+{
+	// Not supported, FONS_SDF is cleared at create.
+	FONS_NOTUSED(font);
+	FONS_NOTUSED(output);
+	FONS_NOTUSED(outWidth);
+	FONS_NOTUSED(outHeight);
+	FONS_NOTUSED(outStride);
+	FONS_NOTUSED(scale);
+	FONS_NOTUSED(padding);
+	FONS_NOTUSED(glyph);
+}
+
 int fons__tt_getGlyphKernAdvance(FONSttFontImpl *font, int glyph1, int glyph2)
 {
 	FT_Vector ftKerning;
@@ -416,7 +576,7 @@ int fons__tt_loadFont(FONScontext *context, FONSttFontImpl *font, unsigned char
 	int offset, stbError;
 	FONS_NOTUSED(dataSize);
 
-	font->font.userdata = context;
+	font->font.userdata = &context->scratch;
 	offset = stbtt_GetFontOffsetForIndex(data, fontIndex);
 	if (offset == -1) {
 		stbError = 0;
@@ -436,6 +596,13 @@ float fons__tt_getPixelHeightScale(FONSttFontImpl *font, float size)
 	return stbtt_ScaleForMappingEmToPixels(&font->font, size);
 }
 
+int fons__tt_getMaxAdvance(FONSttFontImpl *font)
+{
+	// advanceWidthMax of the hhea table.
+	const unsigned char* p = font->font.data + font->font.hhea + 10;
+	return p[0]*256 + p[1];
+}
+
 int fons__tt_getGlyphIndex(FONSttFontImpl *font, int codepoint)
 {
 	return stbtt_FindGlyphIndex(&font->font, codepoint);
@@ -456,6 +623,21 @@ void fons__tt_renderGlyphBitmap(FONSttFontImpl *font, unsigned char *output, int
 	stbtt_MakeGlyphBitmap(&font->font, output, outWidth, outHeight, outStride, scaleX, scaleY, glyph);
 }
 
+void fons__tt_renderGlyphSDF(FONSttFontImpl *font, unsigned char *output, int outWidth, int outHeight, int outStride,
+							 float scale, int padding, int glyph)
+{
+	int x, y, w, h, xoff, yoff, cw, ch;
+	unsigned char* sdf = stbtt_GetGlyphSDF(&font->font, scale, glyph, padding, FONS_SDF_ONEDGE,
+										   (float)FONS_SDF_ONEDGE / padding, &w, &h, &xoff, &yoff);
+	if (sdf == NULL) return; // Empty glyph
+	cw = fons__mini(w, outWidth);
+	ch = fons__mini(h, outHeight);
+	for (y = 0; y < ch; y++)
+		for (x = 0; x < cw; x++)
+			output[y*outStride + x] = sdf[y*w + x];
+	STBTT_free(sdf, font->font.userdata);
+}
+
 int fons__tt_getGlyphKernAdvance(FONSttFontImpl *font, int glyph1, int glyph2)
 {
 	return stbtt_GetGlyphKernAdvance(&font->font, glyph1, glyph2);
@@ -468,18 +650,18 @@ int fons__tt_getGlyphKernAdvance(FONSttFontImpl *font, int glyph1, int glyph2)
 static void* fons__tmpalloc(size_t size, void* up)
 {
 	unsigned char* ptr;
-	FONScontext* stash = (FONScontext*)up;
+	FONSscratch* scratch = (FONSscratch*)up;
 
 	// 16-byte align the returned pointer
 	size = (size + 0xf) & ~0xf;
 
-	if (stash->nscratch+(int)size > FONS_SCRATCH_BUF_SIZE) {
-		if (stash->handleError)
-			stash->handleError(stash->errorUptr, FONS_SCRATCH_FULL, stash->nscratch+(int)size);
+	if (scratch->n+(int)size > FONS_SCRATCH_BUF_SIZE) {
+		if (scratch->stash != NULL && scratch->stash->handleError)
+			scratch->stash->handleError(scratch->stash->errorUptr, FONS_SCRATCH_FULL, scratch->n+(int)size);
 		return NULL;
 	}
-	ptr = stash->scratch + stash->nscratch;
-	stash->nscratch += (int)size;
+	ptr = scratch->data + scratch->n;
+	scratch->n += (int)size;
 	return ptr;
 }
 
@@ -734,6 +916,23 @@ static void fons__addWhiteRect(FONScontext* stash, int w, int h)
 	stash->dirtyRect[3] = fons__maxi(stash->dirtyRect[3], gy+h);
 }
 
+// Starts a new page below the others, the free space left on the last page is not used anymore.
+static int fons__addPage(FONScontext* stash)
+{
+	int pageSize = stash->params.width * stash->params.height;
+	unsigned char* data;
+
+	if (stash->npages >= stash->maxPages) return 0;
+	data = (unsigned char*)realloc(stash->texData, pageSize * (stash->npages+1));
+	if (data == NULL) return 0;
+	memset(&data[pageSize * stash->npages], 0, pageSize);
+	stash->texData = data;
+	stash->npages++;
+	fons__atlasReset(stash->atlas, stash->params.width, stash->params.height);
+
+	return 1;
+}
+
 FONScontext* fonsCreateInternal(FONSparams* params)
 {
 	FONScontext* stash = NULL;
@@ -744,10 +943,26 @@ FONScontext* fonsCreateInternal(FONSparams* params)
 	memset(stash, 0, sizeof(FONScontext));
 
 	stash->params = *params;
+#ifdef FONS_USE_FREETYPE
+	stash->params.flags &= ~FONS_SDF;
+#endif
+
+#ifndef FONS_NO_THREADS
+#ifdef _WIN32
+	InitializeCriticalSection(&stash->lock);
+	InitializeConditionVariable(&stash->start);
+	InitializeConditionVariable(&stash->done);
+#else
+	pthread_mutex_init(&stash->lock, NULL);
+	pthread_cond_init(&stash->start, NULL);
+	pthread_cond_init(&stash->done, NULL);
+#endif
+#endif
 
 	// Allocate scratch buffer.
-	stash->scratch = (unsigned char*)malloc(FONS_SCRATCH_BUF_SIZE);
-	if (stash->scratch == NULL) goto error;
+	stash->scratch.stash = stash;
+	stash->scratch.data = (unsigned char*)malloc(FONS_SCRATCH_BUF_SIZE);
+	if (stash->scratch.data == NULL) goto error;
 
 	// Initialize implementation library
 	if (!fons__tt_init(stash)) goto error;
@@ -759,6 +974,8 @@ FONScontext* fonsCreateInternal(FONSparams* params)
 
 	stash->atlas = fons__allocAtlas(stash->params.width, stash->params.height, FONS_INIT_ATLAS_NODES);
 	if (stash->atlas == NULL) goto error;
+	stash->npages = 1;
+	stash->maxPages = 1;
 
 	// Allocate space for fonts.
 	stash->fonts = (FONSfont**)malloc(sizeof(FONSfont*) * FONS_INIT_FONTS);
@@ -973,7 +1190,7 @@ int fonsAddFontMem(FONScontext* stash, const char* name, unsigned char* data, in
 	font->freeData = (unsigned char)freeData;
 
 	// Init font
-	stash->nscratch = 0;
+	stash->scratch.n = 0;
 	if (!fons__tt_loadFont(stash, &font->font, data, dataSize, fontIndex)) goto error;
 
 	// Store normalized line height. The real line height is got
@@ -984,6 +1201,8 @@ int fonsAddFontMem(FONScontext* stash, const char* name, unsigned char* data, in
 	font->ascender = (float)ascent / (float)fh;
 	font->descender = (float)descent / (float)fh;
 	font->lineh = font->ascender - font->descender;
+	// Per pixel of font size like the line height.
+	font->maxAdvance = fons__tt_getMaxAdvance(&font->font) * fons__tt_getPixelHeightScale(&font->font, 1.0f);
 
 	return idx;
 
@@ -1137,11 +1356,12 @@ static void fons__maxDiagUp(unsigned char* dst, int w, int h, int dstStride)
 {
 	int t, y;
 	const int a =dstStride-1;
-	const int d=w+h;
+	// Diagonal t visits x = t-y, kept within the w*h rectangle.
+	const int d=w+h-1;
 	unsigned char prev, current;
 	unsigned char* ptr;
 	for(t=0;t<d;t++){
-		const int y_min=(t-w<0)?0:t-w;
+		const int y_min=(t-w+1<0)?0:t-w+1;
 		const int y_max=(t<h-1)?t:h-1;
 		prev=dst[t+y_min*a];
 		for(y=y_min;y<=y_max;y++){
@@ -1168,11 +1388,11 @@ static void fons__maxDiagDown(unsigned char* dst, int w, int h, int dstStride)
 	int t, y;
 	const int a=(h-1)*dstStride;
 	const int b=dstStride+1;
-	const int d=w+h;
+	const int d=w+h-1;
 	unsigned char prev, current;
 	unsigned char* ptr;
 	for(t=0;t<d;t++){
-		const int y_min=(t-w<0)?0:t-w;
+		const int y_min=(t-w+1<0)?0:t-w+1;
 		const int y_max=(t<h-1)?t:h-1;
 		prev=dst[t-y_min*b+a];
 		for(y=y_min;y<=y_max;y++){
@@ -1212,27 +1432,259 @@ static void fons__dilate(FONScontext* stash, unsigned char* dst, int w, int h, i
 	}
 }
 
+// Renders a glyph with an empty border of one pixel into a zeroed gw*gh region of dst.
+static void fons__rasterGlyph(FONScontext* stash, FONSttFontImpl* font, FONSscratch* scratch, unsigned char* dst, int dstStride,
+							  int gw, int gh, int pad, float scale, int g, int iblur, int idilate)
+{
+	int x, y;
+
+	// Reset allocator.
+	scratch->n = 0;
+	if (stash->params.flags & FONS_SDF)
+		fons__tt_renderGlyphSDF(font, &dst[1 + dstStride], gw-2, gh-2, dstStride, scale, pad-1, g);
+	else
+		fons__tt_renderGlyphBitmap(font, &dst[pad + pad*dstStride], gw-pad*2,gh-pad*2, dstStride, scale, scale, g);
+
+	// Make sure there is one pixel empty border.
+	for (y = 0; y < gh; y++) {
+		dst[y*dstStride] = 0;
+		dst[gw-1 + y*dstStride] = 0;
+	}
+	for (x = 0; x < gw; x++) {
+		dst[x] = 0;
+		dst[x + (gh-1)*dstStride] = 0;
+	}
+
+	// Debug code to color the glyph background
+/*	for (y = 0; y < gh; y++) {
+		for (x = 0; x < gw; x++) {
+			int a = (int)dst[x+y*dstStride] + 20;
+			if (a > 255) a = 255;
+			dst[x+y*dstStride] = a;
+		}
+	}*/
+
+	// Dilate
+	if (idilate > 0)
+		fons__dilate(stash, dst, gw, gh, dstStride, idilate);
+
+	// Blur
+	if (iblur > 0)
+		fons__blur(stash, dst, gw, gh, dstStride, iblur);
+}
+
+static void fons__dirtyGlyph(FONScontext* stash, FONSglyph* glyph)
+{
+	stash->dirtyRect[0] = fons__mini(stash->dirtyRect[0], glyph->x0);
+	stash->dirtyRect[1] = fons__mini(stash->dirtyRect[1], glyph->y0 + glyph->page * stash->params.height);
+	stash->dirtyRect[2] = fons__maxi(stash->dirtyRect[2], glyph->x1);
+	stash->dirtyRect[3] = fons__maxi(stash->dirtyRect[3], glyph->y1 + glyph->page * stash->params.height);
+}
+
+#ifndef FONS_NO_THREADS
+
+//
+// Raster threads
+//
+// Missing glyphs get their metrics and atlas spot on the calling thread and are queued. The threads
+// take the jobs in order and rasterize them into their own bitmaps, which are copied to the atlas
+// by fonsCommitGlyphs() on the calling thread.
+
+#ifdef _WIN32
+static void fons__lock(FONScontext* stash) { EnterCriticalSection(&stash->lock); }
+static void fons__unlock(FONScontext* stash) { LeaveCriticalSection(&stash->lock); }
+static void fons__wait(FONScontext* stash, CONDITION_VARIABLE* cond) { SleepConditionVariableCS(cond, &stash->lock, INFINITE); }
+static void fons__signal(CONDITION_VARIABLE* cond) { WakeConditionVariable(cond); }
+static void fons__broadcast(CONDITION_VARIABLE* cond) { WakeAllConditionVariable(cond); }
+#else
+static void fons__lock(FONScontext* stash) { pthread_mutex_lock(&stash->lock); }
+static void fons__unlock(FONScontext* stash) { pthread_mutex_unlock(&stash->lock); }
+static void fons__wait(FONScontext* stash, pthread_cond_t* cond) { pthread_cond_wait(cond, &stash->lock); }
+static void fons__signal(pthread_cond_t* cond) { pthread_cond_signal(cond); }
+static void fons__broadcast(pthread_cond_t* cond) { pthread_cond_broadcast(cond); }
+#endif
+
+// Takes the next queued job, called with the lock held.
+static FONSjob* fons__takeJob(FONScontext* stash)
+{
+	if (stash->nextJob >= stash->njobs) return NULL;
+	return stash->jobs[stash->nextJob++];
+}
+
+static void fons__runJob(FONScontext* stash, FONSjob* job, FONSscratch* scratch)
+{
+	// The copy of the font allocates from the scratch buffer of the thread.
+	FONSttFontImpl font = *job->renderFont;
+	font.font.userdata = scratch;
+	memset(job->bitmap, 0, job->gw * job->gh);
+	fons__rasterGlyph(stash, &font, scratch, job->bitmap, job->gw, job->gw, job->gh, job->pad, job->scale, job->index, job->blur, job->dilate);
+}
+
+#ifdef _WIN32
+static DWORD WINAPI fons__workerThread(LPVOID arg)
+#else
+static void* fons__workerThread(void* arg)
+#endif
+{
+	FONSworker* w = (FONSworker*)arg;
+	FONScontext* stash = w->stash;
+	FONSjob* job = NULL;
+
+	fons__lock(stash);
+	for (;;) {
+		while (!stash->quit && (job = fons__takeJob(stash)) == NULL)
+			fons__wait(stash, &stash->start);
+		if (stash->quit)
+			break;
+		fons__unlock(stash);
+
+		fons__runJob(stash, job, &w->scratch);
+
+		fons__lock(stash);
+		job->done = 1;
+		fons__broadcast(&stash->done);
+	}
+	fons__unlock(stash);
+
+	return 0;
+}
+
+static int fons__startThread(FONSworker* w)
+{
+#ifdef _WIN32
+	w->thread = CreateThread(NULL, 0, fons__workerThread, w, 0, NULL);
+	return w->thread != NULL;
+#else
+	return pthread_create(&w->thread, NULL, fons__workerThread, w) == 0;
+#endif
+}
+
+static void fons__joinThread(FONSworker* w)
+{
+#ifdef _WIN32
+	WaitForSingleObject(w->thread, INFINITE);
+	CloseHandle(w->thread);
+#else
+	pthread_join(w->thread, NULL);
+#endif
+}
+
+static void fons__stopWorkers(FONScontext* stash)
+{
+	int i;
+	if (stash->workers == NULL) return;
+	fons__lock(stash);
+	stash->quit = 1;
+	fons__broadcast(&stash->start);
+	fons__unlock(stash);
+	for (i = 0; i < stash->nworkers; i++) {
+		fons__joinThread(&stash->workers[i]);
+		free(stash->workers[i].scratch.data);
+	}
+	free(stash->workers);
+	stash->workers = NULL;
+	stash->nworkers = 0;
+	stash->quit = 0;
+}
+
+static int fons__cpuCount(void)
+{
+#ifdef _WIN32
+	SYSTEM_INFO info;
+	GetSystemInfo(&info);
+	return (int)info.dwNumberOfProcessors;
+#else
+	return (int)sysconf(_SC_NPROCESSORS_ONLN);
+#endif
+}
+
+// Queues the glyph for the raster threads, returns 0 when it is to be rasterized right away.
+static int fons__queueGlyph(FONScontext* stash, FONSfont* font, FONSglyph* glyph, FONSfont* renderFont,
+							float scale, int pad, int iblur, int idilate)
+{
+	int gw = glyph->x1 - glyph->x0, gh = glyph->y1 - glyph->y0;
+	FONSjob* job;
+
+	if (stash->nworkers == 0) return 0;
+
+	if (stash->njobs+1 > stash->cjobs) {
+		int cjobs = stash->cjobs == 0 ? 64 : stash->cjobs * 2;
+		FONSjob** jobs;
+		fons__lock(stash);
+		jobs = (FONSjob**)realloc(stash->jobs, sizeof(FONSjob*) * cjobs);
+		if (jobs != NULL) {
+			stash->jobs = jobs;
+			stash->cjobs = cjobs;
+		}
+		fons__unlock(stash);
+		if (jobs == NULL) return 0;
+	}
+	job = (FONSjob*)malloc(sizeof(FONSjob) + gw*gh);
+	if (job == NULL) return 0;
+	job->font = font;
+	job->glyph = (int)(glyph - font->glyphs);
+	job->renderFont = &renderFont->font;
+	job->index = glyph->index;
+	job->gw = gw;
+	job->gh = gh;
+	job->pad = pad;
+	job->blur = iblur;
+	job->dilate = idilate;
+	job->scale = scale;
+	job->done = 0;
+	job->bitmap = (unsigned char*)(job + 1);
+	glyph->pending = 1;
+
+	fons__lock(stash);
+	stash->jobs[stash->njobs++] = job;
+	fons__signal(&stash->start);
+	fons__unlock(stash);
+
+	return 1;
+}
+
+static int fons__jobsDone(FONScontext* stash)
+{
+	int i;
+	for (i = 0; i < stash->njobs; i++) {
+		if (!stash->jobs[i]->done) return 0;
+	}
+	return 1;
+}
+
+#endif // FONS_NO_THREADS
+
 static FONSglyph* fons__getGlyph(FONScontext* stash, FONSfont* font, unsigned int codepoint,
 								 short isize, short iblur, short idilate, int bitmapOption)
 {
-	int i, g, advance, lsb, x0, y0, x1, y1, gw, gh, gx, gy, x, y;
+	int i, g, advance, lsb, x0, y0, x1, y1, gw, gh, gx, gy;
 	float scale;
 	FONSglyph* glyph = NULL;
 	unsigned int h;
-	float size = isize/10.0f;
+	float size;
 	int pad, added;
-	unsigned char* bdst;
-	unsigned char* dst;
+	unsigned char* pageData;
 	FONSfont* renderFont = font;
+#ifdef FONS_STATS
+	double startTime;
+#endif
 
 	if (isize < 2) return NULL;
 	if (iblur > 20) iblur = 20;
 	if (idilate > 20) idilate = 20;
 	const int antiAliasBonus = 2;
 	pad = antiAliasBonus + iblur + idilate;
+	if (stash->params.flags & FONS_SDF) {
+		// One distance field serves all sizes, the field reaches into the padding.
+		isize = FONS_SDF_SIZE*10;
+		iblur = 0;
+		idilate = 0;
+		pad = FONS_SDF_PADDING + 1;
+	}
+	size = isize/10.0f;
 
 	// Reset allocator.
-	stash->nscratch = 0;
+	stash->scratch.n = 0;
 
 	// Find code point and size.
 	h = fons__hashint(codepoint) & (FONS_HASH_LUT_SIZE-1);
@@ -1242,7 +1694,11 @@ static FONSglyph* fons__getGlyph(FONScontext* stash, FONSfont* font, unsigned in
 				&& font->glyphs[i].blur == iblur
 				&& font->glyphs[i].dilate == idilate) {
 			glyph = &font->glyphs[i];
+			glyph->lastUsed = ++stash->tick;
 			if (bitmapOption == FONS_GLYPH_BITMAP_OPTIONAL || (glyph->x0 >= 0 && glyph->y0 >= 0)) {
+#ifdef FONS_STATS
+			  stash->nhits++;
+#endif
 			  return glyph;
 			}
 			// At this point, glyph exists but the bitmap data is not yet created.
@@ -1251,6 +1707,11 @@ static FONSglyph* fons__getGlyph(FONScontext* stash, FONSfont* font, unsigned in
 		i = font->glyphs[i].next;
 	}
 
+#ifdef FONS_STATS
+	stash->nmisses++;
+	startTime = FONS_CLOCK();
+#endif
+
 	// Create a new glyph or rasterize bitmap data for a cached glyph.
 	g = fons__tt_getGlyphIndex(&font->font, codepoint);
 	// Try to find the glyph in fallback fonts.
@@ -1276,6 +1737,8 @@ static FONSglyph* fons__getGlyph(FONScontext* stash, FONSfont* font, unsigned in
 	if (bitmapOption == FONS_GLYPH_BITMAP_REQUIRED) {
 		// Find free spot for the rect in the atlas
 		added = fons__atlasAddRect(stash->atlas, gw, gh, &gx, &gy);
+		if (added == 0 && fons__addPage(stash))
+			added = fons__atlasAddRect(stash->atlas, gw, gh, &gx, &gy);
 		if (added == 0 && stash->handleError != NULL) {
 			// Atlas is full, let the user to resize the atlas (or not), and try again.
 			stash->handleError(stash->errorUptr, FONS_ATLAS_FULL, 0);
@@ -1292,6 +1755,7 @@ static FONSglyph* fons__getGlyph(FONScontext* stash, FONSfont* font, unsigned in
 	if (glyph == NULL) {
 		glyph = fons__allocGlyph(font);
 		glyph->codepoint = codepoint;
+		glyph->lastUsed = ++stash->tick;
 		glyph->size = isize;
 		glyph->blur = iblur;
 		glyph->dilate = idilate;
@@ -1302,6 +1766,8 @@ static FONSglyph* fons__getGlyph(FONScontext* stash, FONSfont* font, unsigned in
 		font->lut[h] = font->nglyphs-1;
 	}
 	glyph->index = g;
+	glyph->page = (short)(stash->npages-1);
+	glyph->pending = 0;
 	glyph->x0 = (short)gx;
 	glyph->y0 = (short)gy;
 	glyph->x1 = (short)(glyph->x0+gw);
@@ -1311,58 +1777,55 @@ static FONSglyph* fons__getGlyph(FONScontext* stash, FONSfont* font, unsigned in
 	glyph->yoff = (short)(y0 - pad);
 
 	if (bitmapOption == FONS_GLYPH_BITMAP_OPTIONAL) {
+#ifdef FONS_STATS
+		stash->rasterTime += FONS_CLOCK() - startTime;
+#endif
 		return glyph;
 	}
 
-	// Rasterize
-	dst = &stash->texData[(glyph->x0+pad) + (glyph->y0+pad) * stash->params.width];
-	fons__tt_renderGlyphBitmap(&renderFont->font, dst, gw-pad*2,gh-pad*2, stash->params.width, scale, scale, g);
-
-	// Make sure there is one pixel empty border.
-	dst = &stash->texData[glyph->x0 + glyph->y0 * stash->params.width];
-	for (y = 0; y < gh; y++) {
-		dst[y*stash->params.width] = 0;
-		dst[gw-1 + y*stash->params.width] = 0;
-	}
-	for (x = 0; x < gw; x++) {
-		dst[x] = 0;
-		dst[x + (gh-1)*stash->params.width] = 0;
-	}
-
-	// Debug code to color the glyph background
-/*	unsigned char* fdst = &stash->texData[glyph->x0 + glyph->y0 * stash->params.width];
-	for (y = 0; y < gh; y++) {
-		for (x = 0; x < gw; x++) {
-			int a = (int)fdst[x+y*stash->params.width] + 20;
-			if (a > 255) a = 255;
-			fdst[x+y*stash->params.width] = a;
-		}
-	}*/
-
-	// Dilate
-	if (idilate > 0) {
-		stash->nscratch = 0;
-		bdst = &stash->texData[glyph->x0 + glyph->y0 * stash->params.width];
-		fons__dilate(stash, bdst, gw, gh, stash->params.width, idilate);
+#ifndef FONS_NO_THREADS
+	if (fons__queueGlyph(stash, font, glyph, renderFont, scale, pad, iblur, idilate)) {
+#ifdef FONS_STATS
+		stash->rasterTime += FONS_CLOCK() - startTime;
+#endif
+		return glyph;
 	}
+#endif
 
-	// Blur
-	if (iblur > 0) {
-		stash->nscratch = 0;
-		bdst = &stash->texData[glyph->x0 + glyph->y0 * stash->params.width];
-		fons__blur(stash, bdst, gw, gh, stash->params.width, iblur);
-	}
+	// Rasterize
+	pageData = &stash->texData[glyph->page * stash->params.width * stash->params.height];
+	fons__rasterGlyph(stash, &renderFont->font, &stash->scratch, &pageData[glyph->x0 + glyph->y0 * stash->params.width], stash->params.width,
+					  gw, gh, pad, scale, g, iblur, idilate);
+	fons__dirtyGlyph(stash, glyph);
 
-	stash->dirtyRect[0] = fons__mini(stash->dirtyRect[0], glyph->x0);
-	stash->dirtyRect[1] = fons__mini(stash->dirtyRect[1], glyph->y0);
-	stash->dirtyRect[2] = fons__maxi(stash->dirtyRect[2], glyph->x1);
-	stash->dirtyRect[3] = fons__maxi(stash->dirtyRect[3], glyph->y1);
+#ifdef FONS_STATS
+	stash->rasterTime += FONS_CLOCK() - startTime;
+#endif
 
 	return glyph;
 }
 
+// Sets the quad of a cached glyph drawn k times its size at the pen position.
+static void fons__getScaledQuad(FONScontext* stash, FONSglyph* glyph, float k, float x, float y, FONSquad* q)
+{
+	q->x0 = x + (glyph->xoff+1) * k;
+	q->x1 = q->x0 + (glyph->x1 - glyph->x0 - 2) * k;
+	if (stash->params.flags & FONS_ZERO_TOPLEFT) {
+		q->y0 = y + (glyph->yoff+1) * k;
+		q->y1 = q->y0 + (glyph->y1 - glyph->y0 - 2) * k;
+	} else {
+		q->y0 = y - (glyph->yoff+1) * k;
+		q->y1 = q->y0 - (glyph->y1 - glyph->y0 - 2) * k;
+	}
+	q->s0 = (glyph->x0+1) * stash->itw;
+	q->t0 = (glyph->y0+1) * stash->ith;
+	q->s1 = (glyph->x1-1) * stash->itw;
+	q->t1 = (glyph->y1-1) * stash->ith;
+	q->page = glyph->page;
+}
+
 static void fons__getQuad(FONScontext* stash, FONSfont* font,
-						   int prevGlyphIndex, FONSglyph* glyph,
+						   int prevGlyphIndex, FONSglyph* glyph, short isize,
 						   float scale, float spacing, float* x, float* y, FONSquad* q)
 {
 	float rx,ry,xoff,yoff,x0,y0,x1,y1;
@@ -1372,6 +1835,14 @@ static void fons__getQuad(FONScontext* stash, FONSfont* font,
 		*x += (int)(adv + spacing + 0.5f);
 	}
 
+	if (glyph->size != isize) {
+		// Distance field glyphs are cached in one size.
+		float k = (float)isize / (float)glyph->size;
+		fons__getScaledQuad(stash, glyph, k, *x, *y, q);
+		*x += (int)(glyph->xadv * k / 10.0f + 0.5f);
+		return;
+	}
+
 	// Each glyph has 2px border to allow good interpolation,
 	// one pixel to prevent leaking, and one to allow good interpolation for rendering.
 	// Inset the texture region by one pixel for correct interpolation.
@@ -1381,6 +1852,7 @@ static void fons__getQuad(FONScontext* stash, FONSfont* font,
 	y0 = (float)(glyph->y0+1);
 	x1 = (float)(glyph->x1-1);
 	y1 = (float)(glyph->y1-1);
+	q->page = glyph->page;
 
 	if (stash->params.flags & FONS_ZERO_TOPLEFT) {
 		rx = floorf(*x + xoff);
@@ -1413,15 +1885,64 @@ static void fons__getQuad(FONScontext* stash, FONSfont* font,
 	*x += (int)(glyph->xadv / 10.0f + 0.5f);
 }
 
+static int fons__absi(int a)
+{
+	return a < 0 ? -a : a;
+}
+
+// Returns the glyph in the closest other size with a bitmap in the atlas, or NULL.
+static FONSglyph* fons__findCachedSize(FONSfont* font, FONSglyph* glyph)
+{
+	FONSglyph* best = NULL;
+	int i = font->lut[fons__hashint(glyph->codepoint) & (FONS_HASH_LUT_SIZE-1)];
+	while (i != -1) {
+		FONSglyph* other = &font->glyphs[i];
+		if (other->codepoint == glyph->codepoint && other->blur == glyph->blur && other->dilate == glyph->dilate
+				&& !other->pending && other->x0 >= 0 && other->y0 >= 0
+				&& (best == NULL || fons__absi(other->size - glyph->size) < fons__absi(best->size - glyph->size)))
+			best = other;
+		i = other->next;
+	}
+	return best;
+}
+
+// Like fons__getQuad(), but the glyphs queued for the raster threads are drawn as the raster policy says.
+// An empty quad leaves the glyph out.
+static void fons__getDrawQuad(FONScontext* stash, FONSfont* font,
+							  int prevGlyphIndex, FONSglyph* glyph, short isize,
+							  float scale, float spacing, float* x, float* y, FONSquad* q)
+{
+	FONSglyph* cached = NULL;
+
+	fons__getQuad(stash, font, prevGlyphIndex, glyph, isize, scale, spacing, x, y, q);
+	if (!glyph->pending || stash->rasterPolicy == FONS_RASTER_BLOCK)
+		return;
+
+	if (stash->rasterPolicy == FONS_RASTER_FALLBACK)
+		cached = fons__findCachedSize(font, glyph);
+	if (cached != NULL) {
+		// Scale the cached size around the pen position.
+		float penx = *x - (int)(glyph->xadv / 10.0f + 0.5f);
+		fons__getScaledQuad(stash, cached, (float)glyph->size / (float)cached->size, penx, *y, q);
+	} else {
+		q->x1 = q->x0;
+		q->y1 = q->y0;
+	}
+}
+
 static void fons__flush(FONScontext* stash)
 {
+	// The triangles may use queued glyphs.
+	if (stash->rasterPolicy == FONS_RASTER_BLOCK)
+		fonsCommitGlyphs(stash, 1);
+
 	// Flush texture
 	if (stash->dirtyRect[0] < stash->dirtyRect[2] && stash->dirtyRect[1] < stash->dirtyRect[3]) {
 		if (stash->params.renderUpdate != NULL)
 			stash->params.renderUpdate(stash->params.userPtr, stash->dirtyRect, stash->texData);
 		// Reset dirty rect
 		stash->dirtyRect[0] = stash->params.width;
-		stash->dirtyRect[1] = stash->params.height;
+		stash->dirtyRect[1] = stash->params.height * stash->maxPages;
 		stash->dirtyRect[2] = 0;
 		stash->dirtyRect[3] = 0;
 	}
@@ -1519,7 +2040,11 @@ float fonsDrawText(FONScontext* stash,
 			continue;
 		glyph = fons__getGlyph(stash, font, codepoint, isize, iblur, idilate, FONS_GLYPH_BITMAP_REQUIRED);
 		if (glyph != NULL) {
-			fons__getQuad(stash, font, prevGlyphIndex, glyph, scale, state->spacing, &x, &y, &q);
+			fons__getDrawQuad(stash, font, prevGlyphIndex, glyph, isize, scale, state->spacing, &x, &y, &q);
+			if (q.x0 == q.x1) {
+				prevGlyphIndex = glyph->index;
+				continue;
+			}
 
 			if (stash->nverts+6 > FONS_VERTEX_COUNT)
 				fons__flush(stash);
@@ -1604,9 +2129,13 @@ int fonsTextIterNext(FONScontext* stash, FONStextIter* iter, FONSquad* quad)
 		iter->y = iter->nexty;
 		glyph = fons__getGlyph(stash, iter->font, iter->codepoint, iter->isize, iter->iblur, iter->idilate, iter->bitmapOption);
 		// If the iterator was initialized with FONS_GLYPH_BITMAP_OPTIONAL, then the UV coordinates of the quad will be invalid.
-		if (glyph != NULL)
-			fons__getQuad(stash, iter->font, iter->prevGlyphIndex, glyph, iter->scale, iter->spacing, &iter->nextx, &iter->nexty, quad);
+		// Otherwise glyphs still being rasterized may be returned as empty quads, see fonsSetRasterThreads().
+		if (glyph != NULL && iter->bitmapOption == FONS_GLYPH_BITMAP_REQUIRED)
+			fons__getDrawQuad(stash, iter->font, iter->prevGlyphIndex, glyph, iter->isize, iter->scale, iter->spacing, &iter->nextx, &iter->nexty, quad);
+		else if (glyph != NULL)
+			fons__getQuad(stash, iter->font, iter->prevGlyphIndex, glyph, iter->isize, iter->scale, iter->spacing, &iter->nextx, &iter->nexty, quad);
 		iter->prevGlyphIndex = glyph != NULL ? glyph->index : -1;
+		iter->glyph = glyph != NULL ? (int)(glyph - iter->font->glyphs) : -1;
 		break;
 	}
 	iter->next = str;
@@ -1703,7 +2232,7 @@ float fonsTextBounds(FONScontext* stash,
 			continue;
 		glyph = fons__getGlyph(stash, font, codepoint, isize, iblur, idilate, FONS_GLYPH_BITMAP_OPTIONAL);
 		if (glyph != NULL) {
-			fons__getQuad(stash, font, prevGlyphIndex, glyph, scale, state->spacing, &x, &y, &q);
+			fons__getQuad(stash, font, prevGlyphIndex, glyph, isize, scale, state->spacing, &x, &y, &q);
 			if (q.x0 < minx) minx = q.x0;
 			if (q.x1 > maxx) maxx = q.x1;
 			if (stash->params.flags & FONS_ZERO_TOPLEFT) {
@@ -1761,6 +2290,29 @@ void fonsVertMetrics(FONScontext* stash,
 		*lineh = font->lineh*isize/10.0f;
 }
 
+float fonsMaxAdvance(FONScontext* stash)
+{
+	FONSfont* font;
+	FONSstate* state = fons__getState(stash);
+	short isize;
+	float maxAdvance;
+	int i;
+
+	if (stash == NULL) return 0;
+	if (state->font < 0 || state->font >= stash->nfonts) return 0;
+	font = stash->fonts[state->font];
+	isize = (short)(state->size*10.0f);
+	if (font->data == NULL) return 0;
+
+	maxAdvance = font->maxAdvance;
+	for (i = 0; i < font->nfallbacks; i++) {
+		FONSfont* fallback = stash->fonts[font->fallbacks[i]];
+		if (fallback->maxAdvance > maxAdvance)
+			maxAdvance = fallback->maxAdvance;
+	}
+	return maxAdvance*isize/10.0f;
+}
+
 void fonsLineBounds(FONScontext* stash, float y, float* miny, float* maxy)
 {
 	FONSfont* font;
@@ -1789,10 +2341,17 @@ const unsigned char* fonsGetTextureData(FONScontext* stash, int* width, int* hei
 	if (width != NULL)
 		*width = stash->params.width;
 	if (height != NULL)
-		*height = stash->params.height;
+		*height = stash->params.height * stash->npages;
 	return stash->texData;
 }
 
+void fonsTouchGlyph(FONScontext* stash, int font, int glyph)
+{
+	if (font < 0 || font >= stash->nfonts) return;
+	if (glyph < 0 || glyph >= stash->fonts[font]->nglyphs) return;
+	stash->fonts[font]->glyphs[glyph].lastUsed = ++stash->tick;
+}
+
 int fonsValidateTexture(FONScontext* stash, int* dirty)
 {
 	if (stash->dirtyRect[0] < stash->dirtyRect[2] && stash->dirtyRect[1] < stash->dirtyRect[3]) {
@@ -1802,7 +2361,7 @@ int fonsValidateTexture(FONScontext* stash, int* dirty)
 		dirty[3] = stash->dirtyRect[3];
 		// Reset dirty rect
 		stash->dirtyRect[0] = stash->params.width;
-		stash->dirtyRect[1] = stash->params.height;
+		stash->dirtyRect[1] = stash->params.height * stash->maxPages;
 		stash->dirtyRect[2] = 0;
 		stash->dirtyRect[3] = 0;
 		return 1;
@@ -1810,6 +2369,23 @@ int fonsValidateTexture(FONScontext* stash, int* dirty)
 	return 0;
 }
 
+void fonsGetStats(FONScontext* stash, int* hits, int* misses, double* rasterTime)
+{
+#ifdef FONS_STATS
+	if (hits) *hits = stash->nhits;
+	if (misses) *misses = stash->nmisses;
+	if (rasterTime) *rasterTime = stash->rasterTime;
+	stash->nhits = 0;
+	stash->nmisses = 0;
+	stash->rasterTime = 0;
+#else
+	FONS_NOTUSED(stash);
+	if (hits) *hits = 0;
+	if (misses) *misses = 0;
+	if (rasterTime) *rasterTime = 0;
+#endif
+}
+
 void fonsDeleteInternal(FONScontext* stash)
 {
 	int i;
@@ -1818,13 +2394,27 @@ void fonsDeleteInternal(FONScontext* stash)
 	if (stash->params.renderDelete)
 		stash->params.renderDelete(stash->params.userPtr);
 
+#ifndef FONS_NO_THREADS
+	fons__stopWorkers(stash);
+	for (i = 0; i < stash->njobs; i++)
+		free(stash->jobs[i]);
+	if (stash->jobs) free(stash->jobs);
+#ifdef _WIN32
+	DeleteCriticalSection(&stash->lock);
+#else
+	pthread_mutex_destroy(&stash->lock);
+	pthread_cond_destroy(&stash->start);
+	pthread_cond_destroy(&stash->done);
+#endif
+#endif
+
 	for (i = 0; i < stash->nfonts; ++i)
 		fons__freeFont(stash->fonts[i]);
 
 	if (stash->atlas) fons__deleteAtlas(stash->atlas);
 	if (stash->fonts) free(stash->fonts);
 	if (stash->texData) free(stash->texData);
-	if (stash->scratch) free(stash->scratch);
+	if (stash->scratch.data) free(stash->scratch.data);
 	fons__tt_done(stash);
 	free(stash);
 }
@@ -1843,12 +2433,115 @@ void fonsGetAtlasSize(FONScontext* stash, int* width, int* height)
 	*height = stash->params.height;
 }
 
+void fonsSetMaxPages(FONScontext* stash, int maxPages)
+{
+	if (stash == NULL) return;
+	stash->maxPages = fons__maxi(maxPages, 1);
+}
+
+int fonsGetAtlasPages(FONScontext* stash)
+{
+	if (stash == NULL) return 0;
+	return stash->npages;
+}
+
+int fonsSetRasterThreads(FONScontext* stash, int count, int policy)
+{
+	if (stash == NULL) return 0;
+	stash->rasterPolicy = policy;
+#ifdef FONS_NO_THREADS
+	FONS_NOTUSED(count);
+	return 0;
+#else
+	if (count < 0)
+		count = fons__cpuCount();
+	count = fons__mini(count, FONS_MAX_RASTER_THREADS);
+	if (count == stash->nworkers)
+		return count;
+
+	fonsCommitGlyphs(stash, 1);
+	fons__stopWorkers(stash);
+	if (count == 0)
+		return 0;
+
+	stash->workers = (FONSworker*)malloc(sizeof(FONSworker) * count);
+	if (stash->workers == NULL) return 0;
+	memset(stash->workers, 0, sizeof(FONSworker) * count);
+	while (stash->nworkers < count) {
+		FONSworker* w = &stash->workers[stash->nworkers];
+		w->stash = stash;
+		w->scratch.data = (unsigned char*)malloc(FONS_SCRATCH_BUF_SIZE);
+		if (w->scratch.data == NULL || !fons__startThread(w)) {
+			free(w->scratch.data);
+			break;
+		}
+		stash->nworkers++;
+	}
+	if (stash->nworkers == 0) {
+		free(stash->workers);
+		stash->workers = NULL;
+	}
+	return stash->nworkers;
+#endif
+}
+
+int fonsCommitGlyphs(FONScontext* stash, int wait)
+{
+#ifdef FONS_NO_THREADS
+	FONS_NOTUSED(stash);
+	FONS_NOTUSED(wait);
+	return 0;
+#else
+	FONSjob* job;
+	int i, y, n;
+
+	if (stash == NULL || stash->njobs == 0) return 0;
+
+	fons__lock(stash);
+	if (wait) {
+		// Help with the queued glyphs, then wait for the running ones.
+		while ((job = fons__takeJob(stash)) != NULL) {
+			fons__unlock(stash);
+			fons__runJob(stash, job, &stash->scratch);
+			fons__lock(stash);
+			job->done = 1;
+		}
+		while (!fons__jobsDone(stash))
+			fons__wait(stash, &stash->done);
+	}
+
+	// Copy the finished bitmaps to their spots, the jobs are taken in order so all of them are before nextJob.
+	for (i = n = 0; i < stash->njobs; i++) {
+		job = stash->jobs[i];
+		if (job->done) {
+			FONSglyph* glyph = &job->font->glyphs[job->glyph];
+			unsigned char* dst = &stash->texData[glyph->x0 + (glyph->page * stash->params.height + glyph->y0) * stash->params.width];
+			for (y = 0; y < job->gh; y++)
+				memcpy(&dst[y * stash->params.width], &job->bitmap[y * job->gw], job->gw);
+			glyph->pending = 0;
+			fons__dirtyGlyph(stash, glyph);
+			free(job);
+			stash->nextJob--;
+		} else {
+			stash->jobs[n++] = job;
+		}
+	}
+	stash->njobs = n;
+	fons__unlock(stash);
+
+	return n;
+#endif
+}
+
 int fonsExpandAtlas(FONScontext* stash, int width, int height)
 {
 	int i, maxy = 0;
 	unsigned char* data = NULL;
 	if (stash == NULL) return 0;
 
+	// The pages below the first are not moved.
+	if (stash->npages > 1) return 0;
+
 	width = fons__maxi(width, stash->params.width);
 	height = fons__maxi(height, stash->params.height);
 
@@ -1856,6 +2549,7 @@ int fonsExpandAtlas(FONScontext* stash, int width, int height)
 		return 1;
 
 	// Flush pending glyphs.
+	fonsCommitGlyphs(stash, 1);
 	fons__flush(stash);
 
 	// Create new texture
@@ -1905,6 +2599,7 @@ int fonsResetAtlas(FONScontext* stash, int width, int height)
 	if (stash == NULL) return 0;
 
 	// Flush pending glyphs.
+	fonsCommitGlyphs(stash, 1);
 	fons__flush(stash);
 
 	// Create new texture
@@ -1920,6 +2615,7 @@ int fonsResetAtlas(FONScontext* stash, int width, int height)
 	stash->texData = (unsigned char*)realloc(stash->texData, width * height);
 	if (stash->texData == NULL) return 0;
 	memset(stash->texData, 0, width * height);
+	stash->npages = 1;
 
 	// Reset dirty rect
 	stash->dirtyRect[0] = width;
@@ -1946,5 +2642,126 @@ int fonsResetAtlas(FONScontext* stash, int width, int height)
 	return 1;
 }
 
+struct FONSglyphRef {
+	FONSglyph* glyph;
+	unsigned int key;
+};
+typedef struct FONSglyphRef FONSglyphRef;
+
+static int fons__cmpGlyphRef(const void* a, const void* b)
+{
+	unsigned int ka = ((const FONSglyphRef*)a)->key, kb = ((const FONSglyphRef*)b)->key;
+	return ka < kb ? -1 : (ka > kb ? 1 : 0);
+}
+
+int fonsCompactAtlas(FONScontext* stash, int width, int height)
+{
+	FONSglyphRef* refs = NULL;
+	unsigned char* data = NULL;
+	unsigned char* oldData;
+	int oldWidth, oldHeight, nrefs = 0, nkeep, i, j, k, y, maxy = 0;
+	float area = 0.0f;
+
+	if (stash == NULL) return 0;
+
+	// Flush pending glyphs.
+	fonsCommitGlyphs(stash, 1);
+	fons__flush(stash);
+
+	// Gather the glyphs with bitmaps, most recently used first.
+	for (i = 0; i < stash->nfonts; i++)
+		nrefs += stash->fonts[i]->nglyphs;
+	refs = (FONSglyphRef*)malloc(sizeof(FONSglyphRef) * (nrefs > 0 ? nrefs : 1));
+	data = (unsigned char*)malloc(width * height);
+	if (refs == NULL || data == NULL) goto error;
+	nrefs = 0;
+	for (i = 0; i < stash->nfonts; i++) {
+		FONSfont* font = stash->fonts[i];
+		for (j = 0; j < font->nglyphs; j++) {
+			if (font->glyphs[j].x0 < 0 || font->glyphs[j].y0 < 0) continue;
+			refs[nrefs].glyph = &font->glyphs[j];
+			refs[nrefs].key = stash->tick - font->glyphs[j].lastUsed;
+			nrefs++;
+		}
+	}
+	qsort(refs, nrefs, sizeof(FONSglyphRef), fons__cmpGlyphRef);
+
+	// Keep the recent glyphs that fill part of the atlas, and pack the tallest first.
+	for (nkeep = 0; nkeep < nrefs; nkeep++) {
+		FONSglyph* glyph = refs[nkeep].glyph;
+		area += (float)(glyph->x1 - glyph->x0) * (float)(glyph->y1 - glyph->y0);
+		if (area > width * height * FONS_COMPACT_KEEP_AREA) break;
+		refs[nkeep].key = (unsigned int)(0x7fff - (glyph->y1 - glyph->y0));
+	}
+	qsort(refs, nkeep, sizeof(FONSglyphRef), fons__cmpGlyphRef);
+
+	if (stash->params.renderResize != NULL) {
+		if (stash->params.renderResize(stash->params.userPtr, width, height) == 0)
+			goto error;
+	}
+
+	oldData = stash->texData;
+	oldWidth = stash->params.width;
+	oldHeight = stash->params.height;
+	memset(data, 0, width * height);
+	stash->texData = data;
+	stash->npages = 1;
+	stash->params.width = width;
+	stash->params.height = height;
+	stash->itw = 1.0f/stash->params.width;
+	stash->ith = 1.0f/stash->params.height;
+	fons__atlasReset(stash->atlas, width, height);
+	fons__addWhiteRect(stash, 2,2);
+
+	// Copy the kept bitmaps to the new atlas, the glyphs left without a bitmap are evicted below.
+	for (i = 0; i < nrefs; i++) {
+		FONSglyph* glyph = refs[i].glyph;
+		int gw = glyph->x1 - glyph->x0, gh = glyph->y1 - glyph->y0, gx, gy;
+		if (i < nkeep && fons__atlasAddRect(stash->atlas, gw, gh, &gx, &gy)) {
+			for (y = 0; y < gh; y++)
+				memcpy(&data[gx + (gy+y) * width], &oldData[glyph->x0 + (glyph->page*oldHeight + glyph->y0+y) * oldWidth], gw);
+			glyph->page = 0;
+			glyph->x0 = (short)gx;
+			glyph->y0 = (short)gy;
+			glyph->x1 = (short)(gx+gw);
+			glyph->y1 = (short)(gy+gh);
+		} else {
+			glyph->x0 = -1;
+		}
+	}
+	free(oldData);
+	free(refs);
+
+	// Remove the evicted glyphs and rebuild the lookups.
+	for (i = 0; i < stash->nfonts; i++) {
+		FONSfont* font = stash->fonts[i];
+		for (j = 0; j < FONS_HASH_LUT_SIZE; j++)
+			font->lut[j] = -1;
+		for (j = k = 0; j < font->nglyphs; j++) {
+			unsigned int h;
+			if (font->glyphs[j].x0 < 0) continue;
+			font->glyphs[k] = font->glyphs[j];
+			h = fons__hashint(font->glyphs[k].codepoint) & (FONS_HASH_LUT_SIZE-1);
+			font->glyphs[k].next = font->lut[h];
+			font->lut[h] = k++;
+		}
+		font->nglyphs = k;
+	}
+
+	for (i = 0; i < stash->atlas->nnodes; i++)
+		maxy = fons__maxi(maxy, stash->atlas->nodes[i].y);
+	stash->dirtyRect[0] = 0;
+	stash->dirtyRect[1] = 0;
+	stash->dirtyRect[2] = width;
+	stash->dirtyRect[3] = maxy;
+
+	return 1;
+
+error:
+	if (refs != NULL) free(refs);
+	if (data != NULL) free(data);
+	return fonsResetAtlas(stash, width, height);
+}
+
 
 #endif
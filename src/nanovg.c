@@ -22,9 +22,54 @@
 #include <memory.h>
 
 #include "nanovg.h"
+
+#if defined(NVG_FRAME_TIMINGS) && !defined(NVG_FRAME_STATS)
+#define NVG_FRAME_STATS
+#endif
+
+#ifdef NVG_FRAME_TIMINGS
+#include <time.h>
+static double nvg__time(void)
+{
+	struct timespec ts;
+#ifdef _WIN32
+	timespec_get(&ts, TIME_UTC);
+#else
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+#endif
+	return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+#define FONS_CLOCK() nvg__time()
+#define NVG_TIMER_START() nvg__time()
+#define NVG_TIMER_STOP(ctx, name, start) ((ctx)->stats.name += (float)((nvg__time() - (start)) * 1000.0))
+#else
+#define NVG_TIMER_START() 0.0
+#define NVG_TIMER_STOP(ctx, name, start) NVG_NOTUSED(start)
+#endif
+
+#ifdef NVG_FRAME_STATS
+#define FONS_STATS
+#define NVG_STAT_ADD(ctx, name, n) ((ctx)->stats.name += (n))
+#else
+#define NVG_STAT_ADD(ctx, name, n) NVG_NOTUSED(n)
+#endif
+
 #define FONTSTASH_IMPLEMENTATION
 #include "fontstash.h"
 
+// Path expansion uses SSE2 or NEON when available, define NVG_NO_SIMD to use the scalar code.
+#ifndef NVG_NO_SIMD
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define NVG_SSE2
+#define NVG_SIMD
+#elif defined(__aarch64__) || defined(_M_ARM64)
+#include <arm_neon.h>
+#define NVG_NEON
+#define NVG_SIMD
+#endif
+#endif
+
 #ifndef NVG_NO_STB
 #define STB_IMAGE_IMPLEMENTATION
 #include "stb_image.h"
@@ -40,6 +85,7 @@
 #define NVG_INIT_FONTIMAGE_SIZE  512
 #define NVG_MAX_FONTIMAGE_SIZE   2048
 #define NVG_MAX_FONTIMAGES       4
+#define NVG_MAX_FONTPAGES        8
 
 #define NVG_INIT_COMMANDS_SIZE 256
 #define NVG_INIT_POINTS_SIZE 128
@@ -50,6 +96,25 @@
 #define NVG_MAX_STATES 32
 #endif
 
+#ifndef NVG_MAX_BEZIER_SEGMENTS
+#define NVG_MAX_BEZIER_SEGMENTS 1024
+#endif
+
+// With level of detail enabled, fills smaller than this on screen in both directions are drawn as a quad.
+#ifndef NVG_LOD_QUAD_SIZE
+#define NVG_LOD_QUAD_SIZE 3.0f
+#endif
+
+// Text runs are the glyph quads of recently drawn strings, reused while the string, font and size repeat.
+// Runs not used for this many frames are dropped.
+#ifndef NVG_TEXT_RUN_MAX_AGE
+#define NVG_TEXT_RUN_MAX_AGE 30
+#endif
+#ifndef NVG_MAX_TEXT_RUNS
+#define NVG_MAX_TEXT_RUNS 8192
+#endif
+#define NVG_TEXT_RUN_HASH_SIZE 1024
+
 #define NVG_KAPPA90 0.5522847493f	// Length proportional to radius of a cubic bezier handle for 90deg arcs.
 
 #define NVG_COUNTOF(arr) (sizeof(arr) / sizeof(0[arr]))
@@ -61,6 +126,7 @@ enum NVGcommands {
 	NVG_BEZIERTO = 2,
 	NVG_CLOSE = 3,
 	NVG_WINDING = 4,
+	NVG_POLYLINE = 5,	// Followed by the point count and the points as x,y pairs.
 };
 
 enum NVGpointFlags
@@ -74,6 +140,7 @@ enum NVGpointFlags
 struct NVGstate {
 	NVGcompositeOperationState compositeOperation;
 	int shapeAntiAlias;
+	int shapeLod;
 	NVGpaint fill;
 	NVGpaint stroke;
 	float strokeWidth;
@@ -103,8 +170,22 @@ struct NVGpoint {
 };
 typedef struct NVGpoint NVGpoint;
 
+// Points are stored as separate arrays so that each pass only touches the fields it needs.
+// The arrays are allocated as one block, each array starts 16 byte aligned.
+struct NVGpoints {
+	float* x;
+	float* y;
+	float* dx;			// Direction and length of the segment to the next point.
+	float* dy;
+	float* len;
+	float* dmx;			// Miter extrusion.
+	float* dmy;
+	unsigned char* flags;
+};
+typedef struct NVGpoints NVGpoints;
+
 struct NVGpathCache {
-	NVGpoint* points;
+	NVGpoints points;
 	int npoints;
 	int cpoints;
 	NVGpath* paths;
@@ -117,6 +198,32 @@ struct NVGpathCache {
 };
 typedef struct NVGpathCache NVGpathCache;
 
+struct NVGtextRunGlyph {
+	FONSquad q;
+	float x, nextx;	// Pen position before and after the glyph.
+	int offset;		// Byte offset of the glyph in the string.
+	int slot;		// Glyph cache slot, see fonsTouchGlyph().
+};
+typedef struct NVGtextRunGlyph NVGtextRunGlyph;
+
+struct NVGtextRun {
+	unsigned int hash;
+	int next;
+	char* str;
+	int len;
+	int font;
+	int align;
+	float size, spacing, blur, dilate;
+	NVGtextRunGlyph* glyphs;	// NULL until the run is drawn.
+	int nglyphs;
+	float nextx;
+	int measured;		// Set when width and bounds hold the results of fonsTextBounds().
+	float width;
+	float bounds[4];
+	int lastFrame;
+};
+typedef struct NVGtextRun NVGtextRun;
+
 struct NVGcontext {
 	NVGparams params;
 	float* commands;
@@ -126,20 +233,60 @@ struct NVGcontext {
 	NVGstate states[NVG_MAX_STATES];
 	int nstates;
 	NVGpathCache* cache;
+	NVGshapeVertex* shapeVerts;
+	int cshapeVerts;
 	float tessTol;
 	float distTol;
 	float fringeWidth;
 	float devicePxRatio;
+	float windowWidth, windowHeight;
 	struct FONScontext* fs;
 	int fontImages[NVG_MAX_FONTIMAGES];
 	int fontImageIdx;
-	int drawCallCount;
-	int fillTriCount;
-	int strokeTriCount;
-	int textTriCount;
+	int fontImagePages;	// Atlas pages the current font image has room for.
+	int textRasterPolicy;
+	NVGtextRun* textRuns;
+	int ntextRuns;
+	int ctextRuns;
+	int textRunLut[NVG_TEXT_RUN_HASH_SIZE];
+	NVGtextRunGlyph* runGlyphs;	// Glyphs of the string being laid out.
+	int crunGlyphs;
+	int frameCount;
+	NVGframeStats stats;
 	struct NVGscissorBounds scissor;
 };
 
+struct NVGpathRefStyle {
+	float strokeWidth;
+	float fringe;
+	float tessTol;
+	float miterLimit;
+	int lineCap;
+	int lineJoin;
+	int lineStyle;
+};
+typedef struct NVGpathRefStyle NVGpathRefStyle;
+
+struct NVGpathRefCache {
+	NVGpathCache* cache;
+	NVGpathRefStyle style;
+	float xform[6];
+	int valid;
+};
+typedef struct NVGpathRefCache NVGpathRefCache;
+
+struct NVGpathRef {
+	float* commands;
+	float* xcommands;
+	int ncommands;
+	float bounds[4];	// Bounds of the commands, in the space the path was recorded in.
+	float invxform[6];
+	NVGpath* paths;
+	int cpaths;
+	NVGpathRefCache fill;
+	NVGpathRefCache stroke;
+};
+
 static float nvg__sqrtf(float a) { return sqrtf(a); }
 static float nvg__modf(float a, float b) { return fmodf(a, b); }
 static float nvg__sinf(float a) { return sinf(a); }
@@ -169,11 +316,128 @@ static float nvg__normalize(float *x, float* y)
 	return d;
 }
 
+#ifdef NVG_SIMD
+// 4-wide float helpers shared by the SSE2 and NEON paths.
+#ifdef NVG_SSE2
+typedef __m128 nvg__v4;
+typedef __m128 nvg__m4;
+#define nvg__v4load(p)		_mm_loadu_ps(p)
+#define nvg__v4store(p, a)	_mm_storeu_ps(p, a)
+#define nvg__v4set1(a)		_mm_set1_ps(a)
+#define nvg__v4set(a,b,c,d)	_mm_setr_ps(a,b,c,d)
+#define nvg__v4add(a, b)	_mm_add_ps(a, b)
+#define nvg__v4sub(a, b)	_mm_sub_ps(a, b)
+#define nvg__v4mul(a, b)	_mm_mul_ps(a, b)
+#define nvg__v4div(a, b)	_mm_div_ps(a, b)
+#define nvg__v4min(a, b)	_mm_min_ps(a, b)
+#define nvg__v4max(a, b)	_mm_max_ps(a, b)
+#define nvg__v4sqrt(a)		_mm_sqrt_ps(a)
+#define nvg__v4gt(a, b)		_mm_cmpgt_ps(a, b)
+#define nvg__v4lt(a, b)		_mm_cmplt_ps(a, b)
+#define nvg__v4sel(m, a, b)	_mm_or_ps(_mm_and_ps(m, a), _mm_andnot_ps(m, b))
+#define nvg__v4bits(m)		_mm_movemask_ps(m)
+#define nvg__v4swap2(a)		_mm_shuffle_ps(a, a, _MM_SHUFFLE(2,3,0,1))
+#else
+typedef float32x4_t nvg__v4;
+typedef uint32x4_t nvg__m4;
+#define nvg__v4load(p)		vld1q_f32(p)
+#define nvg__v4store(p, a)	vst1q_f32(p, a)
+#define nvg__v4set1(a)		vdupq_n_f32(a)
+#define nvg__v4add(a, b)	vaddq_f32(a, b)
+#define nvg__v4sub(a, b)	vsubq_f32(a, b)
+#define nvg__v4mul(a, b)	vmulq_f32(a, b)
+#define nvg__v4div(a, b)	vdivq_f32(a, b)
+#define nvg__v4min(a, b)	vminq_f32(a, b)
+#define nvg__v4max(a, b)	vmaxq_f32(a, b)
+#define nvg__v4sqrt(a)		vsqrtq_f32(a)
+#define nvg__v4gt(a, b)		vcgtq_f32(a, b)
+#define nvg__v4lt(a, b)		vcltq_f32(a, b)
+#define nvg__v4sel(m, a, b)	vbslq_f32(m, a, b)
+#define nvg__v4swap2(a)		vrev64q_f32(a)
+static nvg__v4 nvg__v4set(float a, float b, float c, float d)
+{
+	float v[4];
+	v[0] = a; v[1] = b; v[2] = c; v[3] = d;
+	return vld1q_f32(v);
+}
+static int nvg__v4bits(nvg__m4 m)
+{
+	static const uint32_t bits[4] = { 1, 2, 4, 8 };
+	return (int)vaddvq_u32(vandq_u32(m, vld1q_u32(bits)));
+}
+#endif
+#endif
+
+
+// Sets the points to the arrays in a block of cpoints points, cpoints must be a multiple of 4.
+static void nvg__setPointArrays(NVGpoints* pts, void* block, int cpoints)
+{
+	float* f = (float*)block;
+	pts->x = f;
+	pts->y = f + cpoints;
+	pts->dx = f + cpoints*2;
+	pts->dy = f + cpoints*3;
+	pts->len = f + cpoints*4;
+	pts->dmx = f + cpoints*5;
+	pts->dmy = f + cpoints*6;
+	pts->flags = (unsigned char*)(f + cpoints*7);
+}
+
+static int nvg__allocPoints(NVGpathCache* c, int cpoints)
+{
+	NVGpoints pts;
+	void* block;
+	cpoints = (cpoints + 3) & ~3;
+	block = malloc((sizeof(float)*7 + 1) * cpoints);
+	if (block == NULL) return 0;
+	nvg__setPointArrays(&pts, block, cpoints);
+	if (c->points.x != NULL) {
+		memcpy(pts.x, c->points.x, sizeof(float)*c->npoints);
+		memcpy(pts.y, c->points.y, sizeof(float)*c->npoints);
+		memcpy(pts.dx, c->points.dx, sizeof(float)*c->npoints);
+		memcpy(pts.dy, c->points.dy, sizeof(float)*c->npoints);
+		memcpy(pts.len, c->points.len, sizeof(float)*c->npoints);
+		memcpy(pts.dmx, c->points.dmx, sizeof(float)*c->npoints);
+		memcpy(pts.dmy, c->points.dmy, sizeof(float)*c->npoints);
+		memcpy(pts.flags, c->points.flags, c->npoints);
+		free(c->points.x);
+	}
+	c->points = pts;
+	c->cpoints = cpoints;
+	return 1;
+}
+
+// Returns the arrays offset to the first point of the path.
+static NVGpoints nvg__pathPoints(NVGpathCache* c, const NVGpath* path)
+{
+	NVGpoints pts;
+	pts.x = c->points.x + path->first;
+	pts.y = c->points.y + path->first;
+	pts.dx = c->points.dx + path->first;
+	pts.dy = c->points.dy + path->first;
+	pts.len = c->points.len + path->first;
+	pts.dmx = c->points.dmx + path->first;
+	pts.dmy = c->points.dmy + path->first;
+	pts.flags = c->points.flags + path->first;
+	return pts;
+}
+
+static void nvg__getPoint(const NVGpoints* pts, int i, NVGpoint* pt)
+{
+	pt->x = pts->x[i];
+	pt->y = pts->y[i];
+	pt->dx = pts->dx[i];
+	pt->dy = pts->dy[i];
+	pt->len = pts->len[i];
+	pt->dmx = pts->dmx[i];
+	pt->dmy = pts->dmy[i];
+	pt->flags = pts->flags[i];
+}
 
 static void nvg__deletePathCache(NVGpathCache* c)
 {
 	if (c == NULL) return;
-	if (c->points != NULL) free(c->points);
+	if (c->points.x != NULL) free(c->points.x);
 	if (c->paths != NULL) free(c->paths);
 	if (c->verts != NULL) free(c->verts);
 	free(c);
@@ -185,10 +449,8 @@ static NVGpathCache* nvg__allocPathCache(void)
 	if (c == NULL) goto error;
 	memset(c, 0, sizeof(NVGpathCache));
 
-	c->points = (NVGpoint*)malloc(sizeof(NVGpoint)*NVG_INIT_POINTS_SIZE);
-	if (!c->points) goto error;
+	if (!nvg__allocPoints(c, NVG_INIT_POINTS_SIZE)) goto error;
 	c->npoints = 0;
-	c->cpoints = NVG_INIT_POINTS_SIZE;
 
 	c->paths = (NVGpath*)malloc(sizeof(NVGpath)*NVG_INIT_PATHS_SIZE);
 	if (!c->paths) goto error;
@@ -301,6 +563,12 @@ NVGcontext* nvgCreateInternal(NVGparams* params)
 	memset(ctx, 0, sizeof(NVGcontext));
 
 	ctx->params = *params;
+	for (i = 0; i < NVG_TEXT_RUN_HASH_SIZE; i++)
+		ctx->textRunLut[i] = -1;
+#ifdef FONS_USE_FREETYPE
+	// FreeType glyphs are bitmaps only.
+	ctx->params.renderSDFTriangles = NULL;
+#endif
 	for (i = 0; i < NVG_MAX_FONTIMAGES; i++)
 		ctx->fontImages[i] = 0;
 
@@ -324,6 +592,8 @@ NVGcontext* nvgCreateInternal(NVGparams* params)
 	fontParams.width = NVG_INIT_FONTIMAGE_SIZE;
 	fontParams.height = NVG_INIT_FONTIMAGE_SIZE;
 	fontParams.flags = FONS_ZERO_TOPLEFT;
+	if (ctx->params.renderSDFTriangles != NULL)
+		fontParams.flags |= FONS_SDF;
 	fontParams.renderCreate = NULL;
 	fontParams.renderUpdate = NULL;
 	fontParams.renderDraw = NULL;
@@ -331,11 +601,15 @@ NVGcontext* nvgCreateInternal(NVGparams* params)
 	fontParams.userPtr = NULL;
 	ctx->fs = fonsCreateInternal(&fontParams);
 	if (ctx->fs == NULL) goto error;
+	// With pages the atlas fills several layers of one font image before it is full.
+	if (ctx->params.renderResizeTexturePages != NULL)
+		fonsSetMaxPages(ctx->fs, NVG_MAX_FONTPAGES);
 
 	// Create font texture
 	ctx->fontImages[0] = ctx->params.renderCreateTexture(ctx->params.userPtr, NVG_TEXTURE_ALPHA, fontParams.width, fontParams.height, 0, NULL);
 	if (ctx->fontImages[0] == 0) goto error;
 	ctx->fontImageIdx = 0;
+	ctx->fontImagePages = 1;
 	ctx->scissor = (NVGscissorBounds){0.0f, 0.0f, -1.0f, -1.0f};
 	return ctx;
 
@@ -358,12 +632,18 @@ struct NVGscissorBounds nvgCurrentScissor(NVGcontext* ctx) {
 	return ctx->scissor;
 }
 
+static void nvg__clearTextRuns(NVGcontext* ctx);
+
 void nvgDeleteInternal(NVGcontext* ctx)
 {
 	int i;
 	if (ctx == NULL) return;
 	if (ctx->commands != NULL) free(ctx->commands);
 	if (ctx->cache != NULL) nvg__deletePathCache(ctx->cache);
+	if (ctx->shapeVerts != NULL) free(ctx->shapeVerts);
+	nvg__clearTextRuns(ctx);
+	free(ctx->textRuns);
+	free(ctx->runGlyphs);
 
 	if (ctx->fs)
 		fonsDeleteInternal(ctx->fs);
@@ -384,21 +664,22 @@ void nvgDeleteInternal(NVGcontext* ctx)
 void nvgBeginFrame(NVGcontext* ctx, float windowWidth, float windowHeight, float devicePixelRatio)
 {
 /*	printf("Tris: draws:%d  fill:%d  stroke:%d  text:%d  TOT:%d\n",
-		ctx->drawCallCount, ctx->fillTriCount, ctx->strokeTriCount, ctx->textTriCount,
-		ctx->fillTriCount+ctx->strokeTriCount+ctx->textTriCount);*/
+		ctx->stats.drawCalls, ctx->stats.fillTris, ctx->stats.strokeTris, ctx->stats.textTris,
+		ctx->stats.fillTris+ctx->stats.strokeTris+ctx->stats.textTris);*/
 
 	ctx->nstates = 0;
 	nvgSave(ctx);
 	nvgReset(ctx);
 
 	nvg__setDevicePixelRatio(ctx, devicePixelRatio);
+	ctx->windowWidth = windowWidth;
+	ctx->windowHeight = windowHeight;
 
 	ctx->params.renderViewport(ctx->params.userPtr, windowWidth, windowHeight, devicePixelRatio);
 
-	ctx->drawCallCount = 0;
-	ctx->fillTriCount = 0;
-	ctx->strokeTriCount = 0;
-	ctx->textTriCount = 0;
+	memset(&ctx->stats, 0, sizeof(ctx->stats));
+	fonsGetStats(ctx->fs, NULL, NULL, NULL);
+	ctx->frameCount++;
 }
 
 void nvgCancelFrame(NVGcontext* ctx)
@@ -406,9 +687,19 @@ void nvgCancelFrame(NVGcontext* ctx)
 	ctx->params.renderCancel(ctx->params.userPtr);
 }
 
+static void nvg__flushTextTexture(NVGcontext* ctx);
+static void nvg__ageTextRuns(NVGcontext* ctx);
+
 void nvgEndFrame(NVGcontext* ctx)
 {
+	double startTime;
+	nvg__ageTextRuns(ctx);
+	// Copy the glyphs finished by the raster threads before the text is drawn.
+	fonsCommitGlyphs(ctx->fs, ctx->textRasterPolicy == NVG_RASTER_BLOCK);
+	nvg__flushTextTexture(ctx);
+	startTime = NVG_TIMER_START();
 	ctx->params.renderFlush(ctx->params.userPtr);
+	NVG_TIMER_STOP(ctx, flushTime, startTime);
 	if (ctx->fontImageIdx != 0) {
 		int fontImage = ctx->fontImages[ctx->fontImageIdx];
 		ctx->fontImages[ctx->fontImageIdx] = 0;
@@ -436,6 +727,19 @@ void nvgEndFrame(NVGcontext* ctx)
 	}
 }
 
+void nvgGetFrameStats(NVGcontext* ctx, NVGframeStats* stats)
+{
+	int hits, misses;
+	double rasterTime;
+	fonsGetStats(ctx->fs, &hits, &misses, &rasterTime);
+	NVG_STAT_ADD(ctx, glyphHits, hits);
+	NVG_STAT_ADD(ctx, glyphMisses, misses);
+#ifdef NVG_FRAME_TIMINGS
+	ctx->stats.glyphTime += (float)(rasterTime * 1000.0);
+#endif
+	*stats = ctx->stats;
+}
+
 NVGcolor nvgRGB(unsigned char r, unsigned char g, unsigned char b)
 {
 	return nvgRGBA(r,g,b,255);
@@ -692,6 +996,12 @@ void nvgShapeAntiAlias(NVGcontext* ctx, int enabled)
 	state->shapeAntiAlias = enabled;
 }
 
+void nvgShapeLevelOfDetail(NVGcontext* ctx, int enabled)
+{
+	NVGstate* state = nvg__getState(ctx);
+	state->shapeLod = enabled;
+}
+
 void nvgStrokeWidth(NVGcontext* ctx, float width)
 {
 	NVGstate* state = nvg__getState(ctx);
@@ -873,6 +1183,8 @@ void nvgUpdateImage(NVGcontext* ctx, int image, const unsigned char* data)
 	int w, h;
 	ctx->params.renderGetTextureSize(ctx->params.userPtr, image, &w, &h);
 	ctx->params.renderUpdateTexture(ctx->params.userPtr, image, 0,0, w,h, data);
+	NVG_STAT_ADD(ctx, uploads, 1);
+	NVG_STAT_ADD(ctx, uploadBytes, w*h*4);
 }
 
 void nvgImageSize(NVGcontext* ctx, int image, int* w, int* h)
@@ -1115,42 +1427,75 @@ static float nvg__distPtSeg(float x, float y, float px, float py, float qx, floa
 	return dx*dx + dy*dy;
 }
 
-static void nvg__appendCommands(NVGcontext* ctx, float* vals, int nvals)
+// Transforms n points stored as x,y pairs in place.
+static void nvg__transformPoints(float* xy, int n, const float* t)
 {
-	NVGstate* state = nvg__getState(ctx);
-	int i;
-
-	if (ctx->ncommands+nvals > ctx->ccommands) {
-		float* commands;
-		int ccommands = ctx->ncommands+nvals + ctx->ccommands/2;
-		commands = (float*)realloc(ctx->commands, sizeof(float)*ccommands);
-		if (commands == NULL) return;
-		ctx->commands = commands;
-		ctx->ccommands = ccommands;
+	int i = 0;
+#ifdef NVG_SIMD
+	// Two points per vector, x' = x*t0 + y*t2 + t4 and y' = y*t3 + x*t1 + t5.
+	nvg__v4 m0 = nvg__v4set(t[0], t[3], t[0], t[3]);
+	nvg__v4 m1 = nvg__v4set(t[2], t[1], t[2], t[1]);
+	nvg__v4 m2 = nvg__v4set(t[4], t[5], t[4], t[5]);
+	for (; i+2 <= n; i += 2) {
+		nvg__v4 p = nvg__v4load(&xy[i*2]);
+		p = nvg__v4add(nvg__v4add(nvg__v4mul(p, m0), nvg__v4mul(nvg__v4swap2(p), m1)), m2);
+		nvg__v4store(&xy[i*2], p);
 	}
-
-	if ((int)vals[0] != NVG_CLOSE && (int)vals[0] != NVG_WINDING) {
-		ctx->commandx = vals[nvals-2];
-		ctx->commandy = vals[nvals-1];
+#endif
+	for (; i < n; i++)
+		nvgTransformPoint(&xy[i*2], &xy[i*2+1], t, xy[i*2], xy[i*2+1]);
+}
+
+// Keeps the first, last, lowest and highest point of each run of consecutive points
+// within the same device pixel column, in their original order. Returns the new count.
+static int nvg__decimatePoints(float* xy, int n, float scale)
+{
+	int i = 0, m = 0;
+	while (i < n) {
+		float col = floorf(xy[i*2] * scale);
+		float xmin = col / scale, xmax = (col + 1.0f) / scale;
+		float ylo = xy[i*2+1], yhi = ylo;
+		int keep[4], nkeep = 0, first = i, lo = i, hi = i, k;
+		float pts[8];
+		for (i++; i < n && xy[i*2] >= xmin && xy[i*2] < xmax; i++) {
+			float y = xy[i*2+1];
+			if (y < ylo) { ylo = y; lo = i; }
+			if (y > yhi) { yhi = y; hi = i; }
+		}
+		keep[nkeep++] = first;
+		if (nvg__mini(lo, hi) != keep[nkeep-1]) keep[nkeep++] = nvg__mini(lo, hi);
+		if (nvg__maxi(lo, hi) != keep[nkeep-1]) keep[nkeep++] = nvg__maxi(lo, hi);
+		if (i-1 != keep[nkeep-1]) keep[nkeep++] = i-1;
+		// Output may overlap the run, read the points before writing.
+		for (k = 0; k < nkeep; k++) {
+			pts[k*2] = xy[keep[k]*2];
+			pts[k*2+1] = xy[keep[k]*2+1];
+		}
+		memcpy(&xy[m*2], pts, sizeof(float)*2*nkeep);
+		m += nkeep;
 	}
+	return m;
+}
 
-	// transform commands
-	i = 0;
+static int nvg__transformCommands(float* vals, int nvals, const float* xform)
+{
+	int i = 0, n = 0;
 	while (i < nvals) {
 		int cmd = (int)vals[i];
+		n++;
 		switch (cmd) {
 		case NVG_MOVETO:
-			nvgTransformPoint(&vals[i+1],&vals[i+2], state->xform, vals[i+1],vals[i+2]);
+			nvgTransformPoint(&vals[i+1],&vals[i+2], xform, vals[i+1],vals[i+2]);
 			i += 3;
 			break;
 		case NVG_LINETO:
-			nvgTransformPoint(&vals[i+1],&vals[i+2], state->xform, vals[i+1],vals[i+2]);
+			nvgTransformPoint(&vals[i+1],&vals[i+2], xform, vals[i+1],vals[i+2]);
 			i += 3;
 			break;
 		case NVG_BEZIERTO:
-			nvgTransformPoint(&vals[i+1],&vals[i+2], state->xform, vals[i+1],vals[i+2]);
-			nvgTransformPoint(&vals[i+3],&vals[i+4], state->xform, vals[i+3],vals[i+4]);
-			nvgTransformPoint(&vals[i+5],&vals[i+6], state->xform, vals[i+5],vals[i+6]);
+			nvgTransformPoint(&vals[i+1],&vals[i+2], xform, vals[i+1],vals[i+2]);
+			nvgTransformPoint(&vals[i+3],&vals[i+4], xform, vals[i+3],vals[i+4]);
+			nvgTransformPoint(&vals[i+5],&vals[i+6], xform, vals[i+5],vals[i+6]);
 			i += 7;
 			break;
 		case NVG_CLOSE:
@@ -1159,10 +1504,45 @@ static void nvg__appendCommands(NVGcontext* ctx, float* vals, int nvals)
 		case NVG_WINDING:
 			i += 2;
 			break;
+		case NVG_POLYLINE:
+			nvg__transformPoints(&vals[i+2], (int)vals[i+1], xform);
+			i += 2 + (int)vals[i+1]*2;
+			break;
 		default:
 			i++;
 		}
 	}
+	return n;
+}
+
+static int nvg__reserveCommands(NVGcontext* ctx, int nvals)
+{
+	if (ctx->ncommands+nvals > ctx->ccommands) {
+		float* commands;
+		int ccommands = ctx->ncommands+nvals + ctx->ccommands/2;
+		commands = (float*)realloc(ctx->commands, sizeof(float)*ccommands);
+		if (commands == NULL) return 0;
+		ctx->commands = commands;
+		ctx->ccommands = ccommands;
+	}
+	return 1;
+}
+
+static void nvg__appendCommands(NVGcontext* ctx, float* vals, int nvals)
+{
+	NVGstate* state = nvg__getState(ctx);
+	int ncmds;
+
+	if (nvg__reserveCommands(ctx, nvals) == 0) return;
+
+	if ((int)vals[0] != NVG_CLOSE && (int)vals[0] != NVG_WINDING) {
+		ctx->commandx = vals[nvals-2];
+		ctx->commandy = vals[nvals-1];
+	}
+
+	// transform commands
+	ncmds = nvg__transformCommands(vals, nvals, state->xform);
+	NVG_STAT_ADD(ctx, commands, ncmds);
 
 	memcpy(&ctx->commands[ctx->ncommands], vals, nvals*sizeof(float));
 
@@ -1202,44 +1582,65 @@ static void nvg__addPath(NVGcontext* ctx)
 	ctx->cache->npaths++;
 }
 
-static NVGpoint* nvg__lastPoint(NVGcontext* ctx)
+static int nvg__reservePoints(NVGcontext* ctx, int n)
 {
-	if (ctx->cache->npoints > 0)
-		return &ctx->cache->points[ctx->cache->npoints-1];
-	return NULL;
+	if (ctx->cache->npoints+n > ctx->cache->cpoints)
+		return nvg__allocPoints(ctx->cache, ctx->cache->npoints+n + ctx->cache->cpoints/2);
+	return 1;
 }
 
 static void nvg__addPoint(NVGcontext* ctx, float x, float y, int flags)
 {
+	NVGpathCache* cache = ctx->cache;
 	NVGpath* path = nvg__lastPath(ctx);
-	NVGpoint* pt;
+	int i;
 	if (path == NULL) return;
 
-	if (path->count > 0 && ctx->cache->npoints > 0) {
-		pt = nvg__lastPoint(ctx);
-		if (nvg__ptEquals(pt->x,pt->y, x,y, ctx->distTol)) {
-			pt->flags |= flags;
+	if (path->count > 0 && cache->npoints > 0) {
+		i = cache->npoints-1;
+		if (nvg__ptEquals(cache->points.x[i],cache->points.y[i], x,y, ctx->distTol)) {
+			cache->points.flags[i] |= flags;
 			return;
 		}
 	}
 
-	if (ctx->cache->npoints+1 > ctx->cache->cpoints) {
-		NVGpoint* points;
-		int cpoints = ctx->cache->npoints+1 + ctx->cache->cpoints/2;
-		points = (NVGpoint*)realloc(ctx->cache->points, sizeof(NVGpoint)*cpoints);
-		if (points == NULL) return;
-		ctx->cache->points = points;
-		ctx->cache->cpoints = cpoints;
-	}
+	if (nvg__reservePoints(ctx, 1) == 0) return;
 
-	pt = &ctx->cache->points[ctx->cache->npoints];
-	memset(pt, 0, sizeof(*pt));
-	pt->x = x;
-	pt->y = y;
-	pt->flags = (unsigned char)flags;
+	i = cache->npoints;
+	cache->points.x[i] = x;
+	cache->points.y[i] = y;
+	cache->points.flags[i] = (unsigned char)flags;
 
-	ctx->cache->npoints++;
+	cache->npoints++;
 	path->count++;
+	NVG_STAT_ADD(ctx, points, 1);
+}
+
+// Adds n points stored as x,y pairs, same as calling nvg__addPoint() for each.
+static void nvg__addPoints(NVGcontext* ctx, const float* xy, int n, int flags)
+{
+	NVGpathCache* cache = ctx->cache;
+	NVGpath* path = nvg__lastPath(ctx);
+	int i, j;
+	if (path == NULL) return;
+	if (nvg__reservePoints(ctx, n) == 0) return;
+
+	j = cache->npoints;
+	for (i = 0; i < n; i++) {
+		float x = xy[i*2], y = xy[i*2+1];
+		if (j > path->first && nvg__ptEquals(cache->points.x[j-1],cache->points.y[j-1], x,y, ctx->distTol)) {
+			cache->points.flags[j-1] |= flags;
+			continue;
+		}
+		cache->points.x[j] = x;
+		cache->points.y[j] = y;
+		cache->points.flags[j] = (unsigned char)flags;
+		j++;
+	}
+
+	path->count += j - cache->npoints;
+	NVG_STAT_ADD(ctx, points, j - cache->npoints);
+	cache->npoints = j;
 }
 
 static void nvg__closePath(NVGcontext* ctx)
@@ -1286,27 +1687,25 @@ static float nvg__triarea2(float ax, float ay, float bx, float by, float cx, flo
 	return acx*aby - abx*acy;
 }
 
-static float nvg__polyArea(NVGpoint* pts, int npts)
+static float nvg__polyArea(const NVGpoints* pts, int npts)
 {
 	int i;
 	float area = 0;
-	for (i = 2; i < npts; i++) {
-		NVGpoint* a = &pts[0];
-		NVGpoint* b = &pts[i-1];
-		NVGpoint* c = &pts[i];
-		area += nvg__triarea2(a->x,a->y, b->x,b->y, c->x,c->y);
-	}
+	for (i = 2; i < npts; i++)
+		area += nvg__triarea2(pts->x[0],pts->y[0], pts->x[i-1],pts->y[i-1], pts->x[i],pts->y[i]);
 	return area * 0.5f;
 }
 
-static void nvg__polyReverse(NVGpoint* pts, int npts)
+// Reverses the positions and flags, the other fields are calculated after the winding is enforced.
+static void nvg__polyReverse(NVGpoints* pts, int npts)
 {
-	NVGpoint tmp;
+	float tx, ty;
+	unsigned char tf;
 	int i = 0, j = npts-1;
 	while (i < j) {
-		tmp = pts[i];
-		pts[i] = pts[j];
-		pts[j] = tmp;
+		tx = pts->x[i]; pts->x[i] = pts->x[j]; pts->x[j] = tx;
+		ty = pts->y[i]; pts->y[i] = pts->y[j]; pts->y[j] = ty;
+		tf = pts->flags[i]; pts->flags[i] = pts->flags[j]; pts->flags[j] = tf;
 		i++;
 		j--;
 	}
@@ -1326,64 +1725,113 @@ static void nvg__vset(NVGvertex* vtx, float x, float y, float u, float v, float
 static void nvg__tesselateBezier(NVGcontext* ctx,
 								 float x1, float y1, float x2, float y2,
 								 float x3, float y3, float x4, float y4,
-								 int level, int type)
+								 int type)
 {
-	float x12,y12,x23,y23,x34,y34,x123,y123,x234,y234,x1234,y1234;
-	float dx,dy,d2,d3;
-
-	if (level > 10) return;
-
-	x12 = (x1+x2)*0.5f;
-	y12 = (y1+y2)*0.5f;
-	x23 = (x2+x3)*0.5f;
-	y23 = (y2+y3)*0.5f;
-	x34 = (x3+x4)*0.5f;
-	y34 = (y3+y4)*0.5f;
-	x123 = (x12+x23)*0.5f;
-	y123 = (y12+y23)*0.5f;
+	NVGpathCache* cache = ctx->cache;
+	NVGpath* path = nvg__lastPath(ctx);
+	float ax, ay, bx, by, d, h;
+	float fx, fy, dfx, dfy, ddfx, ddfy, dddfx, dddfy;
+	int i, n, last;
 
-	dx = x4 - x1;
-	dy = y4 - y1;
-	d2 = nvg__absf(((x2 - x4) * dy - (y2 - y4) * dx));
-	d3 = nvg__absf(((x3 - x4) * dy - (y3 - y4) * dx));
+	if (path == NULL) return;
 
-	if ((d2 + d3)*(d2 + d3) < ctx->tessTol * (dx*dx + dy*dy)) {
-		nvg__addPoint(ctx, x4, y4, type);
-		return;
+	// Number of segments from Wang's formula, keeps the line segments within tessTol of the curve.
+	ax = x1 - 2*x2 + x3;
+	ay = y1 - 2*y2 + y3;
+	bx = x2 - 2*x3 + x4;
+	by = y2 - 2*y3 + y4;
+	d = nvg__maxf(ax*ax + ay*ay, bx*bx + by*by);
+	d = ceilf(sqrtf(0.75f * sqrtf(d) / ctx->tessTol));
+	// Clamped before the conversion, huge or NaN control points would overflow it.
+	n = d >= 1.0f ? (int)nvg__minf(d, (float)NVG_MAX_BEZIER_SEGMENTS) : 1;
+
+	if (nvg__reservePoints(ctx, n) == 0) return;
+	NVG_STAT_ADD(ctx, bezierSegments, n);
+
+	// Evaluate the curve with forward differencing.
+	h = 1.0f / n;
+	dddfx = 6.0f * (3*(x2 - x3) + x4 - x1) * h*h*h;
+	dddfy = 6.0f * (3*(y2 - y3) + y4 - y1) * h*h*h;
+	ddfx = 6.0f * ax * h*h + dddfx;
+	ddfy = 6.0f * ay * h*h + dddfy;
+	dfx = 3.0f * (x2 - x1) * h + 3.0f * ax * h*h + dddfx / 6.0f;
+	dfy = 3.0f * (y2 - y1) * h + 3.0f * ay * h*h + dddfy / 6.0f;
+	fx = x1;
+	fy = y1;
+
+	last = (path->count > 0 && cache->npoints > 0) ? cache->npoints-1 : -1;
+	for (i = 1; i <= n; i++) {
+		if (i < n) {
+			fx += dfx;
+			fy += dfy;
+			dfx += ddfx;
+			dfy += ddfy;
+			ddfx += dddfx;
+			ddfy += dddfy;
+		} else {
+			// End exactly at the last control point.
+			fx = x4;
+			fy = y4;
+		}
+		if (last != -1 && nvg__ptEquals(cache->points.x[last],cache->points.y[last], fx,fy, ctx->distTol)) {
+			if (i == n) cache->points.flags[last] |= (unsigned char)type;
+			continue;
+		}
+		last = cache->npoints++;
+		cache->points.x[last] = fx;
+		cache->points.y[last] = fy;
+		cache->points.flags[last] = (unsigned char)(i == n ? type : 0);
+		path->count++;
+		NVG_STAT_ADD(ctx, points, 1);
 	}
+}
 
-/*	if (nvg__absf(x1+x3-x2-x2) + nvg__absf(y1+y3-y2-y2) + nvg__absf(x2+x4-x3-x3) + nvg__absf(y2+y4-y3-y3) < ctx->tessTol) {
-		nvg__addPoint(ctx, x4, y4, type);
-		return;
-	}*/
+#ifdef NVG_SIMD
+// Calculates direction and length of the segments starting at four consecutive points,
+// and grows the bounds by the points.
+static void nvg__segmentDirs4(NVGpoints* pts, int i, nvg__v4* bounds)
+{
+	nvg__v4 x0 = nvg__v4load(&pts->x[i]);
+	nvg__v4 y0 = nvg__v4load(&pts->y[i]);
+	nvg__v4 dx = nvg__v4sub(nvg__v4load(&pts->x[i+1]), x0);
+	nvg__v4 dy = nvg__v4sub(nvg__v4load(&pts->y[i+1]), y0);
+	nvg__v4 d = nvg__v4sqrt(nvg__v4add(nvg__v4mul(dx, dx), nvg__v4mul(dy, dy)));
+	nvg__v4 id = nvg__v4div(nvg__v4set1(1.0f), d);
+	nvg__m4 valid = nvg__v4gt(d, nvg__v4set1(1e-6f));
 
-	x234 = (x23+x34)*0.5f;
-	y234 = (y23+y34)*0.5f;
-	x1234 = (x123+x234)*0.5f;
-	y1234 = (y123+y234)*0.5f;
+	nvg__v4store(&pts->dx[i], nvg__v4sel(valid, nvg__v4mul(dx, id), dx));
+	nvg__v4store(&pts->dy[i], nvg__v4sel(valid, nvg__v4mul(dy, id), dy));
+	nvg__v4store(&pts->len[i], d);
 
-	nvg__tesselateBezier(ctx, x1,y1, x12,y12, x123,y123, x1234,y1234, level+1, 0);
-	nvg__tesselateBezier(ctx, x1234,y1234, x234,y234, x34,y34, x4,y4, level+1, type);
+	bounds[0] = nvg__v4min(bounds[0], x0);
+	bounds[1] = nvg__v4min(bounds[1], y0);
+	bounds[2] = nvg__v4max(bounds[2], x0);
+	bounds[3] = nvg__v4max(bounds[3], y0);
 }
+#endif
 
 static void nvg__flattenPaths(NVGcontext* ctx)
 {
 	NVGpathCache* cache = ctx->cache;
 //	NVGstate* state = nvg__getState(ctx);
-	NVGpoint* last;
-	NVGpoint* p0;
-	NVGpoint* p1;
-	NVGpoint* pts;
+	NVGpoints pts;
 	NVGpath* path;
-	int i, j;
+	int i, j, i0, i1;
 	float* cp1;
 	float* cp2;
 	float* p;
 	float area;
+	double startTime;
+#ifdef NVG_SIMD
+	nvg__v4 bounds[4];
+	int nbatches = 0;
+#endif
 
 	if (cache->npaths > 0)
 		return;
 
+	startTime = NVG_TIMER_START();
+
 	// Flatten
 	i = 0;
 	while (i < ctx->ncommands) {
@@ -1401,12 +1849,12 @@ static void nvg__flattenPaths(NVGcontext* ctx)
 			i += 3;
 			break;
 		case NVG_BEZIERTO:
-			last = nvg__lastPoint(ctx);
-			if (last != NULL) {
+			if (cache->npoints > 0) {
+				i0 = cache->npoints-1;
 				cp1 = &ctx->commands[i+1];
 				cp2 = &ctx->commands[i+3];
 				p = &ctx->commands[i+5];
-				nvg__tesselateBezier(ctx, last->x,last->y, cp1[0],cp1[1], cp2[0],cp2[1], p[0],p[1], 0, NVG_PT_CORNER);
+				nvg__tesselateBezier(ctx, cache->points.x[i0],cache->points.y[i0], cp1[0],cp1[1], cp2[0],cp2[1], p[0],p[1], NVG_PT_CORNER);
 			}
 			i += 7;
 			break;
@@ -1418,6 +1866,11 @@ static void nvg__flattenPaths(NVGcontext* ctx)
 			nvg__pathWinding(ctx, (int)ctx->commands[i+1]);
 			i += 2;
 			break;
+		case NVG_POLYLINE:
+			nvg__addPath(ctx);
+			nvg__addPoints(ctx, &ctx->commands[i+2], (int)ctx->commands[i+1], NVG_PT_CORNER);
+			i += 2 + (int)ctx->commands[i+1]*2;
+			break;
 		default:
 			i++;
 		}
@@ -1425,44 +1878,60 @@ static void nvg__flattenPaths(NVGcontext* ctx)
 
 	cache->bounds[0] = cache->bounds[1] = 1e6f;
 	cache->bounds[2] = cache->bounds[3] = -1e6f;
+#ifdef NVG_SIMD
+	bounds[0] = bounds[1] = nvg__v4set1(1e6f);
+	bounds[2] = bounds[3] = nvg__v4set1(-1e6f);
+#endif
 
 	// Calculate the direction and length of line segments.
 	for (j = 0; j < cache->npaths; j++) {
 		path = &cache->paths[j];
-		pts = &cache->points[path->first];
+		pts = nvg__pathPoints(cache, path);
 
 		// If the first and last points are the same, remove the last, mark as closed path.
-		p0 = &pts[path->count-1];
-		p1 = &pts[0];
-		if (nvg__ptEquals(p0->x,p0->y, p1->x,p1->y, ctx->distTol)) {
+		i0 = path->count-1;
+		if (nvg__ptEquals(pts.x[i0],pts.y[i0], pts.x[0],pts.y[0], ctx->distTol)) {
 			path->count--;
-			p0 = &pts[path->count-1];
 			path->closed = 1;
 		}
 
 		// Enforce winding.
 		if (path->count > 2) {
-			area = nvg__polyArea(pts, path->count);
+			area = nvg__polyArea(&pts, path->count);
 			if (path->winding == NVG_CCW && area < 0.0f)
-				nvg__polyReverse(pts, path->count);
+				nvg__polyReverse(&pts, path->count);
 			if (path->winding == NVG_CW && area > 0.0f)
-				nvg__polyReverse(pts, path->count);
+				nvg__polyReverse(&pts, path->count);
 		}
 
-		for(i = 0; i < path->count; i++) {
+		i = 0;
+#ifdef NVG_SIMD
+		for (; i+4 < path->count; i += 4, nbatches++)
+			nvg__segmentDirs4(&pts, i, bounds);
+#endif
+		for (; i < path->count; i++) {
+			i1 = (i+1 < path->count) ? i+1 : 0;
 			// Calculate segment direction and length
-			p0->dx = p1->x - p0->x;
-			p0->dy = p1->y - p0->y;
-			p0->len = nvg__normalize(&p0->dx, &p0->dy);
+			pts.dx[i] = pts.x[i1] - pts.x[i];
+			pts.dy[i] = pts.y[i1] - pts.y[i];
+			pts.len[i] = nvg__normalize(&pts.dx[i], &pts.dy[i]);
 			// Update bounds
-			cache->bounds[0] = nvg__minf(cache->bounds[0], p0->x);
-			cache->bounds[1] = nvg__minf(cache->bounds[1], p0->y);
-			cache->bounds[2] = nvg__maxf(cache->bounds[2], p0->x);
-			cache->bounds[3] = nvg__maxf(cache->bounds[3], p0->y);
-			// Advance
-			p0 = p1++;
+			cache->bounds[0] = nvg__minf(cache->bounds[0], pts.x[i]);
+			cache->bounds[1] = nvg__minf(cache->bounds[1], pts.y[i]);
+			cache->bounds[2] = nvg__maxf(cache->bounds[2], pts.x[i]);
+			cache->bounds[3] = nvg__maxf(cache->bounds[3], pts.y[i]);
 		}
 	}
+#ifdef NVG_SIMD
+	for (j = 0; j < 4 && nbatches > 0; j++) {
+		float b[4];
+		nvg__v4store(b, bounds[j]);
+		for (i = 0; i < 4; i++)
+			cache->bounds[j] = j < 2 ? nvg__minf(cache->bounds[j], b[i]) : nvg__maxf(cache->bounds[j], b[i]);
+	}
+#endif
+
+	NVG_TIMER_STOP(ctx, flattenTime, startTime);
 }
 
 static int nvg__curveDivs(float r, float arc, float tol)
@@ -1621,22 +2090,22 @@ static NVGvertex* nvg__bevelJoin(NVGvertex* dst, NVGpoint* p0, NVGpoint* p1,
 	return dst;
 }
 
-static NVGvertex* nvg_insertSpacer(NVGvertex* dst, NVGpoint* p, float dx, float dy, float w, float u0, float u1, float t){
+static NVGvertex* nvg_insertSpacer(NVGvertex* dst, float x, float y, float dx, float dy, float w, float u0, float u1, float t){
 	float dlx = dy;
 	float dly = -dx;
-	float px = p->x;
-	float py = p->y;
+	float px = x;
+	float py = y;
 	nvg__vset(dst, px + dlx*w, py + dly*w, u0,1,-1, t); dst++;
 	nvg__vset(dst, px - dlx*w, py - dly*w, u1,1, 1, t); dst++;
 	return dst;
 }
 
-static NVGvertex* nvg__buttCapStart(NVGvertex* dst, NVGpoint* p,
+static NVGvertex* nvg__buttCapStart(NVGvertex* dst, float x, float y,
 									float dx, float dy, float w, float d,
 									float aa, float u0, float u1)
 {
-	float px = p->x - dx*d;
-	float py = p->y - dy*d;
+	float px = x - dx*d;
+	float py = y - dy*d;
 	float dlx = dy;
 	float dly = -dx;
 	nvg__vset(dst, px + dlx*w - dx*aa, py + dly*w - dy*aa, u0,0, -1, -aa); dst++;
@@ -1646,12 +2115,12 @@ static NVGvertex* nvg__buttCapStart(NVGvertex* dst, NVGpoint* p,
 	return dst;
 }
 
-static NVGvertex* nvg__buttCapEnd(NVGvertex* dst, NVGpoint* p,
+static NVGvertex* nvg__buttCapEnd(NVGvertex* dst, float x, float y,
 								  float dx, float dy, float w, float d,
 								  float aa, float u0, float u1, float t)
 {
-	float px = p->x + dx*d;
-	float py = p->y + dy*d;
+	float px = x + dx*d;
+	float py = y + dy*d;
 	float dlx = dy;
 	float dly = -dx;
 	nvg__vset(dst, px + dlx*w, py + dly*w, u0, 1 , -1, t); dst++;
@@ -1662,13 +2131,13 @@ static NVGvertex* nvg__buttCapEnd(NVGvertex* dst, NVGpoint* p,
 }
 
 
-static NVGvertex* nvg__roundCapStart(NVGvertex* dst, NVGpoint* p,
+static NVGvertex* nvg__roundCapStart(NVGvertex* dst, float x, float y,
 									 float dx, float dy, float w, int ncap,
 									 float aa, float u0, float u1)
 {
 	int i;
-	float px = p->x;
-	float py = p->y;
+	float px = x;
+	float py = y;
 	float dlx = dy;
 	float dly = -dx;
 	NVG_NOTUSED(aa);
@@ -1683,13 +2152,13 @@ static NVGvertex* nvg__roundCapStart(NVGvertex* dst, NVGpoint* p,
 	return dst;
 }
 
-static NVGvertex* nvg__roundCapEnd(NVGvertex* dst, NVGpoint* p,
+static NVGvertex* nvg__roundCapEnd(NVGvertex* dst, float x, float y,
 								   float dx, float dy, float w, int ncap,
 								   float aa, float u0, float u1, float t)
 {
 	int i;
-	float px = p->x;
-	float py = p->y;
+	float px = x;
+	float py = y;
 	float dlx = dy;
 	float dly = -dx;
 	NVG_NOTUSED(aa);
@@ -1705,78 +2174,144 @@ static NVGvertex* nvg__roundCapEnd(NVGvertex* dst, NVGpoint* p,
 }
 
 
-static void nvg__calculateJoins(NVGcontext* ctx, float w, int lineJoin, float miterLimit)
+static void nvg__joinPoint(NVGpoints* pts, int i0, int i1, float iw, float miterLimit, int bevelCorners,
+						   int* nleft, int* nbevel)
+{
+	float dlx0, dly0, dlx1, dly1, dmx, dmy, dmr2, cross, limit;
+	int flags;
+	dlx0 = pts->dy[i0];
+	dly0 = -pts->dx[i0];
+	dlx1 = pts->dy[i1];
+	dly1 = -pts->dx[i1];
+	// Calculate extrusions
+	dmx = (dlx0 + dlx1) * 0.5f;
+	dmy = (dly0 + dly1) * 0.5f;
+	dmr2 = dmx*dmx + dmy*dmy;
+	if (dmr2 > 0.000001f) {
+		float scale = 1.0f / dmr2;
+		if (scale > 600.0f) {
+			scale = 600.0f;
+		}
+		dmx *= scale;
+		dmy *= scale;
+	}
+	pts->dmx[i1] = dmx;
+	pts->dmy[i1] = dmy;
+
+	// Clear flags, but keep the corner.
+	flags = (pts->flags[i1] & NVG_PT_CORNER) ? NVG_PT_CORNER : 0;
+
+	// Keep track of left turns.
+	cross = pts->dx[i1] * pts->dy[i0] - pts->dx[i0] * pts->dy[i1];
+	if (cross > 0.0f) {
+		(*nleft)++;
+		flags |= NVG_PT_LEFT;
+	}
+
+	// Calculate if we should use bevel or miter for inner join.
+	limit = nvg__maxf(1.01f, nvg__minf(pts->len[i0], pts->len[i1]) * iw);
+	if ((dmr2 * limit*limit) < 1.0f)
+		flags |= NVG_PR_INNERBEVEL;
+
+	// Check to see if the corner needs to be beveled.
+	if (flags & NVG_PT_CORNER) {
+		if ((dmr2 * miterLimit*miterLimit) < 1.0f || bevelCorners) {
+			flags |= NVG_PT_BEVEL;
+		}
+	}
+
+	if ((flags & (NVG_PT_BEVEL | NVG_PR_INNERBEVEL)) != 0)
+		(*nbevel)++;
+	pts->flags[i1] = (unsigned char)flags;
+}
+
+#ifdef NVG_SIMD
+// Calculates the joins of the four consecutive points starting at j, j must be at least 1.
+static void nvg__joinPoints4(NVGpoints* pts, int j, float iw, float miterLimit, int bevelCorners,
+							 int* nleft, int* nbevel)
+{
+	nvg__v4 dx0 = nvg__v4load(&pts->dx[j-1]);
+	nvg__v4 dy0 = nvg__v4load(&pts->dy[j-1]);
+	nvg__v4 dx1 = nvg__v4load(&pts->dx[j]);
+	nvg__v4 dy1 = nvg__v4load(&pts->dy[j]);
+	nvg__v4 one = nvg__v4set1(1.0f);
+	nvg__v4 dmx, dmy, dmr2, scale, cross, limit;
+	nvg__m4 valid;
+	int left, inner, miter, i;
+
+	// Calculate extrusions
+	dmx = nvg__v4mul(nvg__v4add(dy0, dy1), nvg__v4set1(0.5f));
+	dmy = nvg__v4mul(nvg__v4add(dx0, dx1), nvg__v4set1(-0.5f));
+	dmr2 = nvg__v4add(nvg__v4mul(dmx, dmx), nvg__v4mul(dmy, dmy));
+	valid = nvg__v4gt(dmr2, nvg__v4set1(0.000001f));
+	scale = nvg__v4min(nvg__v4div(one, dmr2), nvg__v4set1(600.0f));
+	nvg__v4store(&pts->dmx[j], nvg__v4sel(valid, nvg__v4mul(dmx, scale), dmx));
+	nvg__v4store(&pts->dmy[j], nvg__v4sel(valid, nvg__v4mul(dmy, scale), dmy));
+
+	// Left turns, inner bevels and miters over the limit as bit masks.
+	cross = nvg__v4sub(nvg__v4mul(dx1, dy0), nvg__v4mul(dx0, dy1));
+	left = nvg__v4bits(nvg__v4gt(cross, nvg__v4set1(0.0f)));
+	limit = nvg__v4mul(nvg__v4min(nvg__v4load(&pts->len[j-1]), nvg__v4load(&pts->len[j])), nvg__v4set1(iw));
+	limit = nvg__v4max(nvg__v4set1(1.01f), limit);
+	inner = nvg__v4bits(nvg__v4lt(nvg__v4mul(nvg__v4mul(dmr2, limit), limit), one));
+	if (bevelCorners)
+		miter = 0xf;
+	else
+		miter = nvg__v4bits(nvg__v4lt(nvg__v4mul(nvg__v4mul(dmr2, nvg__v4set1(miterLimit)), nvg__v4set1(miterLimit)), one));
+
+	for (i = 0; i < 4; i++) {
+		int flags = (pts->flags[j+i] & NVG_PT_CORNER) ? NVG_PT_CORNER : 0;
+		if (left & (1 << i)) {
+			(*nleft)++;
+			flags |= NVG_PT_LEFT;
+		}
+		if (inner & (1 << i))
+			flags |= NVG_PR_INNERBEVEL;
+		if ((flags & NVG_PT_CORNER) && (miter & (1 << i)))
+			flags |= NVG_PT_BEVEL;
+		if ((flags & (NVG_PT_BEVEL | NVG_PR_INNERBEVEL)) != 0)
+			(*nbevel)++;
+		pts->flags[j+i] = (unsigned char)flags;
+	}
+}
+#endif
+
+static void nvg__calculateJoins(NVGcontext* ctx, float w, int lineJoin, float miterLimit, int innerBevels)
 {
 	NVGpathCache* cache = ctx->cache;
 	int i, j;
 	float iw = 0.0f;
+	int bevelCorners = lineJoin == NVG_BEVEL || lineJoin == NVG_ROUND;
 
-	if (w > 0.0f) iw = 1.0f / w;
+	if (w > 0.0f) iw = innerBevels ? 1.0f / w : 1e6f; // Only segments shorter than 1e-6 get inner bevels.
 
 	// Calculate which joins needs extra vertices to append, and gather vertex count.
 	for (i = 0; i < cache->npaths; i++) {
 		NVGpath* path = &cache->paths[i];
-		NVGpoint* pts = &cache->points[path->first];
-		NVGpoint* p0 = &pts[path->count-1];
-		NVGpoint* p1 = &pts[0];
+		NVGpoints pts = nvg__pathPoints(cache, path);
 		int nleft = 0;
 
 		path->nbevel = 0;
-
-		for (j = 0; j < path->count; j++) {
-			float dlx0, dly0, dlx1, dly1, dmr2, cross, limit;
-			dlx0 = p0->dy;
-			dly0 = -p0->dx;
-			dlx1 = p1->dy;
-			dly1 = -p1->dx;
-			// Calculate extrusions
-			p1->dmx = (dlx0 + dlx1) * 0.5f;
-			p1->dmy = (dly0 + dly1) * 0.5f;
-			dmr2 = p1->dmx*p1->dmx + p1->dmy*p1->dmy;
-			if (dmr2 > 0.000001f) {
-				float scale = 1.0f / dmr2;
-				if (scale > 600.0f) {
-					scale = 600.0f;
-				}
-				p1->dmx *= scale;
-				p1->dmy *= scale;
-			}
-
-			// Clear flags, but keep the corner.
-			p1->flags = (p1->flags & NVG_PT_CORNER) ? NVG_PT_CORNER : 0;
-
-			// Keep track of left turns.
-			cross = p1->dx * p0->dy - p0->dx * p1->dy;
-			if (cross > 0.0f) {
-				nleft++;
-				p1->flags |= NVG_PT_LEFT;
-			}
-
-			// Calculate if we should use bevel or miter for inner join.
-			limit = nvg__maxf(1.01f, nvg__minf(p0->len, p1->len) * iw);
-			if ((dmr2 * limit*limit) < 1.0f)
-				p1->flags |= NVG_PR_INNERBEVEL;
-
-			// Check to see if the corner needs to be beveled.
-			if (p1->flags & NVG_PT_CORNER) {
-				if ((dmr2 * miterLimit*miterLimit) < 1.0f || lineJoin == NVG_BEVEL || lineJoin == NVG_ROUND) {
-					p1->flags |= NVG_PT_BEVEL;
-				}
-			}
-
-			if ((p1->flags & (NVG_PT_BEVEL | NVG_PR_INNERBEVEL)) != 0)
-				path->nbevel++;
-
-			p0 = p1++;
+		if (path->count == 0) {
+			path->convex = 1;
+			continue;
 		}
 
+		nvg__joinPoint(&pts, path->count-1, 0, iw, miterLimit, bevelCorners, &nleft, &path->nbevel);
+		j = 1;
+#ifdef NVG_SIMD
+		for (; j+4 <= path->count; j += 4)
+			nvg__joinPoints4(&pts, j, iw, miterLimit, bevelCorners, &nleft, &path->nbevel);
+#endif
+		for (; j < path->count; j++)
+			nvg__joinPoint(&pts, j-1, j, iw, miterLimit, bevelCorners, &nleft, &path->nbevel);
+
 		path->convex = (nleft == path->count) ? 1 : 0;
 	}
 }
 
 
-
-static int nvg__expandStroke(NVGcontext* ctx, float w, float fringe, int lineCap, int lineJoin, int lineStyle, float miterLimit)
+static int nvg__expandStroke(NVGcontext* ctx, float w, float fringe, int lineCap, int lineJoin, int lineStyle, float miterLimit, int innerBevels)
 {
 	NVGpathCache* cache = ctx->cache;
 	NVGvertex* verts;
@@ -1786,6 +2321,7 @@ static int nvg__expandStroke(NVGcontext* ctx, float w, float fringe, int lineCap
 	float aa = fringe;//ctx->fringeWidth;
 	float u0 = 0.0f, u1 = 1.0f;
 	int ncap = nvg__curveDivs(w, NVG_PI, ctx->tessTol);	// Calculate divisions per half circle.
+	double startTime = NVG_TIMER_START();
 
 	w += aa * 0.5f;
 	const float invStrokeWidth = 1.0 / w;
@@ -1798,7 +2334,7 @@ static int nvg__expandStroke(NVGcontext* ctx, float w, float fringe, int lineCap
 	// Force round join to minimize distortion
 	if(lineStyle > 1) lineJoin = NVG_ROUND;
 
-	nvg__calculateJoins(ctx, w, lineJoin, miterLimit);
+	nvg__calculateJoins(ctx, w, lineJoin, miterLimit, innerBevels);
 	// Calculate max vertex usage.
 	cverts = 0;
 	for (i = 0; i < cache->npaths; i++) {
@@ -1825,10 +2361,8 @@ static int nvg__expandStroke(NVGcontext* ctx, float w, float fringe, int lineCap
 
 	for (i = 0; i < cache->npaths; i++) {
 		NVGpath* path = &cache->paths[i];
-		NVGpoint* pts = &cache->points[path->first];
-		NVGpoint* p0;
-		NVGpoint* p1;
-		int s, e, loop;
+		NVGpoints pts = nvg__pathPoints(cache, path);
+		int i0, i1, s, e, loop;
 		float dx, dy;
 
 		path->fill = 0;
@@ -1842,51 +2376,54 @@ static int nvg__expandStroke(NVGcontext* ctx, float w, float fringe, int lineCap
 
 		if (loop) {
 			// Looping
-			p0 = &pts[path->count-1];
-			p1 = &pts[0];
+			i0 = path->count-1;
+			i1 = 0;
 			s = 0;
 			e = path->count;
 		} else {
 			// Add cap
-			p0 = &pts[0];
-			p1 = &pts[1];
+			i0 = 0;
+			i1 = 1;
 			s = 1;
 			e = path->count-1;
 		}
 
 		if (loop == 0) {
 			// Add cap
-			dx = p1->x - p0->x;
-			dy = p1->y - p0->y;
+			dx = pts.x[i1] - pts.x[i0];
+			dy = pts.y[i1] - pts.y[i0];
 			nvg__normalize(&dx, &dy);
 			if (lineCap == NVG_BUTT)
-				dst = nvg__buttCapStart(dst, p0, dx, dy, w, -aa*0.5f, aa, u0, u1);
+				dst = nvg__buttCapStart(dst, pts.x[i0], pts.y[i0], dx, dy, w, -aa*0.5f, aa, u0, u1);
 			else if (lineCap == NVG_BUTT || lineCap == NVG_SQUARE)
-				dst = nvg__buttCapStart(dst, p0, dx, dy, w, w-aa, aa, u0, u1);
+				dst = nvg__buttCapStart(dst, pts.x[i0], pts.y[i0], dx, dy, w, w-aa, aa, u0, u1);
 			else if (lineCap == NVG_ROUND)
-				dst = nvg__roundCapStart(dst, p0, dx, dy, w, ncap, aa, u0, u1);
+				dst = nvg__roundCapStart(dst, pts.x[i0], pts.y[i0], dx, dy, w, ncap, aa, u0, u1);
 		}
 
 		for (j = s; j < e; ++j) {
 			if(lineStyle > 1){
-				dx = p1->x - p0->x;
-				dy = p1->y - p0->y;
+				dx = pts.x[i1] - pts.x[i0];
+				dy = pts.y[i1] - pts.y[i0];
 				float dt=nvg__normalize(&dx, &dy);
-				dst = nvg_insertSpacer(dst, p0, dx, dy, w, u0, u1, t);
+				dst = nvg_insertSpacer(dst, pts.x[i0], pts.y[i0], dx, dy, w, u0, u1, t);
 				t+=dt*invStrokeWidth;
-				dst = nvg_insertSpacer(dst, p1, dx, dy, w, u0, u1, t);
+				dst = nvg_insertSpacer(dst, pts.x[i1], pts.y[i1], dx, dy, w, u0, u1, t);
 			}
-			if ((p1->flags & (NVG_PT_BEVEL | NVG_PR_INNERBEVEL)) != 0) {
+			if ((pts.flags[i1] & (NVG_PT_BEVEL | NVG_PR_INNERBEVEL)) != 0) {
+				NVGpoint p0, p1;
+				nvg__getPoint(&pts, i0, &p0);
+				nvg__getPoint(&pts, i1, &p1);
 				if (lineJoin == NVG_ROUND) {
-					dst = nvg__roundJoin(dst, p0, p1, w, w, u0, u1, ncap, aa, t);
+					dst = nvg__roundJoin(dst, &p0, &p1, w, w, u0, u1, ncap, aa, t);
 				} else {
-					dst = nvg__bevelJoin(dst, p0, p1, w, w, u0, u1, aa, t);
+					dst = nvg__bevelJoin(dst, &p0, &p1, w, w, u0, u1, aa, t);
 				}
 			} else {
-				nvg__vset(dst, p1->x + (p1->dmx * w), p1->y + (p1->dmy * w), u0, 1, -1, t); dst++;
-				nvg__vset(dst, p1->x - (p1->dmx * w), p1->y - (p1->dmy * w), u1, 1, 1, t); dst++;
+				nvg__vset(dst, pts.x[i1] + (pts.dmx[i1] * w), pts.y[i1] + (pts.dmy[i1] * w), u0, 1, -1, t); dst++;
+				nvg__vset(dst, pts.x[i1] - (pts.dmx[i1] * w), pts.y[i1] - (pts.dmy[i1] * w), u1, 1, 1, t); dst++;
 			}
-			p0 = p1++;
+			i0 = i1++;
 		}
 		
 		if (loop) {
@@ -1894,21 +2431,21 @@ static int nvg__expandStroke(NVGcontext* ctx, float w, float fringe, int lineCap
 			nvg__vset(dst, verts[0].x, verts[0].y, u0, 1, -1, t); dst++;
 			nvg__vset(dst, verts[1].x, verts[1].y, u1, 1, 1, t); dst++;
 		} else {
-			dx = p1->x - p0->x;
-			dy = p1->y - p0->y;
+			dx = pts.x[i1] - pts.x[i0];
+			dy = pts.y[i1] - pts.y[i0];
 			float dt = nvg__normalize(&dx, &dy);
 			if(lineStyle > 1){
-				dst = nvg_insertSpacer(dst, p0, dx, dy, w, u0, u1, t);
+				dst = nvg_insertSpacer(dst, pts.x[i0], pts.y[i0], dx, dy, w, u0, u1, t);
 				t+=dt*invStrokeWidth;
-				dst = nvg_insertSpacer(dst, p1, dx, dy, w, u0, u1, t);
+				dst = nvg_insertSpacer(dst, pts.x[i1], pts.y[i1], dx, dy, w, u0, u1, t);
 			}
 			// Add cap
 			if (lineCap == NVG_BUTT)
-				dst = nvg__buttCapEnd(dst, p1, dx, dy, w, -aa*0.5f, aa, u0, u1, t);
+				dst = nvg__buttCapEnd(dst, pts.x[i1], pts.y[i1], dx, dy, w, -aa*0.5f, aa, u0, u1, t);
 			else if (lineCap == NVG_BUTT || lineCap == NVG_SQUARE)
-				dst = nvg__buttCapEnd(dst, p1, dx, dy, w, w-aa, aa, u0, u1, t);
+				dst = nvg__buttCapEnd(dst, pts.x[i1], pts.y[i1], dx, dy, w, w-aa, aa, u0, u1, t);
 			else if (lineCap == NVG_ROUND)
-				dst = nvg__roundCapEnd(dst, p1, dx, dy, w, ncap, aa, u0, u1, t);
+				dst = nvg__roundCapEnd(dst, pts.x[i1], pts.y[i1], dx, dy, w, ncap, aa, u0, u1, t);
 		}
 
 		path->nstroke = (int)(dst - verts);
@@ -1916,6 +2453,9 @@ static int nvg__expandStroke(NVGcontext* ctx, float w, float fringe, int lineCap
 		verts = dst;
 	}
 
+	NVG_STAT_ADD(ctx, verts, (int)(verts - cache->verts));
+	NVG_TIMER_STOP(ctx, expandTime, startTime);
+
 	return 1;
 }
 
@@ -1927,8 +2467,9 @@ static int nvg__expandFill(NVGcontext* ctx, float w, int lineJoin, float miterLi
 	int cverts, convex, i, j;
 	float aa = ctx->fringeWidth;
 	int fringe = w > 0.0f;
+	double startTime = NVG_TIMER_START();
 
-	nvg__calculateJoins(ctx, w, lineJoin, miterLimit);
+	nvg__calculateJoins(ctx, w, lineJoin, miterLimit, 1);
 
 	// Calculate max vertex usage.
 	cverts = 0;
@@ -1946,9 +2487,8 @@ static int nvg__expandFill(NVGcontext* ctx, float w, int lineJoin, float miterLi
 
 	for (i = 0; i < cache->npaths; i++) {
 		NVGpath* path = &cache->paths[i];
-		NVGpoint* pts = &cache->points[path->first];
-		NVGpoint* p0;
-		NVGpoint* p1;
+		NVGpoints pts = nvg__pathPoints(cache, path);
+		int i0, i1;
 		float rw, lw, woff;
 		float ru, lu;
 
@@ -1959,34 +2499,34 @@ static int nvg__expandFill(NVGcontext* ctx, float w, int lineJoin, float miterLi
 
 		if (fringe) {
 			// Looping
-			p0 = &pts[path->count-1];
-			p1 = &pts[0];
+			i0 = path->count-1;
+			i1 = 0;
 			for (j = 0; j < path->count; ++j) {
-				if (p1->flags & NVG_PT_BEVEL) {
-					float dlx0 = p0->dy;
-					float dly0 = -p0->dx;
-					float dlx1 = p1->dy;
-					float dly1 = -p1->dx;
-					if (p1->flags & NVG_PT_LEFT) {
-						float lx = p1->x + p1->dmx * woff;
-						float ly = p1->y + p1->dmy * woff;
+				if (pts.flags[i1] & NVG_PT_BEVEL) {
+					float dlx0 = pts.dy[i0];
+					float dly0 = -pts.dx[i0];
+					float dlx1 = pts.dy[i1];
+					float dly1 = -pts.dx[i1];
+					if (pts.flags[i1] & NVG_PT_LEFT) {
+						float lx = pts.x[i1] + pts.dmx[i1] * woff;
+						float ly = pts.y[i1] + pts.dmy[i1] * woff;
 						nvg__vset(dst, lx, ly, 0.5f, 1, 0, 0); dst++;
 					} else {
-						float lx0 = p1->x + dlx0 * woff;
-						float ly0 = p1->y + dly0 * woff;
-						float lx1 = p1->x + dlx1 * woff;
-						float ly1 = p1->y + dly1 * woff;
+						float lx0 = pts.x[i1] + dlx0 * woff;
+						float ly0 = pts.y[i1] + dly0 * woff;
+						float lx1 = pts.x[i1] + dlx1 * woff;
+						float ly1 = pts.y[i1] + dly1 * woff;
 						nvg__vset(dst, lx0, ly0, 0.5f, 1, 0, 0); dst++;
 						nvg__vset(dst, lx1, ly1, 0.5f, 1, 0, 0); dst++;
 					}
 				} else {
-					nvg__vset(dst, p1->x + (p1->dmx * woff), p1->y + (p1->dmy * woff), 0.5f,1, 0, 0); dst++;
+					nvg__vset(dst, pts.x[i1] + (pts.dmx[i1] * woff), pts.y[i1] + (pts.dmy[i1] * woff), 0.5f,1, 0, 0); dst++;
 				}
-				p0 = p1++;
+				i0 = i1++;
 			}
 		} else {
 			for (j = 0; j < path->count; ++j) {
-				nvg__vset(dst, pts[j].x, pts[j].y, 0.5f, 1, 0, 0);
+				nvg__vset(dst, pts.x[j], pts.y[j], 0.5f, 1, 0, 0);
 				dst++;
 			}
 		}
@@ -2011,17 +2551,20 @@ static int nvg__expandFill(NVGcontext* ctx, float w, int lineJoin, float miterLi
 			}
 
 			// Looping
-			p0 = &pts[path->count-1];
-			p1 = &pts[0];
+			i0 = path->count-1;
+			i1 = 0;
 
 			for (j = 0; j < path->count; ++j) {
-				if ((p1->flags & (NVG_PT_BEVEL | NVG_PR_INNERBEVEL)) != 0) {
-					dst = nvg__bevelJoin(dst, p0, p1, lw, rw, lu, ru, ctx->fringeWidth, 0);
+				if ((pts.flags[i1] & (NVG_PT_BEVEL | NVG_PR_INNERBEVEL)) != 0) {
+					NVGpoint p0, p1;
+					nvg__getPoint(&pts, i0, &p0);
+					nvg__getPoint(&pts, i1, &p1);
+					dst = nvg__bevelJoin(dst, &p0, &p1, lw, rw, lu, ru, ctx->fringeWidth, 0);
 				} else {
-					nvg__vset(dst, p1->x + (p1->dmx * lw), p1->y + (p1->dmy * lw), lu,1,0, 0); dst++;
-					nvg__vset(dst, p1->x - (p1->dmx * rw), p1->y - (p1->dmy * rw), ru,1,0, 0); dst++;
+					nvg__vset(dst, pts.x[i1] + (pts.dmx[i1] * lw), pts.y[i1] + (pts.dmy[i1] * lw), lu,1,0, 0); dst++;
+					nvg__vset(dst, pts.x[i1] - (pts.dmx[i1] * rw), pts.y[i1] - (pts.dmy[i1] * rw), ru,1,0, 0); dst++;
 				}
-				p0 = p1++;
+				i0 = i1++;
 			}
 
 			// Loop it
@@ -2036,6 +2579,9 @@ static int nvg__expandFill(NVGcontext* ctx, float w, int lineJoin, float miterLi
 		}
 	}
 
+	NVG_STAT_ADD(ctx, verts, (int)(verts - cache->verts));
+	NVG_TIMER_STOP(ctx, expandTime, startTime);
+
 	return 1;
 }
 
@@ -2272,6 +2818,50 @@ void nvgCircle(NVGcontext* ctx, float cx, float cy, float r)
 	nvgEllipse(ctx, cx,cy, r,r);
 }
 
+void nvgPolyline(NVGcontext* ctx, const float* xy, int n, int closed)
+{
+	nvgPolylineStrided(ctx, &xy[0], &xy[1], n, sizeof(float)*2, closed ? NVG_POLYLINE_CLOSED : 0);
+}
+
+void nvgPolylineStrided(NVGcontext* ctx, const float* x, const float* y, int n, int stride, int flags)
+{
+	NVGstate* state = nvg__getState(ctx);
+	const char* px = (const char*)x;
+	const char* py = (const char*)y;
+	float* vals;
+	int i;
+
+	if (n < 1) return;
+	if (nvg__reserveCommands(ctx, 2 + n*2 + 1) == 0) return;
+
+	// Gather the points straight into the command buffer and transform them there.
+	vals = &ctx->commands[ctx->ncommands];
+	if (stride == sizeof(float)*2 && py == px + sizeof(float)) {
+		memcpy(&vals[2], x, sizeof(float)*2*n);
+	} else {
+		for (i = 0; i < n; i++) {
+			vals[2+i*2] = *(const float*)(px + (size_t)i*stride);
+			vals[2+i*2+1] = *(const float*)(py + (size_t)i*stride);
+		}
+	}
+	ctx->commandx = vals[2+(n-1)*2];
+	ctx->commandy = vals[2+(n-1)*2+1];
+
+	nvg__transformPoints(&vals[2], n, state->xform);
+	if (flags & NVG_POLYLINE_DECIMATE)
+		n = nvg__decimatePoints(&vals[2], n, ctx->devicePxRatio);
+
+	vals[0] = NVG_POLYLINE;
+	vals[1] = (float)n;
+	ctx->ncommands += 2 + n*2;
+	NVG_STAT_ADD(ctx, commands, 1);
+
+	if (flags & NVG_POLYLINE_CLOSED) {
+		ctx->commands[ctx->ncommands++] = NVG_CLOSE;
+		NVG_STAT_ADD(ctx, commands, 1);
+	}
+}
+
 void nvgDebugDumpPathCache(NVGcontext* ctx)
 {
 	const NVGpath* path;
@@ -2294,88 +2884,724 @@ void nvgDebugDumpPathCache(NVGcontext* ctx)
 	}
 }
 
-void nvgFill(NVGcontext* ctx)
+static void nvg__renderFillPaths(NVGcontext* ctx, const float* bounds, const NVGpath* paths, int npaths)
 {
 	NVGstate* state = nvg__getState(ctx);
 	const NVGpath* path;
 	NVGpaint fillPaint = state->fill;
 	int i;
 
-	nvg__flattenPaths(ctx);
-	if (ctx->params.edgeAntiAlias && state->shapeAntiAlias)
-		nvg__expandFill(ctx, ctx->fringeWidth, NVG_MITER, 2.4f);
-	else
-		nvg__expandFill(ctx, 0.0f, NVG_MITER, 2.4f);
-
 	// Apply global alpha
 	fillPaint.innerColor.a *= state->alpha;
 	fillPaint.outerColor.a *= state->alpha;
 
 	ctx->params.renderFill(ctx->params.userPtr, &fillPaint, state->compositeOperation, &state->scissor, ctx->fringeWidth,
-						   ctx->cache->bounds, ctx->cache->paths, ctx->cache->npaths);
+						   bounds, paths, npaths);
 
 	// Count triangles
-	for (i = 0; i < ctx->cache->npaths; i++) {
-		path = &ctx->cache->paths[i];
-		ctx->fillTriCount += path->nfill-2;
-		ctx->fillTriCount += path->nstroke-2;
-		ctx->drawCallCount += 2;
+	for (i = 0; i < npaths; i++) {
+		path = &paths[i];
+		ctx->stats.fillTris += path->nfill-2;
+		ctx->stats.fillTris += path->nstroke-2;
+		ctx->stats.drawCalls += 2;
 	}
 }
 
-void nvgStroke(NVGcontext* ctx)
+static float nvg__strokePaint(NVGcontext* ctx, NVGpaint* strokePaint)
 {
 	NVGstate* state = nvg__getState(ctx);
 	const float scale = nvg__getAverageScale(state->xform);
 	float strokeWidth = nvg__clampf(state->strokeWidth * scale, 0.0f, 1000.0f);
-	NVGpaint strokePaint = state->stroke;
-	const NVGpath* path;
-	int i;
 
+	*strokePaint = state->stroke;
 
 	if (strokeWidth < ctx->fringeWidth) {
 		// If the stroke width is less than pixel size, use alpha to emulate coverage.
 		// Since coverage is area, scale by alpha*alpha.
 		float alpha = nvg__clampf(strokeWidth / ctx->fringeWidth, 0.0f, 1.0f);
-		strokePaint.innerColor.a *= alpha*alpha;
-		strokePaint.outerColor.a *= alpha*alpha;
+		strokePaint->innerColor.a *= alpha*alpha;
+		strokePaint->outerColor.a *= alpha*alpha;
 		strokeWidth = ctx->fringeWidth;
 	}
 
 	// Apply global alpha
-	strokePaint.innerColor.a *= state->alpha;
-	strokePaint.outerColor.a *= state->alpha;
+	strokePaint->innerColor.a *= state->alpha;
+	strokePaint->outerColor.a *= state->alpha;
 
-	nvg__flattenPaths(ctx);
+	return strokeWidth;
+}
 
-	if (ctx->params.edgeAntiAlias && state->shapeAntiAlias)
-		nvg__expandStroke(ctx, strokeWidth*0.5f, ctx->fringeWidth, state->lineCap, state->lineJoin, state->lineStyle, state->miterLimit);
-	else
-		nvg__expandStroke(ctx, strokeWidth*0.5f, 0.0f, state->lineCap, state->lineJoin, state->lineStyle, state->miterLimit);
+static void nvg__renderStrokePaths(NVGcontext* ctx, NVGpaint* strokePaint, float strokeWidth, const NVGpath* paths, int npaths)
+{
+	NVGstate* state = nvg__getState(ctx);
+	const NVGpath* path;
+	int i;
 
-	ctx->params.renderStroke(ctx->params.userPtr, &strokePaint, state->compositeOperation, &state->scissor, ctx->fringeWidth,
-							 strokeWidth, state->lineStyle, ctx->cache->paths, ctx->cache->npaths);
+	ctx->params.renderStroke(ctx->params.userPtr, strokePaint, state->compositeOperation, &state->scissor, ctx->fringeWidth,
+							 strokeWidth, state->lineStyle, paths, npaths);
 
 	// Count triangles
-	for (i = 0; i < ctx->cache->npaths; i++) {
-		path = &ctx->cache->paths[i];
-		ctx->strokeTriCount += path->nstroke-2;
-		ctx->drawCallCount++;
+	for (i = 0; i < npaths; i++) {
+		path = &paths[i];
+		ctx->stats.strokeTris += path->nstroke-2;
+		ctx->stats.drawCalls++;
 	}
 }
 
-// Add fonts
-int nvgCreateFont(NVGcontext* ctx, const char* name, const char* filename)
-{
-	return fonsAddFont(ctx->fs, name, filename, 0);
-}
-
-int nvgCreateFontAtIndex(NVGcontext* ctx, const char* name, const char* filename, const int fontIndex)
+// Bounds of the control points, which contain the flattened path.
+static void nvg__commandBounds(const float* commands, int ncommands, float* bounds)
 {
-	return fonsAddFont(ctx->fs, name, filename, fontIndex);
+	int i = 0, j, n;
+	bounds[0] = bounds[1] = 1e6f;
+	bounds[2] = bounds[3] = -1e6f;
+	while (i < ncommands) {
+		int cmd = (int)commands[i];
+		const float* p = &commands[i+1];
+		switch (cmd) {
+		case NVG_MOVETO:
+		case NVG_LINETO:
+			n = 1;
+			i += 3;
+			break;
+		case NVG_BEZIERTO:
+			n = 3;
+			i += 7;
+			break;
+		case NVG_POLYLINE:
+			n = (int)commands[i+1];
+			p = &commands[i+2];
+			i += 2 + n*2;
+			break;
+		case NVG_WINDING:
+			n = 0;
+			i += 2;
+			break;
+		default:
+			n = 0;
+			i++;
+		}
+		for (j = 0; j < n; j++) {
+			bounds[0] = nvg__minf(bounds[0], p[j*2]);
+			bounds[1] = nvg__minf(bounds[1], p[j*2+1]);
+			bounds[2] = nvg__maxf(bounds[2], p[j*2]);
+			bounds[3] = nvg__maxf(bounds[3], p[j*2+1]);
+		}
+	}
 }
 
-int nvgCreateFontMem(NVGcontext* ctx, const char* name, unsigned char* data, int ndata, int freeData)
+// Area covered by the solid sub-paths less the holes, from the control points.
+// Curves add their exact area, twice the cross products are weighted as in Green's theorem.
+static float nvg__commandArea(const float* commands, int ncommands)
+{
+	float area = 0.0f, a = 0.0f;
+	float sx = 0.0f, sy = 0.0f, px = 0.0f, py = 0.0f;
+	int i = 0, j, n, winding = NVG_CCW;
+	while (i <= ncommands) {
+		int cmd = i < ncommands ? (int)commands[i] : NVG_MOVETO;
+		const float* p;
+		if (cmd == NVG_MOVETO || cmd == NVG_POLYLINE) {
+			// Close the previous sub-path.
+			a += px*sy - py*sx;
+			area += winding == NVG_CW ? -nvg__absf(a) : nvg__absf(a);
+			a = 0.0f;
+			winding = NVG_CCW;
+			if (i == ncommands) break;
+		}
+		p = &commands[i+1];
+		switch (cmd) {
+		case NVG_MOVETO:
+			sx = px = p[0];
+			sy = py = p[1];
+			i += 3;
+			break;
+		case NVG_LINETO:
+			a += px*p[1] - py*p[0];
+			px = p[0];
+			py = p[1];
+			i += 3;
+			break;
+		case NVG_BEZIERTO:
+			a += (6*(px*p[1] - py*p[0]) + 3*(px*p[3] - py*p[2]) + (px*p[5] - py*p[4]) +
+				  3*(p[0]*p[3] - p[1]*p[2]) + 3*(p[0]*p[5] - p[1]*p[4]) + 6*(p[2]*p[5] - p[3]*p[4])) * 0.1f;
+			px = p[4];
+			py = p[5];
+			i += 7;
+			break;
+		case NVG_POLYLINE:
+			n = (int)commands[i+1];
+			p = &commands[i+2];
+			if (n > 0) {
+				sx = px = p[0];
+				sy = py = p[1];
+			}
+			for (j = 1; j < n; j++) {
+				a += px*p[j*2+1] - py*p[j*2];
+				px = p[j*2];
+				py = p[j*2+1];
+			}
+			i += 2 + n*2;
+			break;
+		case NVG_WINDING:
+			winding = (int)commands[i+1];
+			i += 2;
+			break;
+		default:
+			i++;
+		}
+	}
+	return nvg__maxf(area * 0.5f, 0.0f);
+}
+
+static void nvg__transformBounds(float* dst, const float* xform, const float* bounds)
+{
+	float x, y;
+	int i;
+	dst[0] = dst[1] = 1e6f;
+	dst[2] = dst[3] = -1e6f;
+	for (i = 0; i < 4; i++) {
+		nvgTransformPoint(&x, &y, xform, bounds[(i & 1) ? 2 : 0], bounds[(i & 2) ? 3 : 1]);
+		dst[0] = nvg__minf(dst[0], x);
+		dst[1] = nvg__minf(dst[1], y);
+		dst[2] = nvg__maxf(dst[2], x);
+		dst[3] = nvg__maxf(dst[3], y);
+	}
+}
+
+// Returns 1 if the screen space bounds grown by pad are outside the window or the scissor.
+static int nvg__isCulled(NVGcontext* ctx, const float* bounds, float pad)
+{
+	NVGstate* state = nvg__getState(ctx);
+	const float* sx = state->scissor.xform;
+	float cx, cy, ex, ey;
+
+	if (bounds[0] > bounds[2] || bounds[1] > bounds[3]) return 1; // Empty
+	if (bounds[2] + pad < 0.0f || bounds[3] + pad < 0.0f || bounds[0] - pad > ctx->windowWidth || bounds[1] - pad > ctx->windowHeight)
+		return 1;
+	if (state->scissor.extent[0] < 0.0f) return 0;
+
+	cx = sx[4];
+	cy = sx[5];
+	ex = state->scissor.extent[0]*nvg__absf(sx[0]) + state->scissor.extent[1]*nvg__absf(sx[2]);
+	ey = state->scissor.extent[0]*nvg__absf(sx[1]) + state->scissor.extent[1]*nvg__absf(sx[3]);
+	return bounds[2] + pad < cx - ex || bounds[3] + pad < cy - ey || bounds[0] - pad > cx + ex || bounds[1] - pad > cy + ey;
+}
+
+// How far a stroke can reach past its control points, in screen space.
+static float nvg__strokeCullPad(NVGcontext* ctx, float strokeWidth)
+{
+	NVGstate* state = nvg__getState(ctx);
+	float reach = 1.5f; // Square caps reach sqrt(2) times the half width.
+	if (state->lineJoin == NVG_MITER)
+		reach = nvg__maxf(reach, state->miterLimit);
+	return strokeWidth*0.5f*reach + ctx->fringeWidth;
+}
+
+// Draws a fill that is small on screen as an axis aligned quad of the same area,
+// centered in its bounds. Quads thinner than the fringe are widened and faded instead.
+static void nvg__fillQuad(NVGcontext* ctx, const float* bounds, float area)
+{
+	NVGstate* state = nvg__getState(ctx);
+	NVGpaint fill = state->fill;
+	NVGpath path;
+	NVGvertex* verts;
+	float aa = (ctx->params.edgeAntiAlias && state->shapeAntiAlias) ? ctx->fringeWidth : 0.0f;
+	float woff = aa*0.5f;
+	float w = bounds[2] - bounds[0], h = bounds[3] - bounds[1];
+	float cx = (bounds[0] + bounds[2])*0.5f, cy = (bounds[1] + bounds[3])*0.5f;
+	float qbounds[4], s, alpha;
+	int i;
+
+	if (area <= 0.0f || w <= 0.0f || h <= 0.0f) return;
+	s = sqrtf(area / (w*h));
+	w = nvg__maxf(w*s, ctx->fringeWidth);
+	h = nvg__maxf(h*s, ctx->fringeWidth);
+	alpha = nvg__minf(area / (w*h), 1.0f);
+
+	verts = nvg__allocTempVerts(ctx, 4 + 10);
+	if (verts == NULL) return;
+
+	// Same winding as nvgRect(), dm points inside.
+	qbounds[0] = cx - w*0.5f;
+	qbounds[1] = cy - h*0.5f;
+	qbounds[2] = cx + w*0.5f;
+	qbounds[3] = cy + h*0.5f;
+	for (i = 0; i < 4; i++) {
+		float x = qbounds[(i == 2 || i == 3) ? 2 : 0], y = qbounds[(i == 1 || i == 2) ? 3 : 1];
+		float dmx = (i == 2 || i == 3) ? -1.0f : 1.0f, dmy = (i == 1 || i == 2) ? -1.0f : 1.0f;
+		nvg__vset(&verts[i], x + dmx*woff, y + dmy*woff, 0.5f, 1, 0, 0);
+		if (aa > 0.0f) {
+			nvg__vset(&verts[4 + i*2], x + dmx*woff, y + dmy*woff, 0.5f, 1, 0, 0);
+			nvg__vset(&verts[4 + i*2+1], x - dmx*woff, y - dmy*woff, 1, 1, 0, 0);
+		}
+	}
+	verts[12] = verts[4];
+	verts[13] = verts[5];
+
+	memset(&path, 0, sizeof(path));
+	path.count = 4;
+	path.closed = 1;
+	path.fill = verts;
+	path.nfill = 4;
+	path.stroke = aa > 0.0f ? &verts[4] : NULL;
+	path.nstroke = aa > 0.0f ? 10 : 0;
+	path.winding = NVG_CCW;
+	path.convex = 1;
+
+	state->fill.innerColor.a *= alpha;
+	state->fill.outerColor.a *= alpha;
+	nvg__renderFillPaths(ctx, qbounds, &path, 1);
+	state->fill = fill;
+}
+
+void nvgFill(NVGcontext* ctx)
+{
+	NVGstate* state = nvg__getState(ctx);
+	float bounds[4];
+
+	nvg__commandBounds(ctx->commands, ctx->ncommands, bounds);
+	if (nvg__isCulled(ctx, bounds, ctx->fringeWidth)) {
+		ctx->stats.culledPaths++;
+		return;
+	}
+
+	if (state->shapeLod && bounds[2] - bounds[0] < NVG_LOD_QUAD_SIZE && bounds[3] - bounds[1] < NVG_LOD_QUAD_SIZE) {
+		nvg__fillQuad(ctx, bounds, nvg__commandArea(ctx->commands, ctx->ncommands));
+		return;
+	}
+
+	nvg__flattenPaths(ctx);
+	if (ctx->params.edgeAntiAlias && state->shapeAntiAlias)
+		nvg__expandFill(ctx, ctx->fringeWidth, NVG_MITER, 2.4f);
+	else
+		nvg__expandFill(ctx, 0.0f, NVG_MITER, 2.4f);
+
+	nvg__renderFillPaths(ctx, ctx->cache->bounds, ctx->cache->paths, ctx->cache->npaths);
+}
+
+void nvgStroke(NVGcontext* ctx)
+{
+	NVGstate* state = nvg__getState(ctx);
+	NVGpaint strokePaint;
+	float strokeWidth = nvg__strokePaint(ctx, &strokePaint);
+	float bounds[4];
+	int lineCap = state->lineCap, lineJoin = state->lineJoin, innerBevels = 1;
+
+	nvg__commandBounds(ctx->commands, ctx->ncommands, bounds);
+	if (nvg__isCulled(ctx, bounds, nvg__strokeCullPad(ctx, strokeWidth))) {
+		ctx->stats.culledPaths++;
+		return;
+	}
+
+	if (state->shapeLod && state->strokeWidth * nvg__getAverageScale(state->xform) < ctx->fringeWidth) {
+		// Strokes thinner than a pixel are faded to their coverage, skip the ones that would
+		// not change an 8 bit target. The joins overlap by less than a pixel, so skip the
+		// inner bevels and draw round joins and caps as miter and square ones.
+		if (strokePaint.innerColor.a < 0.5f/255.0f && strokePaint.outerColor.a < 0.5f/255.0f) {
+			ctx->stats.culledPaths++;
+			return;
+		}
+		if (lineJoin == NVG_ROUND)
+			lineJoin = NVG_MITER;
+		if (lineCap == NVG_ROUND)
+			lineCap = NVG_SQUARE;
+		innerBevels = 0;
+	}
+
+	nvg__flattenPaths(ctx);
+
+	if (ctx->params.edgeAntiAlias && state->shapeAntiAlias)
+		nvg__expandStroke(ctx, strokeWidth*0.5f, ctx->fringeWidth, lineCap, lineJoin, state->lineStyle, state->miterLimit, innerBevels);
+	else
+		nvg__expandStroke(ctx, strokeWidth*0.5f, 0.0f, lineCap, lineJoin, state->lineStyle, state->miterLimit, innerBevels);
+
+	nvg__renderStrokePaths(ctx, &strokePaint, strokeWidth, ctx->cache->paths, ctx->cache->npaths);
+}
+
+// Shape batches
+enum NVGshapeType {
+	NVG_SHAPE_RECT,
+	NVG_SHAPE_ROUNDEDRECT,
+	NVG_SHAPE_CIRCLE,
+};
+
+static NVGshapeVertex* nvg__allocShapeVerts(NVGcontext* ctx, int nverts)
+{
+	if (nverts > ctx->cshapeVerts) {
+		NVGshapeVertex* verts;
+		int cverts = (nverts + 0xff) & ~0xff; // Round up to prevent allocations when things change just slightly.
+		verts = (NVGshapeVertex*)realloc(ctx->shapeVerts, sizeof(NVGshapeVertex)*cverts);
+		if (verts == NULL) return NULL;
+		ctx->shapeVerts = verts;
+		ctx->cshapeVerts = cverts;
+	}
+	return ctx->shapeVerts;
+}
+
+// Returns center, half size and corner radius of shape i.
+static void nvg__shapeGeometry(const float* geom, const float* radii, int i, int type, float* s)
+{
+	if (type == NVG_SHAPE_CIRCLE) {
+		s[0] = geom[i*3+0];
+		s[1] = geom[i*3+1];
+		s[2] = s[3] = s[4] = nvg__absf(geom[i*3+2]);
+	} else {
+		s[2] = nvg__absf(geom[i*4+2]) * 0.5f;
+		s[3] = nvg__absf(geom[i*4+3]) * 0.5f;
+		s[0] = geom[i*4+0] + geom[i*4+2] * 0.5f;
+		s[1] = geom[i*4+1] + geom[i*4+3] * 0.5f;
+		s[4] = type == NVG_SHAPE_ROUNDEDRECT ? nvg__clampf(radii[i], 0.0f, nvg__minf(s[2], s[3])) : 0.0f;
+	}
+}
+
+// Draws the shapes as regular filled paths, for back-ends without renderShapes().
+// The path commands and cache are swapped out so that the current path is kept.
+static void nvg__fillShapePaths(NVGcontext* ctx, const float* geom, const float* radii, const NVGcolor* colors, int n, int type)
+{
+	float* commands = ctx->commands;
+	int ncommands = ctx->ncommands, ccommands = ctx->ccommands;
+	float commandx = ctx->commandx, commandy = ctx->commandy;
+	NVGpathCache* cache = ctx->cache;
+	NVGstate* state = nvg__getState(ctx);
+	NVGpaint fill = state->fill;
+	int i;
+
+	ctx->cache = nvg__allocPathCache();
+	if (ctx->cache == NULL) goto error;
+	ctx->commands = NULL;
+	ctx->ncommands = ctx->ccommands = 0;
+
+	for (i = 0; i < n; i++) {
+		float s[5];
+		nvg__shapeGeometry(geom, radii, i, type, s);
+		nvgBeginPath(ctx);
+		if (type == NVG_SHAPE_CIRCLE)
+			nvgCircle(ctx, s[0], s[1], s[2]);
+		else
+			nvgRoundedRect(ctx, s[0] - s[2], s[1] - s[3], s[2]*2, s[3]*2, s[4]);
+		nvgFillColor(ctx, colors[i]);
+		nvgFill(ctx);
+	}
+	state->fill = fill;
+
+	if (ctx->commands != NULL) free(ctx->commands);
+	nvg__deletePathCache(ctx->cache);
+error:
+	ctx->commands = commands;
+	ctx->ncommands = ncommands;
+	ctx->ccommands = ccommands;
+	ctx->commandx = commandx;
+	ctx->commandy = commandy;
+	ctx->cache = cache;
+}
+
+static void nvg__drawShapes(NVGcontext* ctx, const float* geom, const float* radii, const NVGcolor* colors, int n, int type)
+{
+	static const float corners[4][2] = { {-1,-1}, {-1,1}, {1,1}, {1,-1} };
+	NVGstate* state = nvg__getState(ctx);
+	float* t = state->xform;
+	float scale = nvg__maxf(nvg__getAverageScale(t), 1e-6f);
+	float feather = ctx->fringeWidth / scale;
+	NVGshapeVertex* verts;
+	int i, j, k;
+
+	if (n <= 0) return;
+	if (ctx->params.renderShapes == NULL) {
+		nvg__fillShapePaths(ctx, geom, radii, colors, n, type);
+		return;
+	}
+
+	// Without anti-aliasing the edge is made much thinner than a pixel.
+	if (!ctx->params.edgeAntiAlias || !state->shapeAntiAlias)
+		feather *= 0.001f;
+
+	verts = nvg__allocShapeVerts(ctx, n*4);
+	if (verts == NULL) return;
+
+	for (i = 0; i < n; i++) {
+		NVGcolor c = colors[i];
+		unsigned char rgba[4];
+		float s[5], gx, gy;
+		nvg__shapeGeometry(geom, radii, i, type, s);
+		// Grow the quad by the feather so that the anti-aliased edge fits in.
+		gx = s[2] + feather;
+		gy = s[3] + feather;
+		c.a *= state->alpha;
+		for (k = 0; k < 3; k++)
+			rgba[k] = (unsigned char)(nvg__clampf(c.rgba[k] * c.a, 0.0f, 1.0f) * 255.0f + 0.5f);
+		rgba[3] = (unsigned char)(nvg__clampf(c.a, 0.0f, 1.0f) * 255.0f + 0.5f);
+		for (j = 0; j < 4; j++) {
+			NVGshapeVertex* v = &verts[i*4+j];
+			v->u = corners[j][0] * gx;
+			v->v = corners[j][1] * gy;
+			nvgTransformPoint(&v->x, &v->y, t, s[0] + v->u, s[1] + v->v);
+			v->ex = s[2];
+			v->ey = s[3];
+			v->radius = s[4];
+			v->feather = feather;
+			memcpy(v->color, rgba, 4);
+		}
+	}
+
+	ctx->params.renderShapes(ctx->params.userPtr, state->compositeOperation, &state->scissor, ctx->fringeWidth, verts, n*4);
+
+	ctx->stats.drawCalls++;
+	ctx->stats.fillTris += n*2;
+}
+
+void nvgDrawRects(NVGcontext* ctx, const float* rects, const NVGcolor* colors, int n)
+{
+	nvg__drawShapes(ctx, rects, NULL, colors, n, NVG_SHAPE_RECT);
+}
+
+void nvgDrawRoundedRects(NVGcontext* ctx, const float* rects, const float* radii, const NVGcolor* colors, int n)
+{
+	nvg__drawShapes(ctx, rects, radii, colors, n, NVG_SHAPE_ROUNDEDRECT);
+}
+
+void nvgDrawCircles(NVGcontext* ctx, const float* circles, const NVGcolor* colors, int n)
+{
+	nvg__drawShapes(ctx, circles, NULL, colors, n, NVG_SHAPE_CIRCLE);
+}
+
+// Retained paths
+NVGpathRef* nvgCreatePathRef(NVGcontext* ctx)
+{
+	NVGstate* state = nvg__getState(ctx);
+	NVGpathRef* ref = (NVGpathRef*)malloc(sizeof(NVGpathRef));
+	int ncommands = nvg__maxi(ctx->ncommands, 1);
+	if (ref == NULL) goto error;
+	memset(ref, 0, sizeof(NVGpathRef));
+
+	ref->commands = (float*)malloc(sizeof(float)*ncommands);
+	if (ref->commands == NULL) goto error;
+	ref->xcommands = (float*)malloc(sizeof(float)*ncommands);
+	if (ref->xcommands == NULL) goto error;
+	memcpy(ref->commands, ctx->commands, sizeof(float)*ctx->ncommands);
+	ref->ncommands = ctx->ncommands;
+	nvg__commandBounds(ref->commands, ref->ncommands, ref->bounds);
+	// A singular transform has collapsed the path, it could not be drawn under another transform.
+	if (!nvgTransformInverse(ref->invxform, state->xform)) goto error;
+
+	ref->fill.cache = nvg__allocPathCache();
+	if (ref->fill.cache == NULL) goto error;
+	ref->stroke.cache = nvg__allocPathCache();
+	if (ref->stroke.cache == NULL) goto error;
+
+	return ref;
+
+error:
+	nvgDeletePathRef(ctx, ref);
+	return NULL;
+}
+
+void nvgDeletePathRef(NVGcontext* ctx, NVGpathRef* ref)
+{
+	NVG_NOTUSED(ctx);
+	if (ref == NULL) return;
+	if (ref->commands != NULL) free(ref->commands);
+	if (ref->xcommands != NULL) free(ref->xcommands);
+	if (ref->paths != NULL) free(ref->paths);
+	nvg__deletePathCache(ref->fill.cache);
+	nvg__deletePathCache(ref->stroke.cache);
+	free(ref);
+}
+
+static void nvg__tesselatePathRef(NVGcontext* ctx, NVGpathRef* ref, NVGpathRefCache* rc, const float* xform, int stroke)
+{
+	float* commands = ctx->commands;
+	int ncommands = ctx->ncommands;
+	NVGpathCache* cache = ctx->cache;
+
+	memcpy(ref->xcommands, ref->commands, sizeof(float)*ref->ncommands);
+	nvg__transformCommands(ref->xcommands, ref->ncommands, xform);
+
+	// Tessellate using the regular path code with the reference commands and cache bound to the context.
+	ctx->commands = ref->xcommands;
+	ctx->ncommands = ref->ncommands;
+	ctx->cache = rc->cache;
+
+	nvg__clearPathCache(ctx);
+	nvg__flattenPaths(ctx);
+	if (stroke)
+		nvg__expandStroke(ctx, rc->style.strokeWidth*0.5f, rc->style.fringe, rc->style.lineCap, rc->style.lineJoin, rc->style.lineStyle, rc->style.miterLimit, 1);
+	else
+		nvg__expandFill(ctx, rc->style.fringe, NVG_MITER, 2.4f);
+
+	ctx->commands = commands;
+	ctx->ncommands = ncommands;
+	ctx->cache = cache;
+
+	memcpy(rc->xform, xform, sizeof(float)*6);
+	rc->valid = 1;
+}
+
+static int nvg__pathRefReusable(NVGcontext* ctx, NVGpathRefCache* rc, const NVGpathRefStyle* style, const float* xform, float* d)
+{
+	float inv[6], s;
+
+	if (!rc->valid) return 0;
+	if (style->fringe != rc->style.fringe || style->tessTol != rc->style.tessTol ||
+		style->lineCap != rc->style.lineCap || style->lineJoin != rc->style.lineJoin ||
+		style->lineStyle != rc->style.lineStyle || style->miterLimit != rc->style.miterLimit)
+		return 0;
+
+	// Transform from the cached geometry to the requested one.
+	nvgTransformInverse(inv, rc->xform);
+	memcpy(d, inv, sizeof(float)*6);
+	nvgTransformMultiply(d, xform);
+
+	// Only rotation, translation and uniform scale keep the vertices valid when moved.
+	s = nvg__sqrtf(d[0]*d[0] + d[1]*d[1]);
+	if (nvg__absf(d[0] - d[3]) > s*1e-4f || nvg__absf(d[1] + d[2]) > s*1e-4f)
+		return 0;
+
+	// Scaling moves the fringe and stroke edges, allow it as long as they stay within tessellation tolerance.
+	if (nvg__absf(s - 1.0f) * ctx->fringeWidth > ctx->tessTol)
+		return 0;
+	if (nvg__absf(rc->style.strokeWidth*s - style->strokeWidth)*0.5f > ctx->tessTol)
+		return 0;
+
+	return 1;
+}
+
+static const NVGpath* nvg__movePathRef(NVGcontext* ctx, NVGpathRef* ref, NVGpathRefCache* rc, const float* xform, const float* d, float* bounds)
+{
+	NVGpathCache* cache = rc->cache;
+	NVGvertex* verts;
+	NVGvertex* end = cache->verts;
+	int i, nverts;
+
+	if (memcmp(xform, rc->xform, sizeof(float)*6) == 0) {
+		memcpy(bounds, cache->bounds, sizeof(float)*4);
+		return cache->paths;
+	}
+
+	if (cache->npaths > ref->cpaths) {
+		NVGpath* paths = (NVGpath*)realloc(ref->paths, sizeof(NVGpath)*cache->npaths);
+		if (paths == NULL) return NULL;
+		ref->paths = paths;
+		ref->cpaths = cache->npaths;
+	}
+
+	for (i = 0; i < cache->npaths; i++) {
+		NVGpath* path = &cache->paths[i];
+		if (path->fill != NULL && path->fill + path->nfill > end) end = path->fill + path->nfill;
+		if (path->stroke != NULL && path->stroke + path->nstroke > end) end = path->stroke + path->nstroke;
+	}
+	nverts = (int)(end - cache->verts);
+
+	verts = nvg__allocTempVerts(ctx, nverts);
+	if (verts == NULL) return NULL;
+
+	for (i = 0; i < nverts; i++) {
+		const NVGvertex* src = &cache->verts[i];
+		verts[i] = *src;
+		verts[i].x = src->x*d[0] + src->y*d[2] + d[4];
+		verts[i].y = src->x*d[1] + src->y*d[3] + d[5];
+	}
+
+	for (i = 0; i < cache->npaths; i++) {
+		NVGpath* path = &ref->paths[i];
+		*path = cache->paths[i];
+		if (path->fill != NULL) path->fill = verts + (path->fill - cache->verts);
+		if (path->stroke != NULL) path->stroke = verts + (path->stroke - cache->verts);
+	}
+
+	nvg__transformBounds(bounds, d, cache->bounds);
+
+	return ref->paths;
+}
+
+static int nvg__isPathRefCulled(NVGcontext* ctx, NVGpathRef* ref, float pad)
+{
+	NVGstate* state = nvg__getState(ctx);
+	float xform[6], bounds[4];
+	memcpy(xform, ref->invxform, sizeof(float)*6);
+	nvgTransformMultiply(xform, state->xform);
+	nvg__transformBounds(bounds, xform, ref->bounds);
+	if (nvg__isCulled(ctx, bounds, pad)) {
+		ctx->stats.culledPaths++;
+		return 1;
+	}
+	return 0;
+}
+
+static const NVGpath* nvg__preparePathRef(NVGcontext* ctx, NVGpathRef* ref, NVGpathRefCache* rc, const NVGpathRefStyle* style, int stroke, float* bounds)
+{
+	NVGstate* state = nvg__getState(ctx);
+	float xform[6], d[6];
+
+	// Transform from the space the path was recorded in to the current one.
+	memcpy(xform, ref->invxform, sizeof(float)*6);
+	nvgTransformMultiply(xform, state->xform);
+
+	if (nvg__pathRefReusable(ctx, rc, style, xform, d))
+		return nvg__movePathRef(ctx, ref, rc, xform, d, bounds);
+
+	rc->style = *style;
+	nvg__tesselatePathRef(ctx, ref, rc, xform, stroke);
+	memcpy(bounds, rc->cache->bounds, sizeof(float)*4);
+	return rc->cache->paths;
+}
+
+void nvgFillPathRef(NVGcontext* ctx, NVGpathRef* ref)
+{
+	NVGstate* state = nvg__getState(ctx);
+	NVGpathRefStyle style;
+	const NVGpath* paths;
+	float bounds[4];
+
+	if (ref == NULL || ref->ncommands == 0) return;
+	if (nvg__isPathRefCulled(ctx, ref, ctx->fringeWidth)) return;
+
+	memset(&style, 0, sizeof(style));
+	style.fringe = (ctx->params.edgeAntiAlias && state->shapeAntiAlias) ? ctx->fringeWidth : 0.0f;
+	style.tessTol = ctx->tessTol;
+
+	paths = nvg__preparePathRef(ctx, ref, &ref->fill, &style, 0, bounds);
+	if (paths == NULL) return;
+
+	nvg__renderFillPaths(ctx, bounds, paths, ref->fill.cache->npaths);
+}
+
+void nvgStrokePathRef(NVGcontext* ctx, NVGpathRef* ref)
+{
+	NVGstate* state = nvg__getState(ctx);
+	NVGpathRefStyle style;
+	NVGpaint strokePaint;
+	const NVGpath* paths;
+	float bounds[4];
+
+	if (ref == NULL || ref->ncommands == 0) return;
+
+	memset(&style, 0, sizeof(style));
+	style.strokeWidth = nvg__strokePaint(ctx, &strokePaint);
+	style.fringe = (ctx->params.edgeAntiAlias && state->shapeAntiAlias) ? ctx->fringeWidth : 0.0f;
+	style.tessTol = ctx->tessTol;
+	style.miterLimit = state->miterLimit;
+	style.lineCap = state->lineCap;
+	style.lineJoin = state->lineJoin;
+	style.lineStyle = state->lineStyle;
+	if (nvg__isPathRefCulled(ctx, ref, nvg__strokeCullPad(ctx, style.strokeWidth))) return;
+
+	paths = nvg__preparePathRef(ctx, ref, &ref->stroke, &style, 1, bounds);
+	if (paths == NULL) return;
+
+	nvg__renderStrokePaths(ctx, &strokePaint, style.strokeWidth, paths, ref->stroke.cache->npaths);
+}
+
+// Add fonts
+int nvgCreateFont(NVGcontext* ctx, const char* name, const char* filename)
+{
+	return fonsAddFont(ctx->fs, name, filename, 0);
+}
+
+int nvgCreateFontAtIndex(NVGcontext* ctx, const char* name, const char* filename, const int fontIndex)
+{
+	return fonsAddFont(ctx->fs, name, filename, fontIndex);
+}
+
+int nvgCreateFontMem(NVGcontext* ctx, const char* name, unsigned char* data, int ndata, int freeData)
 {
 	return fonsAddFontMem(ctx->fs, name, data, ndata, freeData, 0);
 }
@@ -2395,6 +3621,7 @@ int nvgFindFont(NVGcontext* ctx, const char* name)
 int nvgAddFallbackFontId(NVGcontext* ctx, int baseFont, int fallbackFont)
 {
 	if(baseFont == -1 || fallbackFont == -1) return 0;
+	nvg__clearTextRuns(ctx);
 	return fonsAddFallbackFont(ctx->fs, baseFont, fallbackFont);
 }
 
@@ -2405,6 +3632,7 @@ int nvgAddFallbackFont(NVGcontext* ctx, const char* baseFont, const char* fallba
 
 void nvgResetFallbackFontsId(NVGcontext* ctx, int baseFont)
 {
+	nvg__clearTextRuns(ctx);
 	fonsResetFallbackFont(ctx->fs, baseFont);
 }
 
@@ -2432,6 +3660,12 @@ void nvgFontDilate(NVGcontext* ctx, float dilate)
 	state->fontDilate = dilate;
 }
 
+int nvgTextRasterThreads(NVGcontext* ctx, int count, int policy)
+{
+	ctx->textRasterPolicy = policy;
+	return fonsSetRasterThreads(ctx->fs, count, policy);
+}
+
 void nvgTextLetterSpacing(NVGcontext* ctx, float spacing)
 {
 	NVGstate* state = nvg__getState(ctx);
@@ -2472,6 +3706,135 @@ static float nvg__getFontScale(NVGstate* state)
 	return nvg__minf(nvg__quantize(nvg__getAverageScale(state->xform), 0.01f), 4.0f);
 }
 
+static unsigned int nvg__hashTextRun(const char* string, int len, int font, int align, const float* key)
+{
+	// FNV-1a over the string and the text state.
+	unsigned int h = 2166136261u;
+	unsigned int words[6];
+	int i;
+	for (i = 0; i < len; i++)
+		h = (h ^ (unsigned char)string[i]) * 16777619u;
+	words[0] = (unsigned int)font;
+	words[1] = (unsigned int)align;
+	memcpy(&words[2], key, sizeof(float)*4);
+	for (i = 0; i < 6; i++)
+		h = (h ^ words[i]) * 16777619u;
+	return h;
+}
+
+static void nvg__clearTextRuns(NVGcontext* ctx)
+{
+	int i;
+	for (i = 0; i < ctx->ntextRuns; i++) {
+		free(ctx->textRuns[i].str);
+		free(ctx->textRuns[i].glyphs);
+	}
+	ctx->ntextRuns = 0;
+	for (i = 0; i < NVG_TEXT_RUN_HASH_SIZE; i++)
+		ctx->textRunLut[i] = -1;
+}
+
+// Drops the runs not used in the last NVG_TEXT_RUN_MAX_AGE frames.
+static void nvg__ageTextRuns(NVGcontext* ctx)
+{
+	int i, j;
+	for (i = j = 0; i < ctx->ntextRuns; i++) {
+		NVGtextRun* run = &ctx->textRuns[i];
+		if (ctx->frameCount - run->lastFrame > NVG_TEXT_RUN_MAX_AGE) {
+			free(run->str);
+			free(run->glyphs);
+		} else {
+			ctx->textRuns[j++] = *run;
+		}
+	}
+	if (j == ctx->ntextRuns)
+		return;
+	ctx->ntextRuns = j;
+	// Relink the moved runs.
+	for (i = 0; i < NVG_TEXT_RUN_HASH_SIZE; i++)
+		ctx->textRunLut[i] = -1;
+	for (i = 0; i < ctx->ntextRuns; i++) {
+		NVGtextRun* run = &ctx->textRuns[i];
+		int h = run->hash & (NVG_TEXT_RUN_HASH_SIZE-1);
+		run->next = ctx->textRunLut[h];
+		ctx->textRunLut[h] = i;
+	}
+}
+
+// Returns the run of the string in the current text state, or NULL. With create a missing run is added.
+// The pointer is valid until the next run is added or the font atlas changes.
+static NVGtextRun* nvg__findTextRun(NVGcontext* ctx, float scale, const char* string, const char* end, int create)
+{
+	NVGstate* state = nvg__getState(ctx);
+	NVGtextRun* run;
+	float key[4];
+	int len = (int)(end - string);
+	unsigned int hash;
+	int i;
+
+	key[0] = state->fontSize*scale;
+	key[1] = state->letterSpacing*scale;
+	key[2] = state->fontBlur*scale;
+	key[3] = state->fontDilate*scale;
+	hash = nvg__hashTextRun(string, len, state->fontId, state->textAlign, key);
+
+	i = ctx->textRunLut[hash & (NVG_TEXT_RUN_HASH_SIZE-1)];
+	while (i != -1) {
+		run = &ctx->textRuns[i];
+		if (run->hash == hash && run->len == len && run->font == state->fontId && run->align == state->textAlign &&
+			run->size == key[0] && run->spacing == key[1] && run->blur == key[2] && run->dilate == key[3] &&
+			memcmp(run->str, string, len) == 0) {
+			run->lastFrame = ctx->frameCount;
+			return run;
+		}
+		i = run->next;
+	}
+
+	if (!create || ctx->ntextRuns >= NVG_MAX_TEXT_RUNS)
+		return NULL;
+	if (ctx->ntextRuns+1 > ctx->ctextRuns) {
+		int ctextRuns = nvg__maxi(ctx->ntextRuns+1, 64) + ctx->ctextRuns/2;
+		NVGtextRun* textRuns = (NVGtextRun*)realloc(ctx->textRuns, sizeof(NVGtextRun)*ctextRuns);
+		if (textRuns == NULL) return NULL;
+		ctx->textRuns = textRuns;
+		ctx->ctextRuns = ctextRuns;
+	}
+	run = &ctx->textRuns[ctx->ntextRuns];
+	memset(run, 0, sizeof(*run));
+	run->str = (char*)malloc(nvg__maxi(len, 1));
+	if (run->str == NULL) return NULL;
+	memcpy(run->str, string, len);
+	run->len = len;
+	run->hash = hash;
+	run->font = state->fontId;
+	run->align = state->textAlign;
+	run->size = key[0];
+	run->spacing = key[1];
+	run->blur = key[2];
+	run->dilate = key[3];
+	run->lastFrame = ctx->frameCount;
+	run->next = ctx->textRunLut[hash & (NVG_TEXT_RUN_HASH_SIZE-1)];
+	ctx->textRunLut[hash & (NVG_TEXT_RUN_HASH_SIZE-1)] = ctx->ntextRuns++;
+	return run;
+}
+
+// Like fonsTextBounds() at 0,0 with the font state set, the results are kept in the run of the string.
+static float nvg__textRunBounds(NVGcontext* ctx, float scale, const char* string, const char* end, float* bounds)
+{
+	NVGtextRun* run = nvg__findTextRun(ctx, scale, string, end, 1);
+	if (run == NULL)
+		return fonsTextBounds(ctx->fs, 0, 0, string, end, bounds);
+	if (run->measured) {
+		NVG_STAT_ADD(ctx, textRunHits, 1);
+	} else {
+		run->width = fonsTextBounds(ctx->fs, 0, 0, string, end, run->bounds);
+		run->measured = 1;
+	}
+	if (bounds != NULL)
+		memcpy(bounds, run->bounds, sizeof(run->bounds));
+	return run->width;
+}
+
 static void nvg__flushTextTexture(NVGcontext* ctx)
 {
 	int dirty[4];
@@ -2482,11 +3845,22 @@ static void nvg__flushTextTexture(NVGcontext* ctx)
 		if (fontImage != 0) {
 			int iw, ih;
 			const unsigned char* data = fonsGetTextureData(ctx->fs, &iw, &ih);
+			int npages = fonsGetAtlasPages(ctx->fs);
 			int x = dirty[0];
 			int y = dirty[1];
 			int w = dirty[2] - dirty[0];
 			int h = dirty[3] - dirty[1];
+			if (npages > ctx->fontImagePages && ctx->params.renderResizeTexturePages != NULL) {
+				// Make room for twice the pages, the contents of the resized texture are uploaded again.
+				ctx->fontImagePages = nvg__mini(nvg__maxi(npages, ctx->fontImagePages*2), NVG_MAX_FONTPAGES);
+				ctx->params.renderResizeTexturePages(ctx->params.userPtr, fontImage, ctx->fontImagePages);
+				x = y = 0;
+				w = iw;
+				h = ih;
+			}
 			ctx->params.renderUpdateTexture(ctx->params.userPtr, fontImage, x,y, w,h, data);
+			NVG_STAT_ADD(ctx, uploads, 1);
+			NVG_STAT_ADD(ctx, uploadBytes, w*h);
 		}
 	}
 }
@@ -2494,6 +3868,8 @@ static void nvg__flushTextTexture(NVGcontext* ctx)
 static int nvg__allocTextAtlas(NVGcontext* ctx)
 {
 	int iw, ih;
+	// The text drawn so far needs its queued glyphs in the current font image.
+	fonsCommitGlyphs(ctx->fs, 1);
 	nvg__flushTextTexture(ctx);
 	if (ctx->fontImageIdx >= NVG_MAX_FONTIMAGES-1)
 		return 0;
@@ -2511,7 +3887,10 @@ static int nvg__allocTextAtlas(NVGcontext* ctx)
 		ctx->fontImages[ctx->fontImageIdx+1] = ctx->params.renderCreateTexture(ctx->params.userPtr, NVG_TEXTURE_ALPHA, iw, ih, 0, NULL);
 	}
 	++ctx->fontImageIdx;
-	fonsResetAtlas(ctx->fs, iw, ih);
+	ctx->fontImagePages = 1;
+	fonsCompactAtlas(ctx->fs, iw, ih);
+	// The glyphs moved, the cached quads are stale.
+	nvg__clearTextRuns(ctx);
 	return 1;
 }
 
@@ -2527,10 +3906,21 @@ static void nvg__renderText(NVGcontext* ctx, NVGvertex* verts, int nverts)
 	paint.innerColor.a *= state->alpha;
 	paint.outerColor.a *= state->alpha;
 
-	ctx->params.renderTriangles(ctx->params.userPtr, &paint, state->compositeOperation, &state->scissor, verts, nverts, ctx->fringeWidth);
+	if (ctx->params.renderSDFTriangles != NULL) {
+		// Field values in device pixels from the edge, the coverage ramps over one pixel widened by
+		// the blur, centered on the edge moved out by the dilate.
+		float px = nvg__getAverageScale(state->xform) * ctx->devicePxRatio;
+		float k = state->fontSize * px / FONS_SDF_SIZE * FONS_SDF_PADDING / FONS_SDF_ONEDGE;
+		float width = 1.0f + state->fontBlur * px * 2.0f;
+		float sdfScale = 255.0f * k / width;
+		float sdfBias = (state->fontDilate * px - FONS_SDF_ONEDGE * k) / width + 0.5f;
+		ctx->params.renderSDFTriangles(ctx->params.userPtr, &paint, state->compositeOperation, &state->scissor, verts, nverts, ctx->fringeWidth, sdfScale, sdfBias);
+	} else {
+		ctx->params.renderTriangles(ctx->params.userPtr, &paint, state->compositeOperation, &state->scissor, verts, nverts, ctx->fringeWidth);
+	}
 
-	ctx->drawCallCount++;
-	ctx->textTriCount += nverts/3;
+	ctx->stats.drawCalls++;
+	ctx->stats.textTris += nverts/3;
 }
 
 static int nvg__isTransformFlipped(const float *xform)
@@ -2539,17 +3929,89 @@ static int nvg__isTransformFlipped(const float *xform)
 	return( det < 0);
 }
 
-float nvgText(NVGcontext* ctx, float x, float y, const char* string, const char* end)
+// Returns 1 if the local text bounds, in font pixels relative to x,y, are off screen.
+static int nvg__isTextBoundsCulled(NVGcontext* ctx, float x, float y, const float* local, float invscale)
+{
+	NVGstate* state = nvg__getState(ctx);
+	float pad = state->fontSize*0.5f + state->fontBlur*2.0f + state->fontDilate;
+	float bounds[4], tbounds[4];
+
+	bounds[0] = x + local[0]*invscale - pad;
+	bounds[1] = y + local[1]*invscale - pad;
+	bounds[2] = x + local[2]*invscale + pad;
+	bounds[3] = y + local[3]*invscale + pad;
+	nvg__transformBounds(tbounds, state->xform, bounds);
+	return nvg__isCulled(ctx, tbounds, 0.0f);
+}
+
+// Conservative test against the line height and a width of one max advance per byte,
+// so that off screen text is rejected before any of its glyphs are looked up.
+static int nvg__isTextCulled(NVGcontext* ctx, float x, float y, const char* string, const char* end, float invscale)
+{
+	NVGstate* state = nvg__getState(ctx);
+	float width = (float)(end - string) * (fonsMaxAdvance(ctx->fs) + nvg__absf(state->letterSpacing)/invscale);
+	float local[4];
+
+	fonsLineBounds(ctx->fs, 0, &local[1], &local[3]);
+	if (state->textAlign & NVG_ALIGN_RIGHT) {
+		local[0] = -width;
+		local[2] = 0;
+	} else if (state->textAlign & NVG_ALIGN_CENTER) {
+		local[0] = -width*0.5f;
+		local[2] = width*0.5f;
+	} else {
+		local[0] = 0;
+		local[2] = width;
+	}
+	return nvg__isTextBoundsCulled(ctx, x, y, local, invscale);
+}
+
+// Appends the triangles of a glyph quad in font pixels relative to x,y.
+static int nvg__textQuad(NVGstate* state, NVGvertex* verts, int nverts, int cverts, FONSquad q,
+						 float x, float y, float invscale, int isFlipped)
+{
+	float c[4*2];
+	if(isFlipped) {
+		float tmp;
+
+		tmp = q.y0; q.y0 = q.y1; q.y1 = tmp;
+		tmp = q.t0; q.t0 = q.t1; q.t1 = tmp;
+	}
+	// The integer part of v selects the atlas page.
+	q.t0 += q.page;
+	q.t1 += q.page;
+	// Transform corners.
+	nvgTransformPoint(&c[0],&c[1], state->xform, q.x0*invscale + x, q.y0*invscale + y);
+	nvgTransformPoint(&c[2],&c[3], state->xform, q.x1*invscale + x, q.y0*invscale + y);
+	nvgTransformPoint(&c[4],&c[5], state->xform, q.x1*invscale + x, q.y1*invscale + y);
+	nvgTransformPoint(&c[6],&c[7], state->xform, q.x0*invscale + x, q.y1*invscale + y);
+	// Create triangles
+	if (nverts+6 <= cverts) {
+		nvg__vset(&verts[nverts], c[0], c[1], q.s0, q.t0, 0, 0); nverts++;
+		nvg__vset(&verts[nverts], c[4], c[5], q.s1, q.t1, 0, 0); nverts++;
+		nvg__vset(&verts[nverts], c[2], c[3], q.s1, q.t0, 0, 0); nverts++;
+		nvg__vset(&verts[nverts], c[0], c[1], q.s0, q.t0, 0, 0); nverts++;
+		nvg__vset(&verts[nverts], c[6], c[7], q.s0, q.t1, 0, 0); nverts++;
+		nvg__vset(&verts[nverts], c[4], c[5], q.s1, q.t1, 0, 0); nverts++;
+	}
+	return nverts;
+}
+
+static float nvg__text(NVGcontext* ctx, float x, float y, const char* string, const char* end, int measureCulled)
 {
 	NVGstate* state = nvg__getState(ctx);
 	FONStextIter iter, prevIter;
 	FONSquad q;
 	NVGvertex* verts;
+	NVGtextRun* run;
 	float scale = nvg__getFontScale(state) * ctx->devicePxRatio;
 	float invscale = 1.0f / scale;
+	float nextx;
 	int cverts = 0;
 	int nverts = 0;
 	int isFlipped = nvg__isTransformFlipped(state->xform);
+	int nglyphs = 0;
+	int record, i;
 
 	if (end == NULL)
 		end = string + strlen(string);
@@ -2563,15 +4025,56 @@ float nvgText(NVGcontext* ctx, float x, float y, const char* string, const char*
 	fonsSetAlign(ctx->fs, state->textAlign);
 	fonsSetFont(ctx->fs, state->fontId);
 
+	if (nvg__isTextCulled(ctx, x, y, string, end, invscale)) {
+		float width;
+		ctx->stats.culledTexts++;
+		if (!measureCulled || (state->textAlign & NVG_ALIGN_RIGHT))
+			return x;
+		// Still return the advance, measuring does not rasterize the glyphs.
+		width = nvg__textRunBounds(ctx, scale, string, end, NULL);
+		if (state->textAlign & NVG_ALIGN_CENTER)
+			return width*0.5f*invscale + x;
+		return width*invscale + x;
+	}
+
 	cverts = nvg__maxi(2, (int)(end - string)) * 6; // conservative estimate.
 	verts = nvg__allocTempVerts(ctx, cverts);
 	if (verts == NULL) return x;
 
+	run = nvg__findTextRun(ctx, scale, string, end, 0);
+	if (run != NULL && run->glyphs != NULL) {
+		// Same string in the same state as a recent frame, its quads are still in the atlas.
+		NVG_STAT_ADD(ctx, textRunHits, 1);
+		for (i = 0; i < run->nglyphs; i++) {
+			// Keep the glyphs recent for the atlas compaction.
+			fonsTouchGlyph(ctx->fs, run->font, run->glyphs[i].slot);
+			if (run->glyphs[i].q.x0 != run->glyphs[i].q.x1)
+				nverts = nvg__textQuad(state, verts, nverts, cverts, run->glyphs[i].q, x, y, invscale, isFlipped);
+		}
+		nvg__flushTextTexture(ctx);
+		if (nverts > 0)
+			nvg__renderText(ctx, verts, nverts);
+		return run->nextx * invscale + x;
+	}
+
+	// Placeholder and fallback quads are not final, only blocking rasterization records the run.
+	record = ctx->textRasterPolicy == NVG_RASTER_BLOCK;
+	if (record && ctx->crunGlyphs < (int)(end - string)) {
+		NVGtextRunGlyph* runGlyphs = (NVGtextRunGlyph*)realloc(ctx->runGlyphs, sizeof(NVGtextRunGlyph)*(end - string));
+		if (runGlyphs != NULL) {
+			ctx->runGlyphs = runGlyphs;
+			ctx->crunGlyphs = (int)(end - string);
+		} else {
+			record = 0;
+		}
+	}
+
 	fonsTextIterInit(ctx->fs, &iter, 0, 0, string, end, FONS_GLYPH_BITMAP_REQUIRED);
 	prevIter = iter;
 	while (fonsTextIterNext(ctx->fs, &iter, &q)) {
-		float c[4*2];
 		if (iter.prevGlyphIndex == -1) { // can not retrieve glyph?
+			// The glyphs laid out so far were in the old atlas.
+			record = 0;
 			if (nverts != 0) {
 				nvg__renderText(ctx, verts, nverts);
 				nverts = 0;
@@ -2584,33 +4087,44 @@ float nvgText(NVGcontext* ctx, float x, float y, const char* string, const char*
 				break;
 		}
 		prevIter = iter;
-		if(isFlipped) {
-			float tmp;
-
-			tmp = q.y0; q.y0 = q.y1; q.y1 = tmp;
-			tmp = q.t0; q.t0 = q.t1; q.t1 = tmp;
+		if (record && nglyphs < ctx->crunGlyphs) {
+			NVGtextRunGlyph* glyph = &ctx->runGlyphs[nglyphs++];
+			glyph->q = q;
+			glyph->x = iter.x;
+			glyph->nextx = iter.nextx;
+			glyph->offset = (int)(iter.str - string);
+			glyph->slot = iter.glyph;
 		}
-		// Transform corners.
-		nvgTransformPoint(&c[0],&c[1], state->xform, q.x0*invscale + x, q.y0*invscale + y);
-		nvgTransformPoint(&c[2],&c[3], state->xform, q.x1*invscale + x, q.y0*invscale + y);
-		nvgTransformPoint(&c[4],&c[5], state->xform, q.x1*invscale + x, q.y1*invscale + y);
-		nvgTransformPoint(&c[6],&c[7], state->xform, q.x0*invscale + x, q.y1*invscale + y);
-		// Create triangles
-		if (nverts+6 <= cverts) {
-			nvg__vset(&verts[nverts], c[0], c[1], q.s0, q.t0, 0, 0); nverts++;
-			nvg__vset(&verts[nverts], c[4], c[5], q.s1, q.t1, 0, 0); nverts++;
-			nvg__vset(&verts[nverts], c[2], c[3], q.s1, q.t0, 0, 0); nverts++;
-			nvg__vset(&verts[nverts], c[0], c[1], q.s0, q.t0, 0, 0); nverts++;
-			nvg__vset(&verts[nverts], c[6], c[7], q.s0, q.t1, 0, 0); nverts++;
-			nvg__vset(&verts[nverts], c[4], c[5], q.s1, q.t1, 0, 0); nverts++;
+		// Glyphs still being rasterized may be left out, see nvgTextRasterThreads().
+		if (q.x0 == q.x1)
+			continue;
+		nverts = nvg__textQuad(state, verts, nverts, cverts, q, x, y, invscale, isFlipped);
+	}
+	nextx = iter.nextx;
+
+	if (record) {
+		run = nvg__findTextRun(ctx, scale, string, end, 1);
+		if (run != NULL && run->glyphs == NULL) {
+			run->glyphs = (NVGtextRunGlyph*)malloc(sizeof(NVGtextRunGlyph)*nvg__maxi(nglyphs, 1));
+			if (run->glyphs != NULL) {
+				memcpy(run->glyphs, ctx->runGlyphs, sizeof(NVGtextRunGlyph)*nglyphs);
+				run->nglyphs = nglyphs;
+				run->nextx = nextx;
+			}
 		}
 	}
 
 	// TODO: add back-end bit to do this just once per frame.
 	nvg__flushTextTexture(ctx);
 
-	nvg__renderText(ctx, verts, nverts);
-	return iter.nextx * invscale + x;
+	if (nverts > 0)
+		nvg__renderText(ctx, verts, nverts);
+	return nextx * invscale + x;
+}
+
+float nvgText(NVGcontext* ctx, float x, float y, const char* string, const char* end)
+{
+	return nvg__text(ctx, x, y, string, end, 1);
 }
 
 void nvgTextBox(NVGcontext* ctx, float x, float y, float breakRowWidth, const char* string, const char* end)
@@ -2621,23 +4135,43 @@ void nvgTextBox(NVGcontext* ctx, float x, float y, float breakRowWidth, const ch
 	int oldAlign = state->textAlign;
 	int halign = state->textAlign & (NVG_ALIGN_LEFT | NVG_ALIGN_CENTER | NVG_ALIGN_RIGHT);
 	int valign = state->textAlign & (NVG_ALIGN_TOP | NVG_ALIGN_MIDDLE | NVG_ALIGN_MIDDLE_ASCENT | NVG_ALIGN_BOTTOM | NVG_ALIGN_BASELINE);
-	float lineh = 0;
+	float scale = nvg__getFontScale(state) * ctx->devicePxRatio;
+	float invscale = 1.0f / scale;
+	float lineh = 0, maxAdvance, boxh;
+	float local[4];
 
 	if (state->fontId == FONS_INVALID) return;
 
+	if (end == NULL)
+		end = string + strlen(string);
+
 	nvgTextMetrics(ctx, NULL, NULL, &lineh);
 
+	// Skip breaking the rows of an off screen box. No row is wider than the box
+	// and one glyph, and every row but the last takes at least one byte.
+	maxAdvance = fonsMaxAdvance(ctx->fs);
+	boxh = (float)(end - string) * lineh * state->lineHeight * scale;
+	fonsLineBounds(ctx->fs, 0, &local[1], &local[3]);
+	local[0] = -maxAdvance;
+	local[1] += nvg__minf(boxh, 0.0f);
+	local[2] = breakRowWidth*scale + maxAdvance;
+	local[3] += nvg__maxf(boxh, 0.0f);
+	if (nvg__isTextBoundsCulled(ctx, x, y, local, invscale)) {
+		ctx->stats.culledTexts++;
+		return;
+	}
+
 	state->textAlign = NVG_ALIGN_LEFT | valign;
 
 	while ((nrows = nvgTextBreakLines(ctx, string, end, breakRowWidth, rows, 2, 0))) {
 		for (i = 0; i < nrows; i++) {
 			NVGtextRow* row = &rows[i];
 			if (halign & NVG_ALIGN_LEFT)
-				nvgText(ctx, x, y, row->start, row->end);
+				nvg__text(ctx, x, y, row->start, row->end, 0);
 			else if (halign & NVG_ALIGN_CENTER)
-				nvgText(ctx, x + breakRowWidth*0.5f - row->width*0.5f, y, row->start, row->end);
+				nvg__text(ctx, x + breakRowWidth*0.5f - row->width*0.5f, y, row->start, row->end, 0);
 			else if (halign & NVG_ALIGN_RIGHT)
-				nvgText(ctx, x + breakRowWidth - row->width, y, row->start, row->end);
+				nvg__text(ctx, x + breakRowWidth - row->width, y, row->start, row->end, 0);
 			y += lineh * state->lineHeight;
 		}
 		string = rows[nrows-1].next;
@@ -2653,6 +4187,7 @@ int nvgTextGlyphPositions(NVGcontext* ctx, float x, float y, const char* string,
 	float invscale = 1.0f / scale;
 	FONStextIter iter, prevIter;
 	FONSquad q;
+	NVGtextRun* run;
 	int npos = 0;
 
 	if (state->fontId == FONS_INVALID) return 0;
@@ -2666,9 +4201,23 @@ int nvgTextGlyphPositions(NVGcontext* ctx, float x, float y, const char* string,
 	fonsSetSize(ctx->fs, state->fontSize*scale);
 	fonsSetSpacing(ctx->fs, state->letterSpacing*scale);
 	fonsSetBlur(ctx->fs, state->fontBlur*scale);
+	fonsSetDilate(ctx->fs, state->fontDilate*scale);
 	fonsSetAlign(ctx->fs, state->textAlign);
 	fonsSetFont(ctx->fs, state->fontId);
 
+	run = nvg__findTextRun(ctx, scale, string, end, 0);
+	if (run != NULL && run->glyphs != NULL) {
+		NVG_STAT_ADD(ctx, textRunHits, 1);
+		for (npos = 0; npos < run->nglyphs && npos < maxPositions; npos++) {
+			const NVGtextRunGlyph* glyph = &run->glyphs[npos];
+			positions[npos].str = string + glyph->offset;
+			positions[npos].x = glyph->x * invscale + x;
+			positions[npos].minx = nvg__minf(glyph->x, glyph->q.x0) * invscale + x;
+			positions[npos].maxx = nvg__maxf(glyph->nextx, glyph->q.x1) * invscale + x;
+		}
+		return npos;
+	}
+
 	fonsTextIterInit(ctx->fs, &iter, 0, 0, string, end, FONS_GLYPH_BITMAP_OPTIONAL);
 	prevIter = iter;
 	while (fonsTextIterNext(ctx->fs, &iter, &q)) {
@@ -2920,6 +4469,9 @@ float nvgTextBounds(NVGcontext* ctx, float x, float y, const char* string, const
 
 	if (state->fontId == FONS_INVALID) return 0;
 
+	if (end == NULL)
+		end = string + strlen(string);
+
 	fonsSetSize(ctx->fs, state->fontSize*scale);
 	fonsSetSpacing(ctx->fs, state->letterSpacing*scale);
 	fonsSetBlur(ctx->fs, state->fontBlur*scale);
@@ -2927,7 +4479,7 @@ float nvgTextBounds(NVGcontext* ctx, float x, float y, const char* string, const
 	fonsSetAlign(ctx->fs, state->textAlign);
 	fonsSetFont(ctx->fs, state->fontId);
 
-	width = fonsTextBounds(ctx->fs, 0, 0, string, end, bounds);
+	width = nvg__textRunBounds(ctx, scale, string, end, bounds);
 	if (bounds != NULL) {
 		// Use line bounds for height.
 		fonsLineBounds(ctx->fs, 0, &bounds[1], &bounds[3]);
@@ -31,6 +31,7 @@ extern "C" {
 #endif
 
 typedef struct NVGcontext NVGcontext;
+typedef struct NVGpathRef NVGpathRef;
 
 struct NVGcolor {
 	union {
@@ -79,6 +80,11 @@ enum NVGlineCap {
 	NVG_MITER,
 };
 
+enum NVGpolylineFlags {
+	NVG_POLYLINE_CLOSED     = 1<<0, // Close the sub-path.
+	NVG_POLYLINE_DECIMATE   = 1<<1, // Keep only the first, last, lowest and highest point of each run of points within one device pixel column.
+};
+
 enum NVGalign {
 	// Horizontal align
 	NVG_ALIGN_LEFT          = 1<<0, // Default, align text horizontally to left.
@@ -92,6 +98,12 @@ enum NVGalign {
 	NVG_ALIGN_BASELINE      = 1<<7  // Default, align text vertically to baseline.
 };
 
+enum NVGtextRaster {
+	NVG_RASTER_BLOCK       = 0, // Default, nvgEndFrame() waits for the glyphs of the frame.
+	NVG_RASTER_PLACEHOLDER = 1, // Glyphs not rasterized yet are left out, their advance is kept.
+	NVG_RASTER_FALLBACK    = 2, // Glyphs not rasterized yet are drawn scaled from another cached size, or left out.
+};
+
 enum NVGblendFactor {
 	NVG_ZERO = 1<<0,
 	NVG_ONE = 1<<1,
@@ -144,6 +156,32 @@ struct NVGtextRow {
 };
 typedef struct NVGtextRow NVGtextRow;
 
+// Statistics of the current frame, see nvgGetFrameStats().
+struct NVGframeStats {
+	int drawCalls;			// Draw calls and triangles submitted to the back-end.
+	int fillTris;
+	int strokeTris;
+	int textTris;
+	int culledPaths;		// Fills and strokes skipped because they were outside the viewport or scissor.
+	int culledTexts;		// Text runs skipped for the same reason.
+	// The following are only gathered when nanovg.c is compiled with NVG_FRAME_STATS.
+	int commands;			// Path commands appended.
+	int points;				// Points produced by path flattening.
+	int bezierSegments;		// Line segments produced by bezier flattening.
+	int verts;				// Vertices produced by fill and stroke expansion.
+	int glyphHits;			// Glyph cache lookups which found a rasterized glyph.
+	int glyphMisses;		// Glyph cache lookups which had to rasterize the glyph.
+	int textRunHits;		// Texts drawn, measured or positioned from the glyphs cached for the same string.
+	int uploads;			// Texture updates, including font atlas uploads.
+	int uploadBytes;
+	// Timings in milliseconds, only gathered when also compiled with NVG_FRAME_TIMINGS.
+	float flattenTime;
+	float expandTime;
+	float glyphTime;		// Glyph rasterization.
+	float flushTime;		// Back-end flush in nvgEndFrame().
+};
+typedef struct NVGframeStats NVGframeStats;
+
 enum NVGimageFlags {
     NVG_IMAGE_GENERATE_MIPMAPS	= 1<<0,     // Generate mipmaps during creation of the image.
 	NVG_IMAGE_REPEATX			= 1<<1,		// Repeat image in X direction.
@@ -169,6 +207,9 @@ void nvgCancelFrame(NVGcontext* ctx);
 // Ends drawing flushing remaining render state.
 void nvgEndFrame(NVGcontext* ctx);
 
+// Returns statistics gathered since nvgBeginFrame(), call after nvgEndFrame() to include the flush.
+void nvgGetFrameStats(NVGcontext* ctx, NVGframeStats* stats);
+
 //
 // Composite operation
 //
@@ -253,6 +294,12 @@ struct NVGscissorBounds nvgCurrentScissor(NVGcontext* ctx);
 // Sets whether to draw antialias for nvgStroke() and nvgFill(). It's enabled by default.
 void nvgShapeAntiAlias(NVGcontext* ctx, int enabled);
 
+// Sets whether nvgStroke() and nvgFill() simplify shapes by their size on screen. Fills smaller
+// than NVG_LOD_QUAD_SIZE (3) pixels are drawn as a quad of the same area, and strokes thinner than
+// a pixel get miter joins and square caps instead of round ones, or are skipped when too faint to show.
+// It's disabled by default.
+void nvgShapeLevelOfDetail(NVGcontext* ctx, int enabled);
+
 // Sets current stroke style to a solid color.
 void nvgStrokeColor(NVGcontext* ctx, NVGcolor color);
 
@@ -518,12 +565,70 @@ void nvgEllipse(NVGcontext* ctx, float cx, float cy, float rx, float ry);
 // Creates new circle shaped sub-path.
 void nvgCircle(NVGcontext* ctx, float cx, float cy, float r);
 
+// Creates new sub-path of line segments through n points stored as x,y pairs in xy.
+// The sub-path is closed if closed is non-zero. This is much faster than calling nvgLineTo() for each point.
+void nvgPolyline(NVGcontext* ctx, const float* xy, int n, int closed);
+
+// Creates new sub-path of line segments through n points, point i is read from x and y offset by i*stride bytes.
+// Flags is a combination of NVGpolylineFlags, decimation is meant for plots whose x grows along the points.
+void nvgPolylineStrided(NVGcontext* ctx, const float* x, const float* y, int n, int stride, int flags);
+
 // Fills the current path with current fill style.
 void nvgFill(NVGcontext* ctx);
 
 // Fills the current path with current stroke style.
 void nvgStroke(NVGcontext* ctx);
 
+//
+// Shape batches
+//
+// Draws many rectangles or circles filled with solid colors in one go. Each shape is drawn as a single
+// quad whose coverage is computed by the back-end from the shape's distance function, so there is no
+// tessellation. The shapes use the current transform, scissor, composite operation, global alpha and
+// shape anti-aliasing setting. The current path is not changed.
+
+// Draws n rectangles, rectangle i is at rects[i*4+0..3] as x,y,w,h and filled with colors[i].
+void nvgDrawRects(NVGcontext* ctx, const float* rects, const NVGcolor* colors, int n);
+
+// Draws n rounded rectangles, like nvgDrawRects() with the corner radius of rectangle i in radii[i].
+void nvgDrawRoundedRects(NVGcontext* ctx, const float* rects, const float* radii, const NVGcolor* colors, int n);
+
+// Draws n circles, circle i is at circles[i*3+0..2] as cx,cy,r and filled with colors[i].
+void nvgDrawCircles(NVGcontext* ctx, const float* circles, const NVGcolor* colors, int n);
+
+//
+// Retained Paths
+//
+// A path reference keeps a copy of the current path so that it can be drawn again later
+// without rebuilding and re-tessellating it. The flattened points and the expanded vertices
+// are cached in the path reference. When the path is drawn again with only translation or
+// rotation changed (or scaled within tessellation tolerance), the cached vertices are just
+// moved to the new location. Changing the scale, stroke style or device pixel ratio
+// re-tessellates the path.
+//
+//		nvgBeginPath(vg);
+//		nvgRoundedRect(vg, 0,0, 100,30, 4);
+//		NVGpathRef* button = nvgCreatePathRef(vg);
+//		...
+//		nvgTranslate(vg, x,y);
+//		nvgFillPathRef(vg, button);
+//
+// The path is stored relative to the transform which was current when the path reference was created,
+// and drawn with the transform, paint and style which are current when it is drawn.
+
+// Creates path reference from the current path. Returns NULL on failure, or when the current
+// transform is singular (e.g. scaled by zero), as the path could not be placed under other transforms.
+NVGpathRef* nvgCreatePathRef(NVGcontext* ctx);
+
+// Fills the path reference with current fill style.
+void nvgFillPathRef(NVGcontext* ctx, NVGpathRef* ref);
+
+// Strokes the path reference with current stroke style.
+void nvgStrokePathRef(NVGcontext* ctx, NVGpathRef* ref);
+
+// Deletes created path reference.
+void nvgDeletePathRef(NVGcontext* ctx, NVGpathRef* ref);
+
 
 //
 // Text
@@ -596,6 +701,11 @@ void nvgFontBlur(NVGcontext* ctx, float blur);
 // Sets the dilation of current text style.
 void nvgFontDilate(NVGcontext* ctx, float dilate);
 
+// Rasterizes new glyphs on count worker threads, zero rasterizes them when drawn and negative uses
+// one thread per CPU. Text drawn before its glyphs are ready is drawn as policy says, see NVGtextRaster.
+// Returns the number of threads in use, zero when fontstash is built with FONS_NO_THREADS or FreeType.
+int nvgTextRasterThreads(NVGcontext* ctx, int count, int policy);
+
 // Sets the letter spacing of current text style.
 void nvgTextLetterSpacing(NVGcontext* ctx, float spacing);
 
@@ -685,6 +795,17 @@ struct NVGvertex {
 };
 typedef struct NVGvertex NVGvertex;
 
+// Vertex of a shape batch quad, see nvgDrawRects().
+struct NVGshapeVertex {
+	float x,y;		// Position.
+	float u,v;		// Position relative to the shape center, in shape space.
+	float ex,ey;	// Half size of the shape.
+	float radius;	// Corner radius.
+	float feather;	// Width of the anti-aliased edge in shape space.
+	unsigned char color[4];	// Premultiplied RGBA color.
+};
+typedef struct NVGshapeVertex NVGshapeVertex;
+
 struct NVGpath {
 	int first;
 	int count;
@@ -715,6 +836,15 @@ struct NVGparams {
 	void (*renderStroke)(void* uptr, NVGpaint* paint, NVGcompositeOperationState compositeOperation, NVGscissor* scissor, float fringe, float strokeWidth, int lineStyle, const NVGpath* paths, int npaths);
 	void (*renderTriangles)(void* uptr, NVGpaint* paint, NVGcompositeOperationState compositeOperation, NVGscissor* scissor, const NVGvertex* verts, int nverts, float fringe);
 	void (*renderDelete)(void* uptr);
+	// Optional, text is drawn with it from signed distance field glyphs when given. Like renderTriangles,
+	// but the coverage is clamp(texel*sdfScale + sdfBias, 0, 1), which applies zoom, blur and dilate.
+	void (*renderSDFTriangles)(void* uptr, NVGpaint* paint, NVGcompositeOperationState compositeOperation, NVGscissor* scissor, const NVGvertex* verts, int nverts, float fringe, float sdfScale, float sdfBias);
+	// Optional, draws four vertices per shape. Without it the shapes are drawn as filled paths.
+	void (*renderShapes)(void* uptr, NVGcompositeOperationState compositeOperation, NVGscissor* scissor, float fringe, const NVGshapeVertex* verts, int nverts);
+	// Optional, gives an NVG_TEXTURE_ALPHA texture pages layers of its size for a font atlas with pages.
+	// The contents may be lost. Updates address the pages as if they were one below the other, and
+	// textured triangles pick the page by the integer part of the v coordinate.
+	int (*renderResizeTexturePages)(void* uptr, int image, int pages);
 };
 typedef struct NVGparams NVGparams;
 
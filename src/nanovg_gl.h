@@ -32,6 +32,15 @@ enum NVGcreateFlags {
 	NVG_STENCIL_STROKES	= 1<<1,
 	// Flag indicating that additional debug checks are done.
 	NVG_DEBUG 			= 1<<2,
+	// Flag indicating that vertices are uploaded in a 12 byte format with 16-bit texture coordinates.
+	// Stroke line style coordinates are uploaded separately, only for frames which use them.
+	NVG_COMPACT_VERTICES	= 1<<3,
+	// Flag indicating that simple concave fills are triangulated on the CPU and drawn without
+	// the stencil buffer. Paths with holes or self-intersections still use the stencil.
+	NVG_TRIANGULATE_FILLS	= 1<<4,
+	// Flag indicating that glyphs are cached once as signed distance fields and turned into coverage
+	// in the shader, which keeps text sharp when scaled and makes font blur and dilate free.
+	NVG_SDF_TEXT	= 1<<5,
 };
 
 #if defined NANOVG_GL2_IMPLEMENTATION
@@ -67,6 +76,9 @@ GLuint nvglImageHandleGL2(NVGcontext* ctx, int image);
 #if defined NANOVG_GL3
 
 NVGcontext* nvgCreateGL3(int flags);
+// Like nvgCreateGL3(), but linked shader programs are kept as binaries in the directory cacheDir
+// when the driver supports program binaries, which saves compiling them on later creates.
+NVGcontext* nvgCreateGL3Cached(int flags, const char* cacheDir);
 void nvgDeleteGL3(NVGcontext* ctx);
 
 int nvglCreateImageFromHandleGL3(NVGcontext* ctx, GLuint textureId, int w, int h, int flags);
@@ -87,6 +99,8 @@ GLuint nvglImageHandleGLES2(NVGcontext* ctx, int image);
 #if defined NANOVG_GLES3
 
 NVGcontext* nvgCreateGLES3(int flags);
+// Like nvgCreateGLES3(), but linked shader programs are kept as binaries in the directory cacheDir.
+NVGcontext* nvgCreateGLES3Cached(int flags, const char* cacheDir);
 void nvgDeleteGLES3(NVGcontext* ctx);
 
 int nvglCreateImageFromHandleGLES3(NVGcontext* ctx, GLuint textureId, int w, int h, int flags);
@@ -117,6 +131,7 @@ enum GLNVGuniformLoc {
 	GLNVG_LOC_VIEWSIZE,
 	GLNVG_LOC_TEX,
 	GLNVG_LOC_FRAG,
+	GLNVG_LOC_PAGES,
 	GLNVG_MAX_LOCS
 };
 
@@ -124,13 +139,44 @@ enum GLNVGshaderType {
 	NSVG_SHADER_FILLGRAD,
 	NSVG_SHADER_FILLIMG,
 	NSVG_SHADER_SIMPLE,
-	NSVG_SHADER_IMG
+	NSVG_SHADER_IMG,
+	NSVG_SHADER_SHAPES,
+	NSVG_SHADER_FILLCOLOR,
+	NSVG_SHADER_COUNT
 };
 
+// Each shader type has a program specialized to it without line styles. The generic program
+// branches on both at runtime, it draws styled strokes and merged calls of different types.
+#define GLNVG_PROG_GENERIC NSVG_SHADER_COUNT
+
 #if NANOVG_GL_USE_UNIFORMBUFFER
 enum GLNVGuniformBindings {
 	GLNVG_FRAG_BINDING = 0,
 };
+
+// Max number of consecutive calls drawn with one uniform buffer binding, each vertex
+// carries the index of its call's uniforms in the batch.
+#ifndef NANOVG_GL_MAX_BATCH
+#define NANOVG_GL_MAX_BATCH 64
+#endif
+#endif
+
+// Max number of vertices of a concave fill triangulated with NVG_TRIANGULATE_FILLS,
+// larger paths use the stencil fill which is cheaper than the O(n^2) ear clipping.
+#ifndef NANOVG_GL_TRIANGULATE_MAX_VERTS
+#define NANOVG_GL_TRIANGULATE_MAX_VERTS 256
+#endif
+
+#if defined NANOVG_GL3 || defined NANOVG_GLES3
+// Frame data goes to a ring of regions written through unsynchronized mappings,
+// a fence per region keeps the CPU from overwriting data the GPU still reads.
+#define NANOVG_GL_USE_MAPPED_STREAM 1
+#define NANOVG_GL_USE_PROGRAM_BINARY 1
+// The font atlas pages are the layers of a texture array, bound to texture unit 1.
+#define NANOVG_GL_USE_TEXTURE_PAGES 1
+#ifndef NANOVG_GL_STREAM_FRAMES
+#define NANOVG_GL_STREAM_FRAMES 3
+#endif
 #endif
 
 struct GLNVGshader {
@@ -138,6 +184,7 @@ struct GLNVGshader {
 	GLuint frag;
 	GLuint vert;
 	GLint loc[GLNVG_MAX_LOCS];
+	float view[2];
 };
 typedef struct GLNVGshader GLNVGshader;
 
@@ -145,6 +192,7 @@ struct GLNVGtexture {
 	int id;
 	GLuint tex;
 	int width, height;
+	int pages;	// Layers of a texture array, 0 for a 2D texture.
 	int type;
 	int flags;
 };
@@ -165,113 +213,135 @@ enum GLNVGcallType {
 	GLNVG_CONVEXFILL,
 	GLNVG_STROKE,
 	GLNVG_TRIANGLES,
+	GLNVG_SHAPES,
 };
 
 struct GLNVGcall {
 	int type;
 	int image;
-	int pathOffset;
-	int pathCount;
-	int triangleOffset;
+	int program;
+	int vertOffset;
+	int vertCount;
+	int indexOffset;	// Triangle list indices: fills, fringes or strokes, fill quad.
+	int indexCount;
+	int fillCount;
+	int strokeCount;
+	int triangleOffset;	// Shape vertices
 	int triangleCount;
 	int uniformOffset;
 	GLNVGblend blendFunc;
 };
 typedef struct GLNVGcall GLNVGcall;
 
-struct GLNVGpath {
-	int fillOffset;
-	int fillCount;
-	int strokeOffset;
-	int strokeCount;
+// Buffer the frame data is streamed to. Its size grows to the largest frame and stays there.
+struct GLNVGstream {
+	GLuint buf;
+	int size;	// Bytes per frame
+	int base;	// Offset of the current frame's data
 };
-typedef struct GLNVGpath GLNVGpath;
+typedef struct GLNVGstream GLNVGstream;
+
+struct GLNVGcompactVertex {
+	float x, y;
+	unsigned short u, v;
+};
+typedef struct GLNVGcompactVertex GLNVGcompactVertex;
 
 struct GLNVGfragUniforms {
-	#if NANOVG_GL_USE_UNIFORMBUFFER
-		float scissorMat[12]; // matrices are actually 3 vec4s
-		float paintMat[12];
-		struct NVGcolor innerCol;
-		struct NVGcolor outerCol;
-		float scissorExt[2];
-		float scissorScale[2];
-		float extent[2];
-		float radius;
-		float feather;
-		float strokeMult;
-		float strokeThr;
-		int lineStyle;
-		int texType;
-		int type;
-	#else
-		// note: after modifying layout or size of uniform array,
-		// don't forget to also update the fragment shader source!
-		#define NANOVG_GL_UNIFORMARRAY_SIZE 12
-		union {
-			struct {
-				float scissorMat[12]; // matrices are actually 3 vec4s
-				float paintMat[12];
-				struct NVGcolor innerCol;
-				struct NVGcolor outerCol;
-				float scissorExt[2];
-				float scissorScale[2];
-				float extent[2];
-				float radius;
-				float feather;
-				float strokeMult;
-				float strokeThr;
-				float lineStyle;
-				float texType;
-				float type;
-				float unused1;
-				float unused2;
-				float unused3;
-			};
-			float uniformArray[NANOVG_GL_UNIFORMARRAY_SIZE][4];
+	// note: after modifying layout or size of uniform array,
+	// don't forget to also update the fragment shader source!
+	#define NANOVG_GL_UNIFORMARRAY_SIZE 12
+	union {
+		struct {
+			float scissorMat[12]; // matrices are actually 3 vec4s
+			float paintMat[12];
+			struct NVGcolor innerCol;
+			struct NVGcolor outerCol;
+			float scissorExt[2];
+			float scissorScale[2];
+			float extent[2];
+			float radius;
+			float feather;
+			float strokeMult;
+			float strokeThr;
+			float lineStyle;
+			float texType;
+			float type;
+			float sdfScale;	// Zero unless the texture holds signed distance fields.
+			float sdfBias;
+			float unused3;
 		};
-	#endif
+		float uniformArray[NANOVG_GL_UNIFORMARRAY_SIZE][4];
+	};
 };
 typedef struct GLNVGfragUniforms GLNVGfragUniforms;
 
 struct GLNVGcontext {
-	GLNVGshader shader;
+	GLNVGshader shaders[GLNVG_PROG_GENERIC+1];
+	int program;
 	GLNVGtexture* textures;
 	float view[2];
 	int ntextures;
 	int ctextures;
 	int textureId;
-	GLuint vertBuf;
+	GLNVGstream vertBuf;
+	GLNVGstream styleBuf;
+	GLNVGstream indexBuf;
+	GLNVGstream shapeBuf;
 #if defined NANOVG_GL3
 	GLuint vertArr;
 #endif
 #if NANOVG_GL_USE_UNIFORMBUFFER
-	GLuint fragBuf;
+	GLNVGstream fragBuf;
+	GLNVGstream paintBuf;
+	int batchSize;
 #endif
 	int fragSize;
 	int flags;
+	const char* programCache;	// Only used while creating the context.
+#if NANOVG_GL_USE_MAPPED_STREAM
+	GLsync fences[NANOVG_GL_STREAM_FRAMES];
+	int streamRegion;
+#endif
 
 	// Per frame buffers
 	GLNVGcall* calls;
 	int ccalls;
 	int ncalls;
-	GLNVGpath* paths;
-	int cpaths;
-	int npaths;
 	struct NVGvertex* verts;
 	int cverts;
 	int nverts;
+	GLNVGcompactVertex* packedVerts;
+	float* styles;
+	int lineStyles;
+	GLuint* indices;
+	int cindices;
+	int nindices;
+	int uintIndices;	// Without 32-bit index support the indexed vertices are copied out in order.
+	int* ears;
+	int cears;
+	struct NVGshapeVertex* shapeVerts;
+	int cshapeVerts;
+	int nshapeVerts;
 	unsigned char* uniforms;
 	int cuniforms;
 	int nuniforms;
+#if NANOVG_GL_USE_UNIFORMBUFFER
+	float* paints;
+	int cpaints;
+	int npaints;
+#endif
 
 	// cached state
 	#if NANOVG_GL_USE_STATE_FILTER
 	GLuint boundTexture;
+	GLuint boundPages;
 	GLuint stencilMask;
 	GLenum stencilFunc;
 	GLint stencilFuncRef;
 	GLuint stencilFuncMask;
 	GLNVGblend blendFunc;
+	int boundUniforms;
 	#endif
 
 	int dummyTex;
@@ -279,6 +349,8 @@ struct GLNVGcontext {
 typedef struct GLNVGcontext GLNVGcontext;
 
 static int glnvg__maxi(int a, int b) { return a > b ? a : b; }
+static float glnvg__minf(float a, float b) { return a < b ? a : b; }
+static float glnvg__maxf(float a, float b) { return a > b ? a : b; }
 
 #ifdef NANOVG_GLES2
 static unsigned int glnvg__nearestPow2(unsigned int num)
@@ -306,6 +378,20 @@ static void glnvg__bindTexture(GLNVGcontext* gl, GLuint tex)
 #endif
 }
 
+#if NANOVG_GL_USE_TEXTURE_PAGES
+static void glnvg__bindPages(GLNVGcontext* gl, GLuint tex)
+{
+#if NANOVG_GL_USE_STATE_FILTER
+	if (gl->boundPages == tex)
+		return;
+	gl->boundPages = tex;
+#endif
+	glActiveTexture(GL_TEXTURE1);
+	glBindTexture(GL_TEXTURE_2D_ARRAY, tex);
+	glActiveTexture(GL_TEXTURE0);
+}
+#endif
+
 static void glnvg__stencilMask(GLNVGcontext* gl, GLuint mask)
 {
 #if NANOVG_GL_USE_STATE_FILTER
@@ -433,17 +519,133 @@ static void glnvg__checkError(GLNVGcontext* gl, const char* str)
 	}
 }
 
-static int glnvg__createShader(GLNVGshader* shader, const char* name, const char* header, const char* opts, const char* vshader, const char* fshader)
+#if NANOVG_GL_USE_PROGRAM_BINARY
+#ifdef _WIN32
+#include <process.h>
+#define glnvg__getpid _getpid
+#else
+#include <unistd.h>
+#define glnvg__getpid getpid
+#endif
+
+static unsigned long long glnvg__hashString(unsigned long long h, const char* str)
+{
+	const unsigned char* s = (const unsigned char*)(str != NULL ? str : "");
+	while (*s != '\0') {
+		h ^= *s++;
+		h *= 1099511628211ULL;
+	}
+	// Terminate each string, moving text from one string to the next changes the key.
+	h ^= 0xff;
+	h *= 1099511628211ULL;
+	return h;
+}
+
+// The key covers the driver and the whole source, which includes the create flags.
+static void glnvg__programCachePath(char* path, int size, const char* dir, const char** str, int nstr)
+{
+	unsigned long long h = 14695981039346656037ULL;
+	int i;
+	h = glnvg__hashString(h, (const char*)glGetString(GL_VENDOR));
+	h = glnvg__hashString(h, (const char*)glGetString(GL_RENDERER));
+	h = glnvg__hashString(h, (const char*)glGetString(GL_VERSION));
+	for (i = 0; i < nstr; i++)
+		h = glnvg__hashString(h, str[i]);
+	snprintf(path, size, "%s/nanovg-%08x%08x.bin", dir, (unsigned int)(h >> 32), (unsigned int)h);
+}
+
+static int glnvg__loadProgramBinary(GLuint prog, const char* path)
+{
+	unsigned int header[3];	// Magic, binary format and size.
+	GLint status = GL_FALSE;
+	void* data = NULL;
+	FILE* fp = fopen(path, "rb");
+	if (fp == NULL) return 0;
+	if (fread(header, sizeof(header), 1, fp) == 1 && header[0] == 0x4e564742 && header[2] > 0 && header[2] < (1u << 26)) {
+		data = malloc(header[2]);
+		if (data != NULL && fread(data, 1, header[2], fp) == header[2]) {
+			glProgramBinary(prog, (GLenum)header[1], data, (GLsizei)header[2]);
+			glGetProgramiv(prog, GL_LINK_STATUS, &status);
+		}
+	}
+	free(data);
+	fclose(fp);
+	// Drivers reject binaries of other versions with an error.
+	while (status != GL_TRUE && glGetError() != GL_NO_ERROR);
+	return status == GL_TRUE;
+}
+
+static void glnvg__saveProgramBinary(GLuint prog, const char* path)
+{
+	unsigned int header[3];
+	char tmp[1024+48];
+	GLint size = 0;
+	GLenum format = 0;
+	void* data;
+	FILE* fp;
+	int ok;
+
+	glGetProgramiv(prog, GL_PROGRAM_BINARY_LENGTH, &size);
+	if (size <= 0) return;
+	data = malloc(size);
+	if (data == NULL) return;
+	glGetProgramBinary(prog, size, &size, &format, data);
+
+	// Written under another name first, other contexts never load a partial file. The name is
+	// unique to the process and, by the address of the data, to the context saving it.
+	snprintf(tmp, sizeof(tmp), "%s.%d.%lx.tmp", path, (int)glnvg__getpid(), (unsigned long)(size_t)data);
+	fp = fopen(tmp, "wb");
+	if (fp != NULL) {
+		header[0] = 0x4e564742;
+		header[1] = (unsigned int)format;
+		header[2] = (unsigned int)size;
+		ok = fwrite(header, sizeof(header), 1, fp) == 1 && fwrite(data, 1, size, fp) == (size_t)size;
+		ok = fclose(fp) == 0 && ok;
+		if (ok) {
+			remove(path);
+			ok = rename(tmp, path) == 0;
+		}
+		if (!ok)
+			remove(tmp);
+	}
+	free(data);
+}
+#endif
+
+static int glnvg__createShader(GLNVGshader* shader, const char* name, const char* header, const char* opts, const char* vshader, const char* fshader, const char* cacheDir)
 {
 	GLint status;
 	GLuint prog, vert, frag;
 	const char* str[3];
+#if NANOVG_GL_USE_PROGRAM_BINARY
+	const char* key[4];
+	char path[1024];
+#endif
 	str[0] = header;
 	str[1] = opts != NULL ? opts : "";
 
 	memset(shader, 0, sizeof(*shader));
 
 	prog = glCreateProgram();
+#if NANOVG_GL_USE_PROGRAM_BINARY
+	if (cacheDir != NULL) {
+		key[0] = str[0];
+		key[1] = str[1];
+		key[2] = vshader;
+		key[3] = fshader;
+		glnvg__programCachePath(path, sizeof(path), cacheDir, key, 4);
+		if (glnvg__loadProgramBinary(prog, path)) {
+			shader->prog = prog;
+			return 1;
+		}
+		// Missing or rejected, e.g. after a driver update. Compile and replace it.
+		glDeleteProgram(prog);
+		prog = glCreateProgram();
+		glProgramParameteri(prog, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+	}
+#else
+	NVG_NOTUSED(cacheDir);
+#endif
 	vert = glCreateShader(GL_VERTEX_SHADER);
 	frag = glCreateShader(GL_FRAGMENT_SHADER);
 	str[2] = vshader;
@@ -470,6 +672,10 @@ static int glnvg__createShader(GLNVGshader* shader, const char* name, const char
 
 	glBindAttribLocation(prog, 0, "vertex");
 	glBindAttribLocation(prog, 1, "tcoord");
+	glBindAttribLocation(prog, 2, "shape");
+	glBindAttribLocation(prog, 3, "color");
+	glBindAttribLocation(prog, 4, "paint");
+	glBindAttribLocation(prog, 5, "lcoord");
 
 	glLinkProgram(prog);
 	glGetProgramiv(prog, GL_LINK_STATUS, &status);
@@ -477,6 +683,10 @@ static int glnvg__createShader(GLNVGshader* shader, const char* name, const char
 		glnvg__dumpProgramError(prog, name);
 		return 0;
 	}
+#if NANOVG_GL_USE_PROGRAM_BINARY
+	if (cacheDir != NULL)
+		glnvg__saveProgramBinary(prog, path);
+#endif
 
 	shader->prog = prog;
 	shader->vert = vert;
@@ -499,6 +709,7 @@ static void glnvg__getUniforms(GLNVGshader* shader)
 {
 	shader->loc[GLNVG_LOC_VIEWSIZE] = glGetUniformLocation(shader->prog, "viewSize");
 	shader->loc[GLNVG_LOC_TEX] = glGetUniformLocation(shader->prog, "tex");
+	shader->loc[GLNVG_LOC_PAGES] = glGetUniformLocation(shader->prog, "pages");
 
 #if NANOVG_GL_USE_UNIFORMBUFFER
 	shader->loc[GLNVG_LOC_FRAG] = glGetUniformBlockIndex(shader->prog, "frag");
@@ -513,6 +724,12 @@ static int glnvg__renderCreate(void* uptr)
 {
 	GLNVGcontext* gl = (GLNVGcontext*)uptr;
 	int align = 4;
+#if NANOVG_GL_USE_UNIFORMBUFFER
+	int maxBlockSize = 16384;
+#endif
+	char opts[128], progOpts[160];
+	const char* cacheDir = gl->programCache;
+	int i;
 
 	// TODO: mediump float may not be enough for GLES2 in iOS.
 	// see the following discussion: https://github.com/memononen/nanovg/issues/46
@@ -533,7 +750,7 @@ static int glnvg__renderCreate(void* uptr)
 #if NANOVG_GL_USE_UNIFORMBUFFER
 	"#define USE_UNIFORMBUFFER 1\n"
 #else
-	"#define UNIFORMARRAY_SIZE 11\n"
+	"#define UNIFORMARRAY_SIZE 12\n"
 #endif
 	"\n";
 
@@ -541,22 +758,41 @@ static int glnvg__renderCreate(void* uptr)
 		"#ifdef NANOVG_GL3\n"
 		"	uniform vec2 viewSize;\n"
 		"	in vec2 vertex;\n"
-		"	in vec4 tcoord;\n"
+		"	in vec2 tcoord;\n"
+		"	in vec2 lcoord;\n"
+		"	in vec4 shape;\n"
+		"	in vec4 color;\n"
 		"	out vec2 ftcoord;\n"
 		"	out vec2 fpos;\n"
 		"	smooth out vec2 uv;\n"
+		"	out vec4 fshape;\n"
+		"	out vec4 fcolor;\n"
+		"#ifdef USE_UNIFORMBUFFER\n"
+		"	in float paint;\n"
+		"	flat out int fpaint;\n"
+		"#endif\n"
 		"#else\n"
 		"	uniform vec2 viewSize;\n"
 		"	attribute vec2 vertex;\n"
-		"	attribute vec4 tcoord;\n"
+		"	attribute vec2 tcoord;\n"
+		"	attribute vec2 lcoord;\n"
+		"	attribute vec4 shape;\n"
+		"	attribute vec4 color;\n"
 		"	varying vec2 ftcoord;\n"
 		"	varying vec2 fpos;\n"
 		"	varying vec2 uv;\n"
+		"	varying vec4 fshape;\n"
+		"	varying vec4 fcolor;\n"
 		"#endif\n"
 		"void main(void) {\n"
-		"	ftcoord = tcoord.xy;\n"
-		"	uv = 0.5 * tcoord.zw;\n"
+		"	ftcoord = tcoord;\n"
+		"	uv = 0.5 * lcoord;\n"
 		"	fpos = vertex;\n"
+		"	fshape = shape;\n"
+		"	fcolor = color;\n"
+		"#ifdef USE_UNIFORMBUFFER\n"
+		"	fpaint = int(paint);\n"
+		"#endif\n"
 		"	gl_Position = vec4(2.0*vertex.x/viewSize.x - 1.0, 1.0 - 2.0*vertex.y/viewSize.y, 0, 1);\n"
 		"}\n";
 
@@ -571,28 +807,19 @@ static int glnvg__renderCreate(void* uptr)
 		"#ifdef NANOVG_GL3\n"
 		"#ifdef USE_UNIFORMBUFFER\n"
 		"	layout(std140) uniform frag {\n"
-		"		mat3 scissorMat;\n"
-		"		mat3 paintMat;\n"
-		"		vec4 innerCol;\n"
-		"		vec4 outerCol;\n"
-		"		vec2 scissorExt;\n"
-		"		vec2 scissorScale;\n"
-		"		vec2 extent;\n"
-		"		float radius;\n"
-		"		float feather;\n"
-		"		float strokeMult;\n"
-		"		float strokeThr;\n"
-			"   int lineStyle;\n"
-		"		int texType;\n"
-		"		int type;\n"
+		"		vec4 frags[FRAG_STRIDE * FRAG_BATCH];\n"
 		"	};\n"
+		"	flat in int fpaint;\n"
 		"#else\n" // NANOVG_GL3 && !USE_UNIFORMBUFFER
 		"	uniform vec4 frag[UNIFORMARRAY_SIZE];\n"
 		"#endif\n"
 		"	uniform sampler2D tex;\n"
+		"	uniform lowp sampler2DArray pages;\n"
 		"	in vec2 ftcoord;\n"
 		"	in vec2 fpos;\n"
 		"	smooth in vec2 uv;\n"
+		"	in vec4 fshape;\n"
+		"	in vec4 fcolor;\n"
 		"	out vec4 outColor;\n"
 		"#else\n" // !NANOVG_GL3
 		"	uniform vec4 frag[UNIFORMARRAY_SIZE];\n"
@@ -600,22 +827,34 @@ static int glnvg__renderCreate(void* uptr)
 		"	varying vec2 ftcoord;\n"
 		"	varying vec2 fpos;\n"
 		"	varying vec2 uv;\n"
+		"	varying vec4 fshape;\n"
+		"	varying vec4 fcolor;\n"
 		"#endif\n"
-		"#ifndef USE_UNIFORMBUFFER\n"
-		"	#define scissorMat mat3(frag[0].xyz, frag[1].xyz, frag[2].xyz)\n"
-		"	#define paintMat mat3(frag[3].xyz, frag[4].xyz, frag[5].xyz)\n"
-		"	#define innerCol frag[6]\n"
-		"	#define outerCol frag[7]\n"
-		"	#define scissorExt frag[8].xy\n"
-		"	#define scissorScale frag[8].zw\n"
-		"	#define extent frag[9].xy\n"
-		"	#define radius frag[9].z\n"
-		"	#define feather frag[9].w\n"
-		"	#define strokeMult frag[10].x\n"
-		"	#define strokeThr frag[10].y\n"
-		"	#define lineStyle frag[10].z\n"
-		"	#define texType int(frag[10].w)\n"
-		"	#define type int(frag[11].x)\n"
+		"#ifdef USE_UNIFORMBUFFER\n"
+		"	#define FRAG(i) frags[fpaint * FRAG_STRIDE + i]\n"
+		"#else\n"
+		"	#define FRAG(i) frag[i]\n"
+		"#endif\n"
+		"#define scissorMat mat3(FRAG(0).xyz, FRAG(1).xyz, FRAG(2).xyz)\n"
+		"#define paintMat mat3(FRAG(3).xyz, FRAG(4).xyz, FRAG(5).xyz)\n"
+		"#define innerCol FRAG(6)\n"
+		"#define outerCol FRAG(7)\n"
+		"#define scissorExt FRAG(8).xy\n"
+		"#define scissorScale FRAG(8).zw\n"
+		"#define extent FRAG(9).xy\n"
+		"#define radius FRAG(9).z\n"
+		"#define feather FRAG(9).w\n"
+		"#define strokeMult FRAG(10).x\n"
+		"#define strokeThr FRAG(10).y\n"
+		"#define lineStyle int(FRAG(10).z)\n"
+		"#define texType int(FRAG(10).w)\n"
+		"#define type int(FRAG(11).x)\n"
+		"#define sdf FRAG(11).yz\n"
+		"#ifdef SHADER_TYPE\n"
+		"	#undef type\n"
+		"	#define type SHADER_TYPE\n"
+		"	#undef lineStyle\n"
+		"	#define lineStyle 0\n"
 		"#endif\n"
 		"\n"
 		"float sdroundrect(vec2 pt, vec2 ext, float rad) {\n"
@@ -631,7 +870,7 @@ static int glnvg__renderCreate(void* uptr)
 		"	return clamp(sc.x,0.0,1.0) * clamp(sc.y,0.0,1.0);\n"
 		"}\n"
 		"float glow(vec2 uv){\n"
-		"  return smoothstep(0, 1, 1.0 - 2.0 * abs(uv.x));\n"
+		"  return smoothstep(0.0, 1.0, 1.0 - 2.0 * abs(uv.x));\n"
 		"}\n"
 		"float dashed(vec2 uv){\n"
 		"	float fy = fract(uv.y / 4.0);\n"
@@ -642,14 +881,14 @@ static int glnvg__renderCreate(void* uptr)
 		"	} else if(fy <= 0.5) {\n"
 			"	fy = 0.5 - fy;\n"
 			"} else {\n"
-			"	fy = 0;\n"
+			"	fy = 0.0;\n"
 			"}\n"
-			"w *= smoothstep(0, 1, 6 * (0.25 - (uv.x * uv.x  + fy * fy)));\n"
+			"w *= smoothstep(0.0, 1.0, 6.0 * (0.25 - (uv.x * uv.x  + fy * fy)));\n"
 		"	return w;\n"
 		"}\n"
 		"float dotted(vec2 uv){\n"
 		"	float fy = 4.0 * fract(uv.y / (4.0)) - 0.5;\n"
-		"	return smoothstep(0,1, 6*(0.25 - (uv.x * uv.x  + fy * fy)));\n"
+		"	return smoothstep(0.0, 1.0, 6.0*(0.25 - (uv.x * uv.x  + fy * fy)));\n"
 		"}\n"
 		"#ifdef EDGE_AA\n"
 		"// Stroke - from [0..1] to clipped pyramid, where the slope is 1px.\n"
@@ -701,14 +940,22 @@ static int glnvg__renderCreate(void* uptr)
 		"		result = vec4(1,1,1,1);\n"
 		"	} else if (type == 3) {		// Textured tris\n"
 		"#ifdef NANOVG_GL3\n"
-		"		vec4 color = texture(tex, ftcoord);\n"
+		"		vec4 color;\n"
+		"		if (texType == 3) color = vec4(texture(pages, vec3(ftcoord.x, fract(ftcoord.y), floor(ftcoord.y))).x);\n"
+		"		else color = texture(tex, ftcoord);\n"
 		"#else\n"
 		"		vec4 color = texture2D(tex, ftcoord);\n"
 		"#endif\n"
 		"		if (texType == 1) color = vec4(color.xyz*color.w,color.w);"
 		"		if (texType == 2) color = vec4(color.x);"
+		"		if (sdf.x != 0.0) color = vec4(clamp(color.x*sdf.x + sdf.y, 0.0, 1.0));\n"
 		"		color *= scissor;\n"
 		"		result = color * innerCol;\n"
+		"	} else if (type == 4) {		// Shape batch, coverage from the shape distance\n"
+		"		float d = sdroundrect(ftcoord, fshape.xy, fshape.z);\n"
+		"		result = fcolor * (clamp(0.5 - d / fshape.w, 0.0, 1.0) * scissor);\n"
+		"	} else if (type == 5) {		// Solid color\n"
+		"		result = innerCol * (strokeAlpha * scissor);\n"
 		"	}\n"
 		"#ifdef NANOVG_GL3\n"
 		"	outColor = result;\n"
@@ -719,30 +966,76 @@ static int glnvg__renderCreate(void* uptr)
 
 	glnvg__checkError(gl, "init");
 
-	if (gl->flags & NVG_ANTIALIAS) {
-		if (glnvg__createShader(&gl->shader, "shader", shaderHeader, "#define EDGE_AA 1\n", fillVertShader, fillFragShader) == 0)
-			return 0;
-	} else {
-		if (glnvg__createShader(&gl->shader, "shader", shaderHeader, NULL, fillVertShader, fillFragShader) == 0)
-			return 0;
+	// Paths are drawn with 32-bit indices into the vertices of the whole frame.
+	gl->uintIndices = 1;
+#ifdef NANOVG_GLES2
+	if (strstr((const char*)glGetString(GL_EXTENSIONS), "GL_OES_element_index_uint") == NULL)
+		gl->uintIndices = 0;
+#endif
+
+#if NANOVG_GL_USE_UNIFORMBUFFER
+	glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &align);
+	glGetIntegerv(GL_MAX_UNIFORM_BLOCK_SIZE, &maxBlockSize);
+#endif
+	gl->fragSize = sizeof(GLNVGfragUniforms) + align - sizeof(GLNVGfragUniforms) % align;
+
+#if NANOVG_GL_USE_UNIFORMBUFFER
+	// The uniform block is an array of vec4s, one batch of fragSize strides.
+	gl->batchSize = glnvg__maxi(1, maxBlockSize / gl->fragSize);
+	if (gl->batchSize > NANOVG_GL_MAX_BATCH) gl->batchSize = NANOVG_GL_MAX_BATCH;
+	snprintf(opts, sizeof(opts), "%s#define FRAG_STRIDE %d\n#define FRAG_BATCH %d\n",
+			 (gl->flags & NVG_ANTIALIAS) ? "#define EDGE_AA 1\n" : "", gl->fragSize / 16, gl->batchSize);
+#else
+	snprintf(opts, sizeof(opts), "%s", (gl->flags & NVG_ANTIALIAS) ? "#define EDGE_AA 1\n" : "");
+#endif
+
+#if NANOVG_GL_USE_PROGRAM_BINARY
+	if (cacheDir != NULL) {
+		GLint nformats = 0;
+		glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &nformats);
+		while (glGetError() != GL_NO_ERROR);
+		if (nformats <= 0)
+			cacheDir = NULL;
 	}
+#endif
 
-	glnvg__checkError(gl, "uniform locations");
-	glnvg__getUniforms(&gl->shader);
+	for (i = 0; i <= GLNVG_PROG_GENERIC; i++) {
+		GLNVGshader* shader = &gl->shaders[i];
+		if (i < GLNVG_PROG_GENERIC)
+			snprintf(progOpts, sizeof(progOpts), "%s#define SHADER_TYPE %d\n", opts, i);
+		else
+			snprintf(progOpts, sizeof(progOpts), "%s", opts);
+		if (glnvg__createShader(shader, "shader", shaderHeader, progOpts, fillVertShader, fillFragShader, cacheDir) == 0)
+			return 0;
+
+		glnvg__checkError(gl, "uniform locations");
+		glnvg__getUniforms(shader);
+#if NANOVG_GL_USE_UNIFORMBUFFER
+		glUniformBlockBinding(shader->prog, shader->loc[GLNVG_LOC_FRAG], GLNVG_FRAG_BINDING);
+#endif
+		glUseProgram(shader->prog);
+		glUniform1i(shader->loc[GLNVG_LOC_TEX], 0);
+#if NANOVG_GL_USE_TEXTURE_PAGES
+		glUniform1i(shader->loc[GLNVG_LOC_PAGES], 1);
+#endif
+	}
+	glUseProgram(0);
 
 	// Create dynamic vertex array
 #if defined NANOVG_GL3
 	glGenVertexArrays(1, &gl->vertArr);
 #endif
-	glGenBuffers(1, &gl->vertBuf);
+	glGenBuffers(1, &gl->vertBuf.buf);
+	if (gl->flags & NVG_COMPACT_VERTICES)
+		glGenBuffers(1, &gl->styleBuf.buf);
+	glGenBuffers(1, &gl->indexBuf.buf);
+	glGenBuffers(1, &gl->shapeBuf.buf);
 
 #if NANOVG_GL_USE_UNIFORMBUFFER
 	// Create UBOs
-	glUniformBlockBinding(gl->shader.prog, gl->shader.loc[GLNVG_LOC_FRAG], GLNVG_FRAG_BINDING);
-	glGenBuffers(1, &gl->fragBuf);
-	glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &align);
+	glGenBuffers(1, &gl->fragBuf.buf);
+	glGenBuffers(1, &gl->paintBuf.buf);
 #endif
-	gl->fragSize = sizeof(GLNVGfragUniforms) + align - sizeof(GLNVGfragUniforms) % align;
 
 	// Some platforms does not allow to have samples to unset textures.
 	// Create empty one which is bound when there's no texture specified.
@@ -867,12 +1160,99 @@ static int glnvg__renderDeleteTexture(void* uptr, int image)
 	return glnvg__deleteTexture(gl, image);
 }
 
+static GLNVGfragUniforms* nvg__fragUniformPtr(GLNVGcontext* gl, int i);
+
+#if NANOVG_GL_USE_TEXTURE_PAGES
+// The calls recorded earlier in the frame sample the image as a 2D texture, point them to the pages.
+static void glnvg__convertCallsToPages(GLNVGcontext* gl, int image)
+{
+	int i, offset, end;
+	for (i = 0; i < gl->ncalls; i++) {
+		GLNVGcall* call = &gl->calls[i];
+		if (call->image != image) continue;
+		end = i+1 < gl->ncalls ? gl->calls[i+1].uniformOffset : gl->nuniforms * gl->fragSize;
+		for (offset = call->uniformOffset; offset < end; offset += gl->fragSize) {
+			GLNVGfragUniforms* frag = nvg__fragUniformPtr(gl, offset);
+			if (frag->texType == 2.0f) frag->texType = 3.0f;
+		}
+	}
+}
+
+static int glnvg__renderResizeTexturePages(void* uptr, int image, int pages)
+{
+	GLNVGcontext* gl = (GLNVGcontext*)uptr;
+	GLNVGtexture* tex = glnvg__findTexture(gl, image);
+	GLint filter;
+
+	if (tex == NULL || tex->type != NVG_TEXTURE_ALPHA || (tex->flags & NVG_IMAGE_NODELETE)) return 0;
+
+	// Texture arrays can not grow, the storage is created again and the contents are lost.
+#if NANOVG_GL_USE_STATE_FILTER
+	if (gl->boundTexture == tex->tex) gl->boundTexture = 0;
+	if (gl->boundPages == tex->tex) gl->boundPages = 0;
+#endif
+	glDeleteTextures(1, &tex->tex);
+	glGenTextures(1, &tex->tex);
+	if (tex->pages == 0)
+		glnvg__convertCallsToPages(gl, image);
+	tex->pages = pages;
+	glnvg__bindPages(gl, tex->tex);
+
+	glActiveTexture(GL_TEXTURE1);
+	glTexImage3D(GL_TEXTURE_2D_ARRAY, 0, GL_R8, tex->width, tex->height, pages, 0, GL_RED, GL_UNSIGNED_BYTE, NULL);
+	filter = (tex->flags & NVG_IMAGE_NEAREST) ? GL_NEAREST : GL_LINEAR;
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, filter);
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, filter);
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+	glActiveTexture(GL_TEXTURE0);
+
+	glnvg__checkError(gl, "resize tex pages");
+	glnvg__bindPages(gl, 0);
+
+	return 1;
+}
+
+// The rows of the pages are one below the other, each page's share of the rectangle goes to its layer.
+static int glnvg__updateTexturePages(GLNVGcontext* gl, GLNVGtexture* tex, int x, int y, int w, int h, const unsigned char* data)
+{
+	int page;
+
+	glnvg__bindPages(gl, tex->tex);
+	glActiveTexture(GL_TEXTURE1);
+	glPixelStorei(GL_UNPACK_ALIGNMENT,1);
+	glPixelStorei(GL_UNPACK_ROW_LENGTH, tex->width);
+	glPixelStorei(GL_UNPACK_SKIP_PIXELS, x);
+
+	for (page = y / tex->height; page < tex->pages && page * tex->height < y+h; page++) {
+		int y0 = glnvg__maxi(y, page * tex->height);
+		int y1 = y+h < (page+1) * tex->height ? y+h : (page+1) * tex->height;
+		glPixelStorei(GL_UNPACK_SKIP_ROWS, y0);
+		glTexSubImage3D(GL_TEXTURE_2D_ARRAY, 0, x, y0 - page * tex->height, page, w, y1 - y0, 1, GL_RED, GL_UNSIGNED_BYTE, data);
+	}
+
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+	glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+	glPixelStorei(GL_UNPACK_SKIP_PIXELS, 0);
+	glPixelStorei(GL_UNPACK_SKIP_ROWS, 0);
+	glActiveTexture(GL_TEXTURE0);
+
+	glnvg__bindPages(gl, 0);
+
+	return 1;
+}
+#endif
+
 static int glnvg__renderUpdateTexture(void* uptr, int image, int x, int y, int w, int h, const unsigned char* data)
 {
 	GLNVGcontext* gl = (GLNVGcontext*)uptr;
 	GLNVGtexture* tex = glnvg__findTexture(gl, image);
 
 	if (tex == NULL) return 0;
+#if NANOVG_GL_USE_TEXTURE_PAGES
+	if (tex->pages > 0)
+		return glnvg__updateTexturePages(gl, tex, x, y, w, h, data);
+#endif
 	glnvg__bindTexture(gl, tex->tex);
 
 	glPixelStorei(GL_UNPACK_ALIGNMENT,1);
@@ -1004,20 +1384,19 @@ static int glnvg__convertPaint(GLNVGcontext* gl, GLNVGfragUniforms* frag, NVGpai
 		}
 		frag->type = NSVG_SHADER_FILLIMG;
 
-		#if NANOVG_GL_USE_UNIFORMBUFFER
-		if (tex->type == NVG_TEXTURE_RGBA)
-			frag->texType = (tex->flags & NVG_IMAGE_PREMULTIPLIED) ? 0 : 1;
-		else
-			frag->texType = 2;
-		#else
 		if (tex->type == NVG_TEXTURE_RGBA)
 			frag->texType = (tex->flags & NVG_IMAGE_PREMULTIPLIED) ? 0.0f : 1.0f;
+		else if (tex->pages > 0)
+			frag->texType = 3.0f;
 		else
 			frag->texType = 2.0f;
-		#endif
 //		printf("frag->texType = %d\n", frag->texType);
 	} else {
-		frag->type = NSVG_SHADER_FILLGRAD;
+		// Plain colors skip the gradient evaluation.
+		if (memcmp(&paint->innerColor, &paint->outerColor, sizeof(NVGcolor)) == 0)
+			frag->type = NSVG_SHADER_FILLCOLOR;
+		else
+			frag->type = NSVG_SHADER_FILLGRAD;
 		frag->radius = paint->radius;
 		frag->feather = paint->feather;
 		nvgTransformInverse(invxform, paint->xform);
@@ -1028,17 +1407,51 @@ static int glnvg__convertPaint(GLNVGcontext* gl, GLNVGfragUniforms* frag, NVGpai
 	return 1;
 }
 
-static GLNVGfragUniforms* nvg__fragUniformPtr(GLNVGcontext* gl, int i);
-
-static void glnvg__setUniforms(GLNVGcontext* gl, int uniformOffset, int image)
+static void glnvg__fragUniforms(GLNVGcontext* gl, int uniformOffset)
 {
-	GLNVGtexture* tex = NULL;
+#if NANOVG_GL_USE_STATE_FILTER
+	if (gl->boundUniforms == uniformOffset)
+		return;
+	gl->boundUniforms = uniformOffset;
+#endif
 #if NANOVG_GL_USE_UNIFORMBUFFER
-	glBindBufferRange(GL_UNIFORM_BUFFER, GLNVG_FRAG_BINDING, gl->fragBuf, uniformOffset, sizeof(GLNVGfragUniforms));
+	// Binds the whole batch, merged calls index their uniforms from the start of it.
+	glBindBufferRange(GL_UNIFORM_BUFFER, GLNVG_FRAG_BINDING, gl->fragBuf.buf, gl->fragBuf.base + uniformOffset, gl->batchSize * gl->fragSize);
 #else
 	GLNVGfragUniforms* frag = nvg__fragUniformPtr(gl, uniformOffset);
-	glUniform4fv(gl->shader.loc[GLNVG_LOC_FRAG], NANOVG_GL_UNIFORMARRAY_SIZE, &(frag->uniformArray[0][0]));
+	glUniform4fv(gl->shaders[gl->program].loc[GLNVG_LOC_FRAG], NANOVG_GL_UNIFORMARRAY_SIZE, &(frag->uniformArray[0][0]));
+#endif
+}
+
+static void glnvg__useProgram(GLNVGcontext* gl, int program)
+{
+	GLNVGshader* shader = &gl->shaders[program];
+#if NANOVG_GL_USE_STATE_FILTER
+	if (gl->program == program)
+		return;
+#if !NANOVG_GL_USE_UNIFORMBUFFER
+	// Uniform values belong to the program.
+	gl->boundUniforms = -1;
 #endif
+#endif
+	gl->program = program;
+	glUseProgram(shader->prog);
+	if (shader->view[0] != gl->view[0] || shader->view[1] != gl->view[1]) {
+		glUniform2fv(shader->loc[GLNVG_LOC_VIEWSIZE], 1, gl->view);
+		shader->view[0] = gl->view[0];
+		shader->view[1] = gl->view[1];
+	}
+}
+
+static int glnvg__program(const GLNVGfragUniforms* frag)
+{
+	return frag->lineStyle > 1 ? GLNVG_PROG_GENERIC : (int)frag->type;
+}
+
+static void glnvg__setUniforms(GLNVGcontext* gl, int uniformOffset, int image)
+{
+	GLNVGtexture* tex = NULL;
+	glnvg__fragUniforms(gl, uniformOffset);
 
 	if (image != 0) {
 		tex = glnvg__findTexture(gl, image);
@@ -1047,6 +1460,13 @@ static void glnvg__setUniforms(GLNVGcontext* gl, int uniformOffset, int image)
 	if (tex == NULL) {
 		tex = glnvg__findTexture(gl, gl->dummyTex);
 	}
+#if NANOVG_GL_USE_TEXTURE_PAGES
+	if (tex != NULL && tex->pages > 0) {
+		glnvg__bindPages(gl, tex->tex);
+		glnvg__checkError(gl, "tex paint tex");
+		return;
+	}
+#endif
 	glnvg__bindTexture(gl, tex != NULL ? tex->tex : 0);
 	glnvg__checkError(gl, "tex paint tex");
 }
@@ -1059,10 +1479,19 @@ static void glnvg__renderViewport(void* uptr, float width, float height, float d
 	gl->view[1] = height;
 }
 
+static void glnvg__drawElements(GLNVGcontext* gl, int offset, int count)
+{
+	if (count <= 0) return;
+	if (gl->uintIndices)
+		glDrawElements(GL_TRIANGLES, count, GL_UNSIGNED_INT, (const GLvoid*)(gl->indexBuf.base + offset * sizeof(GLuint)));
+	else
+		glDrawArrays(GL_TRIANGLES, offset, count);
+}
+
 static void glnvg__fill(GLNVGcontext* gl, GLNVGcall* call)
 {
-	GLNVGpath* paths = &gl->paths[call->pathOffset];
-	int i, npaths = call->pathCount;
+	int fringeOffset = call->indexOffset + call->fillCount;
+	int quadOffset = fringeOffset + call->strokeCount;
 
 	// Draw shapes
 	glEnable(GL_STENCIL_TEST);
@@ -1071,19 +1500,20 @@ static void glnvg__fill(GLNVGcontext* gl, GLNVGcall* call)
 	glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
 
 	// set bindpoint for solid loc
+	glnvg__useProgram(gl, NSVG_SHADER_SIMPLE);
 	glnvg__setUniforms(gl, call->uniformOffset, 0);
 	glnvg__checkError(gl, "fill simple");
 
 	glStencilOpSeparate(GL_FRONT, GL_KEEP, GL_KEEP, GL_INCR_WRAP);
 	glStencilOpSeparate(GL_BACK, GL_KEEP, GL_KEEP, GL_DECR_WRAP);
 	glDisable(GL_CULL_FACE);
-	for (i = 0; i < npaths; i++)
-		glDrawArrays(GL_TRIANGLE_FAN, paths[i].fillOffset, paths[i].fillCount);
+	glnvg__drawElements(gl, call->indexOffset, call->fillCount);
 	glEnable(GL_CULL_FACE);
 
 	// Draw anti-aliased pixels
 	glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
 
+	glnvg__useProgram(gl, call->program);
 	glnvg__setUniforms(gl, call->uniformOffset + gl->fragSize, call->image);
 	glnvg__checkError(gl, "fill fill");
 
@@ -1091,40 +1521,30 @@ static void glnvg__fill(GLNVGcontext* gl, GLNVGcall* call)
 		glnvg__stencilFunc(gl, GL_EQUAL, 0x00, 0xff);
 		glStencilOp(GL_KEEP, GL_KEEP, GL_KEEP);
 		// Draw fringes
-		for (i = 0; i < npaths; i++)
-			glDrawArrays(GL_TRIANGLE_STRIP, paths[i].strokeOffset, paths[i].strokeCount);
+		glnvg__drawElements(gl, fringeOffset, call->strokeCount);
 	}
 
 	// Draw fill
 	glnvg__stencilFunc(gl, GL_NOTEQUAL, 0x0, 0xff);
 	glStencilOp(GL_ZERO, GL_ZERO, GL_ZERO);
-	glDrawArrays(GL_TRIANGLE_STRIP, call->triangleOffset, call->triangleCount);
+	glnvg__drawElements(gl, quadOffset, call->indexOffset + call->indexCount - quadOffset);
 
 	glDisable(GL_STENCIL_TEST);
 }
 
 static void glnvg__convexFill(GLNVGcontext* gl, GLNVGcall* call)
 {
-	GLNVGpath* paths = &gl->paths[call->pathOffset];
-	int i, npaths = call->pathCount;
-
+	glnvg__useProgram(gl, call->program);
 	glnvg__setUniforms(gl, call->uniformOffset, call->image);
 	glnvg__checkError(gl, "convex fill");
 
-	for (i = 0; i < npaths; i++) {
-		glDrawArrays(GL_TRIANGLE_FAN, paths[i].fillOffset, paths[i].fillCount);
-		// Draw fringes
-		if (paths[i].strokeCount > 0) {
-			glDrawArrays(GL_TRIANGLE_STRIP, paths[i].strokeOffset, paths[i].strokeCount);
-		}
-	}
+	// Fill and fringes
+	glnvg__drawElements(gl, call->indexOffset, call->indexCount);
 }
 
 static void glnvg__stroke(GLNVGcontext* gl, GLNVGcall* call)
 {
-	GLNVGpath* paths = &gl->paths[call->pathOffset];
-	int npaths = call->pathCount, i;
-
+	glnvg__useProgram(gl, call->program);
 	if (gl->flags & NVG_STENCIL_STROKES) {
 
 		glEnable(GL_STENCIL_TEST);
@@ -1135,23 +1555,20 @@ static void glnvg__stroke(GLNVGcontext* gl, GLNVGcall* call)
 		glStencilOp(GL_KEEP, GL_KEEP, GL_INCR);
 		glnvg__setUniforms(gl, call->uniformOffset + gl->fragSize, call->image);
 		glnvg__checkError(gl, "stroke fill 0");
-		for (i = 0; i < npaths; i++)
-			glDrawArrays(GL_TRIANGLE_STRIP, paths[i].strokeOffset, paths[i].strokeCount);
+		glnvg__drawElements(gl, call->indexOffset, call->indexCount);
 
 		// Draw anti-aliased pixels.
 		glnvg__setUniforms(gl, call->uniformOffset, call->image);
 		glnvg__stencilFunc(gl, GL_EQUAL, 0x00, 0xff);
 		glStencilOp(GL_KEEP, GL_KEEP, GL_KEEP);
-		for (i = 0; i < npaths; i++)
-			glDrawArrays(GL_TRIANGLE_STRIP, paths[i].strokeOffset, paths[i].strokeCount);
+		glnvg__drawElements(gl, call->indexOffset, call->indexCount);
 
 		// Clear stencil buffer.
 		glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
 		glnvg__stencilFunc(gl, GL_ALWAYS, 0x0, 0xff);
 		glStencilOp(GL_ZERO, GL_ZERO, GL_ZERO);
 		glnvg__checkError(gl, "stroke fill 1");
-		for (i = 0; i < npaths; i++)
-			glDrawArrays(GL_TRIANGLE_STRIP, paths[i].strokeOffset, paths[i].strokeCount);
+		glnvg__drawElements(gl, call->indexOffset, call->indexCount);
 		glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
 
 		glDisable(GL_STENCIL_TEST);
@@ -1162,23 +1579,86 @@ static void glnvg__stroke(GLNVGcontext* gl, GLNVGcall* call)
 		glnvg__setUniforms(gl, call->uniformOffset, call->image);
 		glnvg__checkError(gl, "stroke fill");
 		// Draw Strokes
-		for (i = 0; i < npaths; i++)
-			glDrawArrays(GL_TRIANGLE_STRIP, paths[i].strokeOffset, paths[i].strokeCount);
+		glnvg__drawElements(gl, call->indexOffset, call->indexCount);
 	}
 }
 
 static void glnvg__triangles(GLNVGcontext* gl, GLNVGcall* call)
 {
+	glnvg__useProgram(gl, call->program);
 	glnvg__setUniforms(gl, call->uniformOffset, call->image);
 	glnvg__checkError(gl, "triangles fill");
 
+	glnvg__drawElements(gl, call->indexOffset, call->indexCount);
+}
+
+static void glnvg__setVertexFormat(GLNVGcontext* gl, int shapes)
+{
+	if (shapes) {
+		glBindBuffer(GL_ARRAY_BUFFER, gl->shapeBuf.buf);
+		glEnableVertexAttribArray(2);
+		glEnableVertexAttribArray(3);
+		glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, sizeof(NVGshapeVertex), (const GLvoid*)(size_t)gl->shapeBuf.base);
+		glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, sizeof(NVGshapeVertex), (const GLvoid*)(gl->shapeBuf.base + 2*sizeof(float)));
+		glVertexAttribPointer(2, 4, GL_FLOAT, GL_FALSE, sizeof(NVGshapeVertex), (const GLvoid*)(gl->shapeBuf.base + 4*sizeof(float)));
+		glVertexAttribPointer(3, 4, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(NVGshapeVertex), (const GLvoid*)(gl->shapeBuf.base + 8*sizeof(float)));
+		glDisableVertexAttribArray(5);
+#if NANOVG_GL_USE_UNIFORMBUFFER
+		// Shapes are not merged, the disabled attribute reads as zero.
+		glDisableVertexAttribArray(4);
+#endif
+	} else {
+#if NANOVG_GL_USE_UNIFORMBUFFER
+		if (gl->npaints > 0) {
+			glBindBuffer(GL_ARRAY_BUFFER, gl->paintBuf.buf);
+			glEnableVertexAttribArray(4);
+			glVertexAttribPointer(4, 1, GL_FLOAT, GL_FALSE, sizeof(float), (const GLvoid*)(size_t)gl->paintBuf.base);
+		}
+#endif
+		if (gl->flags & NVG_COMPACT_VERTICES) {
+			// Without line styles the disabled attribute reads as zero.
+			if (gl->lineStyles) {
+				glBindBuffer(GL_ARRAY_BUFFER, gl->styleBuf.buf);
+				glEnableVertexAttribArray(5);
+				glVertexAttribPointer(5, 2, GL_FLOAT, GL_FALSE, 2*sizeof(float), (const GLvoid*)(size_t)gl->styleBuf.base);
+			}
+			glBindBuffer(GL_ARRAY_BUFFER, gl->vertBuf.buf);
+			glDisableVertexAttribArray(2);
+			glDisableVertexAttribArray(3);
+			glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, sizeof(GLNVGcompactVertex), (const GLvoid*)(size_t)gl->vertBuf.base);
+			glVertexAttribPointer(1, 2, GL_UNSIGNED_SHORT, GL_TRUE, sizeof(GLNVGcompactVertex), (const GLvoid*)(gl->vertBuf.base + 2*sizeof(float)));
+		} else {
+			glBindBuffer(GL_ARRAY_BUFFER, gl->vertBuf.buf);
+			glDisableVertexAttribArray(2);
+			glDisableVertexAttribArray(3);
+			glEnableVertexAttribArray(5);
+			glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, sizeof(NVGvertex), (const GLvoid*)(size_t)gl->vertBuf.base);
+			glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, sizeof(NVGvertex), (const GLvoid*)(gl->vertBuf.base + 2*sizeof(float)));
+			glVertexAttribPointer(5, 2, GL_FLOAT, GL_FALSE, sizeof(NVGvertex), (const GLvoid*)(gl->vertBuf.base + 4*sizeof(float)));
+		}
+	}
+}
+
+static void glnvg__shapes(GLNVGcontext* gl, GLNVGcall* call)
+{
+	glnvg__useProgram(gl, call->program);
+	glnvg__setUniforms(gl, call->uniformOffset, 0);
+	glnvg__checkError(gl, "shapes fill");
+
+	// The quads may be mirrored by the transform.
+	glnvg__setVertexFormat(gl, 1);
+	glDisable(GL_CULL_FACE);
 	glDrawArrays(GL_TRIANGLES, call->triangleOffset, call->triangleCount);
+	glEnable(GL_CULL_FACE);
+	glnvg__setVertexFormat(gl, 0);
 }
 
 static void glnvg__renderCancel(void* uptr) {
 	GLNVGcontext* gl = (GLNVGcontext*)uptr;
 	gl->nverts = 0;
-	gl->npaths = 0;
+	gl->lineStyles = 0;
+	gl->nshapeVerts = 0;
+	gl->nindices = 0;
 	gl->ncalls = 0;
 	gl->nuniforms = 0;
 }
@@ -1227,6 +1707,205 @@ static GLNVGblend glnvg__blendCompositeOperation(NVGcompositeOperationState op)
 	return blend;
 }
 
+#if NANOVG_GL_USE_UNIFORMBUFFER
+static int glnvg__canMerge(GLNVGcontext* gl, const GLNVGcall* call)
+{
+	if (call->type == GLNVG_CONVEXFILL || call->type == GLNVG_TRIANGLES)
+		return 1;
+	// Stencil strokes draw the same vertices with two different uniforms.
+	return call->type == GLNVG_STROKE && (gl->flags & NVG_STENCIL_STROKES) == 0;
+}
+
+static void glnvg__setPaints(GLNVGcontext* gl, const GLNVGcall* call, float paint)
+{
+	int i;
+	for (i = 0; i < call->vertCount; i++)
+		gl->paints[call->vertOffset + i] = paint;
+}
+
+// Calls without image do not sample the texture, they can use the one of the batch.
+// Batches of calls with different programs use the generic one.
+static void glnvg__setBatchState(GLNVGcontext* gl, int begin, int end, int image, int program)
+{
+	int i;
+	for (i = begin; i < end; i++) {
+		if (gl->calls[i].image == 0)
+			gl->calls[i].image = image;
+		gl->calls[i].program = program;
+	}
+}
+
+// Merges runs of calls with compatible texture, blending and stencil use into batches which
+// are drawn with one uniform binding. Each vertex gets the index of its call's uniforms in the
+// batch, and the calls of a batch become one indexed draw.
+static int glnvg__mergeCalls(GLNVGcontext* gl)
+{
+	GLNVGcall* batch = NULL;
+	GLNVGcall* prev = NULL;
+	int i, start = 0, image = 0, program = 0;
+
+	gl->npaints = 0;
+	if (gl->nverts > gl->cpaints) {
+		float* paints;
+		int cpaints = gl->cverts;
+		paints = (float*)realloc(gl->paints, sizeof(float) * cpaints);
+		if (paints == NULL) return 0;
+		gl->paints = paints;
+		gl->cpaints = cpaints;
+	}
+
+	for (i = 0; i < gl->ncalls; i++) {
+		GLNVGcall* call = &gl->calls[i];
+		int index;
+		if (batch != NULL && glnvg__canMerge(gl, call) &&
+			(call->image == 0 || image == 0 || call->image == image) &&
+			memcmp(&call->blendFunc, &batch->blendFunc, sizeof(GLNVGblend)) == 0 &&
+			call->uniformOffset - batch->uniformOffset < gl->batchSize * gl->fragSize) {
+			index = (call->uniformOffset - batch->uniformOffset) / gl->fragSize;
+			call->uniformOffset = batch->uniformOffset;
+			if (call->program != program)
+				program = GLNVG_PROG_GENERIC;
+		} else {
+			if (batch != NULL)
+				glnvg__setBatchState(gl, start, i, image, program);
+			batch = NULL;
+			if (call->type == GLNVG_SHAPES)
+				continue;
+			if (!glnvg__canMerge(gl, call)) {
+				glnvg__setPaints(gl, call, 0.0f);
+				continue;
+			}
+			batch = call;
+			prev = NULL;
+			start = i;
+			image = 0;
+			program = call->program;
+			index = 0;
+		}
+		if (call->image != 0)
+			image = call->image;
+		glnvg__setPaints(gl, call, (float)index);
+		// The batch shares texture and uniform binding, all its calls draw plain triangle lists.
+		if (prev != NULL && prev->indexOffset + prev->indexCount == call->indexOffset) {
+			prev->indexCount += call->indexCount;
+			call->type = GLNVG_NONE;
+		} else {
+			prev = call;
+		}
+	}
+	if (batch != NULL)
+		glnvg__setBatchState(gl, start, gl->ncalls, image, program);
+	gl->npaints = gl->nverts;
+
+	return 1;
+}
+#endif
+
+static unsigned short glnvg__unorm16(float a)
+{
+	return (unsigned short)((a < 0.0f ? 0.0f : (a > 1.0f ? 1.0f : a)) * 65535.0f + 0.5f);
+}
+
+static void glnvg__packVerts(GLNVGcontext* gl)
+{
+	int i;
+	for (i = 0; i < gl->nverts; i++) {
+		const NVGvertex* src = &gl->verts[i];
+		GLNVGcompactVertex* dst = &gl->packedVerts[i];
+		dst->x = src->x;
+		dst->y = src->y;
+		dst->u = glnvg__unorm16(src->u);
+		dst->v = glnvg__unorm16(src->v);
+	}
+	if (gl->lineStyles) {
+		for (i = 0; i < gl->nverts; i++) {
+			gl->styles[i*2+0] = gl->verts[i].s;
+			gl->styles[i*2+1] = gl->verts[i].t;
+		}
+	}
+}
+
+// Uploads one frame of data, reserve is the room the draws may address past the data.
+static void glnvg__streamData(GLNVGcontext* gl, GLNVGstream* stream, GLenum target, const void* data, int size, int reserve)
+{
+	reserve = glnvg__maxi(size, reserve);
+	glBindBuffer(target, stream->buf);
+#if NANOVG_GL_USE_MAPPED_STREAM
+	if (reserve > stream->size) {
+		// Region offsets must suit uniform buffer bindings, which the uniform size already does.
+		int grow = glnvg__maxi(reserve, stream->size + stream->size/2); // 1.5x Overallocate
+		stream->size = (grow + gl->fragSize - 1) / gl->fragSize * gl->fragSize;
+		// Orphans the old storage, frames in flight keep using it.
+		glBufferData(target, stream->size * NANOVG_GL_STREAM_FRAMES, NULL, GL_STREAM_DRAW);
+	}
+	stream->base = gl->streamRegion * stream->size;
+	if (size > 0) {
+		void* dst = glMapBufferRange(target, stream->base, size, GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT | GL_MAP_UNSYNCHRONIZED_BIT);
+		if (dst != NULL) {
+			memcpy(dst, data, size);
+			glUnmapBuffer(target);
+		} else {
+			glBufferSubData(target, stream->base, size, data);
+		}
+	}
+#else
+	// Orphan the storage of the previous frame, keeping the size of the largest frame.
+	if (reserve > stream->size)
+		stream->size = glnvg__maxi(reserve, stream->size + stream->size/2); // 1.5x Overallocate
+	stream->base = 0;
+	glBufferData(target, stream->size, NULL, GL_STREAM_DRAW);
+	glBufferSubData(target, 0, size, data);
+	NVG_NOTUSED(gl);
+#endif
+}
+
+#if NANOVG_GL_USE_MAPPED_STREAM
+// Moves to the next ring region, waiting until the GPU is done with its previous frame.
+static void glnvg__nextStreamRegion(GLNVGcontext* gl)
+{
+	GLsync fence;
+	gl->streamRegion = (gl->streamRegion + 1) % NANOVG_GL_STREAM_FRAMES;
+	fence = gl->fences[gl->streamRegion];
+	if (fence != NULL) {
+		GLenum res;
+		do {
+			res = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000000);
+		} while (res == GL_TIMEOUT_EXPIRED);
+		glDeleteSync(fence);
+		gl->fences[gl->streamRegion] = NULL;
+	}
+}
+#endif
+
+static int glnvg__allocVerts(GLNVGcontext* gl, int n);
+
+// Replaces the vertices with a copy of each indexed vertex, so that index i is vertex i.
+static int glnvg__unindexVerts(GLNVGcontext* gl)
+{
+	int i, nverts = gl->nverts;
+	if (glnvg__allocVerts(gl, gl->nindices) == -1) return 0;
+	for (i = 0; i < gl->nindices; i++)
+		gl->verts[nverts + i] = gl->verts[gl->indices[i]];
+	memmove(gl->verts, &gl->verts[nverts], sizeof(NVGvertex) * gl->nindices);
+	gl->nverts = gl->nindices;
+#if NANOVG_GL_USE_UNIFORMBUFFER
+	// The batch indices of the vertices are copied the same way.
+	if (gl->npaints > 0) {
+		if (nverts + gl->nindices > gl->cpaints) {
+			float* paints = (float*)realloc(gl->paints, sizeof(float) * (nverts + gl->nindices));
+			if (paints == NULL) return 0;
+			gl->paints = paints;
+			gl->cpaints = nverts + gl->nindices;
+		}
+		for (i = 0; i < gl->nindices; i++)
+			gl->paints[nverts + i] = gl->paints[gl->indices[i]];
+		memmove(gl->paints, &gl->paints[nverts], sizeof(float) * gl->nindices);
+		gl->npaints = gl->nindices;
+	}
+#endif
+	return 1;
+}
+
 static void glnvg__renderFlush(void* uptr)
 {
 	GLNVGcontext* gl = (GLNVGcontext*)uptr;
@@ -1235,7 +1914,7 @@ static void glnvg__renderFlush(void* uptr)
 	if (gl->ncalls > 0) {
 
 		// Setup require GL state.
-		glUseProgram(gl->shader.prog);
+		gl->program = -1;
 
 		glEnable(GL_CULL_FACE);
 		glCullFace(GL_BACK);
@@ -1251,6 +1930,7 @@ static void glnvg__renderFlush(void* uptr)
 		glBindTexture(GL_TEXTURE_2D, 0);
 		#if NANOVG_GL_USE_STATE_FILTER
 		gl->boundTexture = 0;
+		gl->boundPages = 0;
 		gl->stencilMask = 0xffffffff;
 		gl->stencilFunc = GL_ALWAYS;
 		gl->stencilFuncRef = 0;
@@ -1259,35 +1939,55 @@ static void glnvg__renderFlush(void* uptr)
 		gl->blendFunc.srcAlpha = GL_INVALID_ENUM;
 		gl->blendFunc.dstRGB = GL_INVALID_ENUM;
 		gl->blendFunc.dstAlpha = GL_INVALID_ENUM;
+		gl->boundUniforms = -1;
 		#endif
 
+#if NANOVG_GL_USE_MAPPED_STREAM
+		glnvg__nextStreamRegion(gl);
+#endif
 #if NANOVG_GL_USE_UNIFORMBUFFER
-		// Upload ubo for frag shaders
-		glBindBuffer(GL_UNIFORM_BUFFER, gl->fragBuf);
-		glBufferData(GL_UNIFORM_BUFFER, gl->nuniforms * gl->fragSize, gl->uniforms, GL_STREAM_DRAW);
+		glnvg__mergeCalls(gl);
+
+		// Upload ubo for frag shaders, with room to bind a whole batch at the last uniforms.
+		glnvg__streamData(gl, &gl->fragBuf, GL_UNIFORM_BUFFER, gl->uniforms, gl->nuniforms * gl->fragSize, (gl->nuniforms + gl->batchSize) * gl->fragSize);
 #endif
 
+		// Without 32-bit indices the frame can not be drawn if the copy fails.
+		if (!gl->uintIndices && !glnvg__unindexVerts(gl))
+			gl->ncalls = 0;
+
 		// Upload vertex data
 #if defined NANOVG_GL3
 		glBindVertexArray(gl->vertArr);
 #endif
-		glBindBuffer(GL_ARRAY_BUFFER, gl->vertBuf);
-		glBufferData(GL_ARRAY_BUFFER, gl->nverts * sizeof(NVGvertex), gl->verts, GL_STREAM_DRAW);
+		if (gl->nshapeVerts > 0)
+			glnvg__streamData(gl, &gl->shapeBuf, GL_ARRAY_BUFFER, gl->shapeVerts, gl->nshapeVerts * sizeof(NVGshapeVertex), 0);
+#if NANOVG_GL_USE_UNIFORMBUFFER
+		if (gl->npaints > 0)
+			glnvg__streamData(gl, &gl->paintBuf, GL_ARRAY_BUFFER, gl->paints, gl->npaints * sizeof(float), 0);
+#endif
+		if (gl->flags & NVG_COMPACT_VERTICES) {
+			glnvg__packVerts(gl);
+			if (gl->lineStyles)
+				glnvg__streamData(gl, &gl->styleBuf, GL_ARRAY_BUFFER, gl->styles, gl->nverts * 2*sizeof(float), 0);
+			glnvg__streamData(gl, &gl->vertBuf, GL_ARRAY_BUFFER, gl->packedVerts, gl->nverts * sizeof(GLNVGcompactVertex), 0);
+		} else {
+			glnvg__streamData(gl, &gl->vertBuf, GL_ARRAY_BUFFER, gl->verts, gl->nverts * sizeof(NVGvertex), 0);
+		}
+		if (gl->uintIndices)
+			glnvg__streamData(gl, &gl->indexBuf, GL_ELEMENT_ARRAY_BUFFER, gl->indices, gl->nindices * sizeof(GLuint), 0);
 		glEnableVertexAttribArray(0);
 		glEnableVertexAttribArray(1);
-		glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, sizeof(NVGvertex), (const GLvoid*)(size_t)0);
-		glVertexAttribPointer(1, 4, GL_FLOAT, GL_FALSE, sizeof(NVGvertex), (const GLvoid*)(0 + 2*sizeof(float)));
-
-		// Set view and texture just once per frame.
-		glUniform1i(gl->shader.loc[GLNVG_LOC_TEX], 0);
-		glUniform2fv(gl->shader.loc[GLNVG_LOC_VIEWSIZE], 1, gl->view);
+		glnvg__setVertexFormat(gl, 0);
 
 #if NANOVG_GL_USE_UNIFORMBUFFER
-		glBindBuffer(GL_UNIFORM_BUFFER, gl->fragBuf);
+		glBindBuffer(GL_UNIFORM_BUFFER, gl->fragBuf.buf);
 #endif
 
 		for (i = 0; i < gl->ncalls; i++) {
 			GLNVGcall* call = &gl->calls[i];
+			if (call->type == GLNVG_NONE)
+				continue;
 			glnvg__blendFuncSeparate(gl,&call->blendFunc);
 			if (call->type == GLNVG_FILL)
 				glnvg__fill(gl, call);
@@ -1297,34 +1997,207 @@ static void glnvg__renderFlush(void* uptr)
 				glnvg__stroke(gl, call);
 			else if (call->type == GLNVG_TRIANGLES)
 				glnvg__triangles(gl, call);
+			else if (call->type == GLNVG_SHAPES)
+				glnvg__shapes(gl, call);
 		}
 
 		glDisableVertexAttribArray(0);
 		glDisableVertexAttribArray(1);
+		glDisableVertexAttribArray(5);
+#if NANOVG_GL_USE_UNIFORMBUFFER
+		glDisableVertexAttribArray(4);
+#endif
+		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
 #if defined NANOVG_GL3
 		glBindVertexArray(0);
 #endif
 		glDisable(GL_CULL_FACE);
-			glBindBuffer(GL_ARRAY_BUFFER, 0);
+		glBindBuffer(GL_ARRAY_BUFFER, 0);
 		glUseProgram(0);
 		glnvg__bindTexture(gl, 0);
+#if NANOVG_GL_USE_TEXTURE_PAGES
+		glnvg__bindPages(gl, 0);
+#endif
+#if NANOVG_GL_USE_MAPPED_STREAM
+		gl->fences[gl->streamRegion] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+#endif
 	}
 
 	// Reset calls
 	gl->nverts = 0;
-	gl->npaths = 0;
+	gl->lineStyles = 0;
+	gl->nshapeVerts = 0;
+	gl->nindices = 0;
 	gl->ncalls = 0;
 	gl->nuniforms = 0;
 }
 
-static int glnvg__maxVertCount(const NVGpath* paths, int npaths)
+// Closed strips repeat their first two vertices at the end, those are indexed instead of copied.
+// Dashed strokes carry the distance along the path in t, which differs between the two.
+static int glnvg__isLoop(const NVGvertex* verts, int n, int dashed)
 {
-	int i, count = 0;
-	for (i = 0; i < npaths; i++) {
-		count += paths[i].nfill;
-		count += paths[i].nstroke;
+	const NVGvertex* end = &verts[n-2];
+	int i;
+	if (n < 6) return 0;
+	for (i = 0; i < 2; i++) {
+		if (verts[i].x != end[i].x || verts[i].y != end[i].y || verts[i].u != end[i].u ||
+			verts[i].v != end[i].v || verts[i].s != end[i].s || (dashed && verts[i].t != end[i].t))
+			return 0;
+	}
+	return 1;
+}
+
+static int glnvg__triCount(int n)
+{
+	return n > 2 ? (n - 2) * 3 : 0;
+}
+
+static int glnvg__stripVertCount(const NVGvertex* verts, int n, int dashed)
+{
+	return glnvg__isLoop(verts, n, dashed) ? n - 2 : n;
+}
+
+static void glnvg__copyFan(GLNVGcontext* gl, int* offset, int* index, const NVGvertex* verts, int n)
+{
+	GLuint* dst = &gl->indices[*index];
+	int i;
+	memcpy(&gl->verts[*offset], verts, sizeof(NVGvertex) * n);
+	for (i = 1; i+1 < n; i++) {
+		*dst++ = *offset;
+		*dst++ = *offset + i;
+		*dst++ = *offset + i + 1;
+	}
+	*offset += n;
+	*index += glnvg__triCount(n);
+}
+
+// Odd triangles of a strip swap their first two vertices to keep the winding of GL_TRIANGLE_STRIP.
+static void glnvg__copyStrip(GLNVGcontext* gl, int* offset, int* index, const NVGvertex* verts, int n, int dashed)
+{
+	GLuint* dst = &gl->indices[*index];
+	int nv = glnvg__stripVertCount(verts, n, dashed);
+	int i, j;
+	memcpy(&gl->verts[*offset], verts, sizeof(NVGvertex) * nv);
+	for (i = 0; i+2 < n; i++) {
+		int tri[3] = { i + (i & 1), i + 1 - (i & 1), i + 2 };
+		for (j = 0; j < 3; j++)
+			*dst++ = *offset + (tri[j] < nv ? tri[j] : tri[j] - nv);
+	}
+	*offset += nv;
+	*index += glnvg__triCount(n);
+}
+
+static float glnvg__cross(const NVGvertex* a, const NVGvertex* b, const NVGvertex* c)
+{
+	return (b->x - a->x) * (c->y - a->y) - (b->y - a->y) * (c->x - a->x);
+}
+
+// Touching counts as intersecting, such polygons are left to the stencil fill.
+static int glnvg__segmentsIntersect(const NVGvertex* a0, const NVGvertex* a1, const NVGvertex* b0, const NVGvertex* b1)
+{
+	float d0 = glnvg__cross(a0, a1, b0), d1 = glnvg__cross(a0, a1, b1);
+	float d2 = glnvg__cross(b0, b1, a0), d3 = glnvg__cross(b0, b1, a1);
+	if (d0 == 0.0f && d1 == 0.0f) {
+		// Collinear, check if the extents overlap.
+		return glnvg__minf(a0->x, a1->x) <= glnvg__maxf(b0->x, b1->x) && glnvg__minf(b0->x, b1->x) <= glnvg__maxf(a0->x, a1->x)
+			&& glnvg__minf(a0->y, a1->y) <= glnvg__maxf(b0->y, b1->y) && glnvg__minf(b0->y, b1->y) <= glnvg__maxf(a0->y, a1->y);
+	}
+	return (d0 <= 0.0f) != (d1 < 0.0f) && (d2 <= 0.0f) != (d3 < 0.0f);
+}
+
+static int glnvg__isSimplePolygon(const NVGvertex* verts, int n)
+{
+	int i, j;
+	for (i = 0; i < n; i++) {
+		for (j = i + 2; j < n; j++) {
+			if (i == 0 && j == n-1) continue; // Adjacent
+			if (glnvg__segmentsIntersect(&verts[i], &verts[i+1], &verts[j], &verts[(j+1) % n]))
+				return 0;
+		}
+	}
+	return 1;
+}
+
+static int glnvg__isEar(const NVGvertex* verts, const int* next, int p, int v, int q, float dir)
+{
+	const NVGvertex* a = &verts[p];
+	const NVGvertex* b = &verts[v];
+	const NVGvertex* c = &verts[q];
+	int i;
+	for (i = next[q]; i != p; i = next[i]) {
+		const NVGvertex* w = &verts[i];
+		if ((w->x == a->x && w->y == a->y) || (w->x == b->x && w->y == b->y) || (w->x == c->x && w->y == c->y))
+			continue;
+		if (glnvg__cross(a, b, w) * dir >= 0.0f && glnvg__cross(b, c, w) * dir >= 0.0f && glnvg__cross(c, a, w) * dir >= 0.0f)
+			return 0;
 	}
-	return count;
+	return 1;
+}
+
+// Ear clips a simple polygon into gl->ears, returns the number of indices or 0 if the
+// polygon needs the stencil fill. Triangles keep the winding of the polygon.
+static int glnvg__triangulate(GLNVGcontext* gl, const NVGvertex* verts, int n)
+{
+	int *next, *prev, *tris;
+	int i, v, nleft, stall, ntris = 0;
+	float area = 0.0f, dir;
+
+	if (n < 4 || n > NANOVG_GL_TRIANGULATE_MAX_VERTS) return 0;
+	for (i = 0; i < n; i++)
+		area += glnvg__cross(&verts[0], &verts[i], &verts[(i+1) % n]);
+	if (area == 0.0f || !glnvg__isSimplePolygon(verts, n)) return 0;
+	dir = area > 0.0f ? 1.0f : -1.0f;
+
+	if (n * 5 > gl->cears) {
+		int cears = n * 5 + gl->cears/2; // 1.5x Overallocate
+		int* ears = (int*)realloc(gl->ears, sizeof(int) * cears);
+		if (ears == NULL) return 0;
+		gl->ears = ears;
+		gl->cears = cears;
+	}
+	next = gl->ears;
+	prev = next + n;
+	tris = prev + n;
+	for (i = 0; i < n; i++) {
+		next[i] = (i+1) % n;
+		prev[i] = (i+n-1) % n;
+	}
+
+	v = 0;
+	nleft = n;
+	stall = 0;
+	while (nleft > 2) {
+		int p = prev[v], q = next[v];
+		float c = glnvg__cross(&verts[p], &verts[v], &verts[q]) * dir;
+		int ear = c > 0.0f && glnvg__isEar(verts, next, p, v, q, dir);
+		if (ear) {
+			tris[ntris++] = p;
+			tris[ntris++] = v;
+			tris[ntris++] = q;
+		}
+		if (ear || c == 0.0f) {
+			// Clip the ear, collinear vertices are dropped without a triangle.
+			next[p] = q;
+			prev[q] = p;
+			nleft--;
+			stall = 0;
+		} else if (++stall > nleft) {
+			return 0;
+		}
+		v = q;
+	}
+	return ntris;
+}
+
+static void glnvg__copyTriangles(GLNVGcontext* gl, int* offset, int* index, const NVGvertex* verts, int n, const int* tris, int ntris)
+{
+	GLuint* dst = &gl->indices[*index];
+	int i;
+	memcpy(&gl->verts[*offset], verts, sizeof(NVGvertex) * n);
+	for (i = 0; i < ntris; i++)
+		dst[i] = *offset + tris[i];
+	*offset += n;
+	*index += ntris;
 }
 
 static GLNVGcall* glnvg__allocCall(GLNVGcontext* gl)
@@ -1343,22 +2216,6 @@ static GLNVGcall* glnvg__allocCall(GLNVGcontext* gl)
 	return ret;
 }
 
-static int glnvg__allocPaths(GLNVGcontext* gl, int n)
-{
-	int ret = 0;
-	if (gl->npaths+n > gl->cpaths) {
-		GLNVGpath* paths;
-		int cpaths = glnvg__maxi(gl->npaths + n, 128) + gl->cpaths/2; // 1.5x Overallocate
-		paths = (GLNVGpath*)realloc(gl->paths, sizeof(GLNVGpath) * cpaths);
-		if (paths == NULL) return -1;
-		gl->paths = paths;
-		gl->cpaths = cpaths;
-	}
-	ret = gl->npaths;
-	gl->npaths += n;
-	return ret;
-}
-
 static int glnvg__allocVerts(GLNVGcontext* gl, int n)
 {
 	int ret = 0;
@@ -1368,6 +2225,16 @@ static int glnvg__allocVerts(GLNVGcontext* gl, int n)
 		verts = (NVGvertex*)realloc(gl->verts, sizeof(NVGvertex) * cverts);
 		if (verts == NULL) return -1;
 		gl->verts = verts;
+		if (gl->flags & NVG_COMPACT_VERTICES) {
+			GLNVGcompactVertex* packedVerts;
+			float* styles;
+			packedVerts = (GLNVGcompactVertex*)realloc(gl->packedVerts, sizeof(GLNVGcompactVertex) * cverts);
+			if (packedVerts == NULL) return -1;
+			gl->packedVerts = packedVerts;
+			styles = (float*)realloc(gl->styles, sizeof(float) * 2 * cverts);
+			if (styles == NULL) return -1;
+			gl->styles = styles;
+		}
 		gl->cverts = cverts;
 	}
 	ret = gl->nverts;
@@ -1375,6 +2242,38 @@ static int glnvg__allocVerts(GLNVGcontext* gl, int n)
 	return ret;
 }
 
+static int glnvg__allocIndices(GLNVGcontext* gl, int n)
+{
+	int ret = 0;
+	if (gl->nindices+n > gl->cindices) {
+		GLuint* indices;
+		int cindices = glnvg__maxi(gl->nindices + n, 8192) + gl->cindices/2; // 1.5x Overallocate
+		indices = (GLuint*)realloc(gl->indices, sizeof(GLuint) * cindices);
+		if (indices == NULL) return -1;
+		gl->indices = indices;
+		gl->cindices = cindices;
+	}
+	ret = gl->nindices;
+	gl->nindices += n;
+	return ret;
+}
+
+static int glnvg__allocShapeVerts(GLNVGcontext* gl, int n)
+{
+	int ret = 0;
+	if (gl->nshapeVerts+n > gl->cshapeVerts) {
+		NVGshapeVertex* verts;
+		int cverts = glnvg__maxi(gl->nshapeVerts + n, 4096) + gl->cshapeVerts/2; // 1.5x Overallocate
+		verts = (NVGshapeVertex*)realloc(gl->shapeVerts, sizeof(NVGshapeVertex) * cverts);
+		if (verts == NULL) return -1;
+		gl->shapeVerts = verts;
+		gl->cshapeVerts = cverts;
+	}
+	ret = gl->nshapeVerts;
+	gl->nshapeVerts += n;
+	return ret;
+}
+
 static int glnvg__allocFragUniforms(GLNVGcontext* gl, int n)
 {
 	int ret = 0, structSize = gl->fragSize;
@@ -1409,58 +2308,71 @@ static void glnvg__renderFill(void* uptr, NVGpaint* paint, NVGcompositeOperation
 {
 	GLNVGcontext* gl = (GLNVGcontext*)uptr;
 	GLNVGcall* call = glnvg__allocCall(gl);
-	NVGvertex* quad;
 	GLNVGfragUniforms* frag;
-	int i, maxverts, offset;
+	int i, offset, index, ntris = 0;
 
 	if (call == NULL) return;
 
 	call->type = GLNVG_FILL;
-	call->triangleCount = 4;
-	call->pathOffset = glnvg__allocPaths(gl, npaths);
-	if (call->pathOffset == -1) goto error;
-	call->pathCount = npaths;
 	call->image = paint->image;
 	call->blendFunc = glnvg__blendCompositeOperation(compositeOperation);
 
 	if (npaths == 1 && paths[0].convex)
-	{
 		call->type = GLNVG_CONVEXFILL;
-		call->triangleCount = 0;	// Bounding box fill quad not needed for convex fill
+	else if (npaths == 1 && (gl->flags & NVG_TRIANGULATE_FILLS)
+			 && (paths[0].nstroke == 0 || paths[0].nstroke == paths[0].nfill*2 + 2)) {
+		// Simple concave paths are drawn like convex ones, without the stencil passes. Paths with
+		// bevels are skipped, otherwise each fill vertex pairs with one fringe vertex pair.
+		ntris = glnvg__triangulate(gl, paths[0].fill, paths[0].nfill);
+		if (ntris > 0)
+			call->type = GLNVG_CONVEXFILL;
 	}
 
-	// Allocate vertices for all the paths.
-	maxverts = glnvg__maxVertCount(paths, npaths) + call->triangleCount;
-	offset = glnvg__allocVerts(gl, maxverts);
-	if (offset == -1) goto error;
-
+	// Allocate vertices and indices for all the paths.
 	for (i = 0; i < npaths; i++) {
-		GLNVGpath* copy = &gl->paths[call->pathOffset + i];
-		const NVGpath* path = &paths[i];
-		memset(copy, 0, sizeof(GLNVGpath));
-		if (path->nfill > 0) {
-			copy->fillOffset = offset;
-			copy->fillCount = path->nfill;
-			memcpy(&gl->verts[offset], path->fill, sizeof(NVGvertex) * path->nfill);
-			offset += path->nfill;
-		}
-		if (path->nstroke > 0) {
-			copy->strokeOffset = offset;
-			copy->strokeCount = path->nstroke;
-			memcpy(&gl->verts[offset], path->stroke, sizeof(NVGvertex) * path->nstroke);
-			offset += path->nstroke;
-		}
+		call->vertCount += paths[i].nfill + glnvg__stripVertCount(paths[i].stroke, paths[i].nstroke, 0);
+		call->fillCount += glnvg__triCount(paths[i].nfill);
+		call->strokeCount += glnvg__triCount(paths[i].nstroke);
+	}
+	if (ntris > 0)
+		call->fillCount = ntris;
+	call->indexCount = call->fillCount + call->strokeCount;
+	if (call->type == GLNVG_FILL) {
+		// Bounding box fill quad not needed for convex fill
+		call->vertCount += 4;
+		call->indexCount += 6;
+	}
+	call->vertOffset = glnvg__allocVerts(gl, call->vertCount);
+	if (call->vertOffset == -1) goto error;
+	call->indexOffset = glnvg__allocIndices(gl, call->indexCount);
+	if (call->indexOffset == -1) goto error;
+
+	// Fans of all paths first, so that the stencil pass is one draw.
+	offset = call->vertOffset;
+	index = call->indexOffset;
+	if (ntris > 0)
+		glnvg__copyTriangles(gl, &offset, &index, paths[0].fill, paths[0].nfill, gl->ears + paths[0].nfill*2, ntris);
+	else {
+		for (i = 0; i < npaths; i++)
+			glnvg__copyFan(gl, &offset, &index, paths[i].fill, paths[i].nfill);
+	}
+	for (i = 0; i < npaths; i++)
+		glnvg__copyStrip(gl, &offset, &index, paths[i].stroke, paths[i].nstroke, 0);
+	if (ntris > 0 && paths[0].nstroke > 0) {
+		// Keep only the outer half of the fringe, which starts at the fill vertices.
+		for (i = 0; i < paths[0].nfill; i++)
+			gl->verts[call->vertOffset + paths[0].nfill + i*2] = paths[0].fill[i];
 	}
 
 	// Setup uniforms for draw calls
 	if (call->type == GLNVG_FILL) {
-		// Quad
-		call->triangleOffset = offset;
-		quad = &gl->verts[call->triangleOffset];
+		NVGvertex quad[4];
+		memset(quad, 0, sizeof(quad));
 		glnvg__vset(&quad[0], bounds[2], bounds[3], 0.5f, 1.0f);
 		glnvg__vset(&quad[1], bounds[2], bounds[1], 0.5f, 1.0f);
 		glnvg__vset(&quad[2], bounds[0], bounds[3], 0.5f, 1.0f);
 		glnvg__vset(&quad[3], bounds[0], bounds[1], 0.5f, 1.0f);
+		glnvg__copyStrip(gl, &offset, &index, quad, 4, 0);
 
 		call->uniformOffset = glnvg__allocFragUniforms(gl, 2);
 		if (call->uniformOffset == -1) goto error;
@@ -1470,13 +2382,16 @@ static void glnvg__renderFill(void* uptr, NVGpaint* paint, NVGcompositeOperation
 		frag->strokeThr = -1.0f;
 		frag->type = NSVG_SHADER_SIMPLE;
 		// Fill shader
-		glnvg__convertPaint(gl, nvg__fragUniformPtr(gl, call->uniformOffset + gl->fragSize), paint, scissor, fringe, fringe, -1.0f, 0);
+		frag = nvg__fragUniformPtr(gl, call->uniformOffset + gl->fragSize);
+		glnvg__convertPaint(gl, frag, paint, scissor, fringe, fringe, -1.0f, 0);
 	} else {
 		call->uniformOffset = glnvg__allocFragUniforms(gl, 1);
 		if (call->uniformOffset == -1) goto error;
 		// Fill shader
-		glnvg__convertPaint(gl, nvg__fragUniformPtr(gl, call->uniformOffset), paint, scissor, fringe, fringe, -1.0f, 0);
+		frag = nvg__fragUniformPtr(gl, call->uniformOffset);
+		glnvg__convertPaint(gl, frag, paint, scissor, fringe, fringe, -1.0f, 0);
 	}
+	call->program = glnvg__program(frag);
 
 	return;
 
@@ -1491,33 +2406,29 @@ static void glnvg__renderStroke(void* uptr, NVGpaint* paint, NVGcompositeOperati
 {
 	GLNVGcontext* gl = (GLNVGcontext*)uptr;
 	GLNVGcall* call = glnvg__allocCall(gl);
-	int i, maxverts, offset;
+	int i, offset, index;
 
 	if (call == NULL) return;
 
 	call->type = GLNVG_STROKE;
-	call->pathOffset = glnvg__allocPaths(gl, npaths);
-	if (call->pathOffset == -1) goto error;
-	call->pathCount = npaths;
 	call->image = paint->image;
 	call->blendFunc = glnvg__blendCompositeOperation(compositeOperation);
 
-	// Allocate vertices for all the paths.
-	maxverts = glnvg__maxVertCount(paths, npaths);
-	offset = glnvg__allocVerts(gl, maxverts);
-	if (offset == -1) goto error;
-
+	// Allocate vertices and indices for all the paths.
 	for (i = 0; i < npaths; i++) {
-		GLNVGpath* copy = &gl->paths[call->pathOffset + i];
-		const NVGpath* path = &paths[i];
-		memset(copy, 0, sizeof(GLNVGpath));
-		if (path->nstroke) {
-			copy->strokeOffset = offset;
-			copy->strokeCount = path->nstroke;
-			memcpy(&gl->verts[offset], path->stroke, sizeof(NVGvertex) * path->nstroke);
-			offset += path->nstroke;
-		}
+		call->vertCount += glnvg__stripVertCount(paths[i].stroke, paths[i].nstroke, lineStyle > 1);
+		call->indexCount += glnvg__triCount(paths[i].nstroke);
 	}
+	call->strokeCount = call->indexCount;
+	call->vertOffset = glnvg__allocVerts(gl, call->vertCount);
+	if (call->vertOffset == -1) goto error;
+	call->indexOffset = glnvg__allocIndices(gl, call->indexCount);
+	if (call->indexOffset == -1) goto error;
+
+	offset = call->vertOffset;
+	index = call->indexOffset;
+	for (i = 0; i < npaths; i++)
+		glnvg__copyStrip(gl, &offset, &index, paths[i].stroke, paths[i].nstroke, lineStyle > 1);
 
 	if (gl->flags & NVG_STENCIL_STROKES) {
 		// Fill shader
@@ -1533,6 +2444,9 @@ static void glnvg__renderStroke(void* uptr, NVGpaint* paint, NVGcompositeOperati
 		if (call->uniformOffset == -1) goto error;
 		glnvg__convertPaint(gl, nvg__fragUniformPtr(gl, call->uniformOffset), paint, scissor, strokeWidth, fringe, -1.0f, lineStyle);
 	}
+	call->program = glnvg__program(nvg__fragUniformPtr(gl, call->uniformOffset));
+	if (lineStyle > 1)
+		gl->lineStyles = 1;
 
 	return;
 
@@ -1542,12 +2456,13 @@ error:
 	if (gl->ncalls > 0) gl->ncalls--;
 }
 
-static void glnvg__renderTriangles(void* uptr, NVGpaint* paint, NVGcompositeOperationState compositeOperation, NVGscissor* scissor,
-								   const NVGvertex* verts, int nverts, float fringe)
+static void glnvg__renderSDFTriangles(void* uptr, NVGpaint* paint, NVGcompositeOperationState compositeOperation, NVGscissor* scissor,
+									  const NVGvertex* verts, int nverts, float fringe, float sdfScale, float sdfBias)
 {
 	GLNVGcontext* gl = (GLNVGcontext*)uptr;
 	GLNVGcall* call = glnvg__allocCall(gl);
 	GLNVGfragUniforms* frag;
+	int i;
 
 	if (call == NULL) return;
 
@@ -1556,11 +2471,16 @@ static void glnvg__renderTriangles(void* uptr, NVGpaint* paint, NVGcompositeOper
 	call->blendFunc = glnvg__blendCompositeOperation(compositeOperation);
 
 	// Allocate vertices for all the paths.
-	call->triangleOffset = glnvg__allocVerts(gl, nverts);
-	if (call->triangleOffset == -1) goto error;
-	call->triangleCount = nverts;
+	call->vertOffset = glnvg__allocVerts(gl, nverts);
+	if (call->vertOffset == -1) goto error;
+	call->vertCount = nverts;
+	call->indexOffset = glnvg__allocIndices(gl, nverts);
+	if (call->indexOffset == -1) goto error;
+	call->indexCount = nverts;
 
-	memcpy(&gl->verts[call->triangleOffset], verts, sizeof(NVGvertex) * nverts);
+	memcpy(&gl->verts[call->vertOffset], verts, sizeof(NVGvertex) * nverts);
+	for (i = 0; i < nverts; i++)
+		gl->indices[call->indexOffset + i] = call->vertOffset + i;
 
 	// Fill shader
 	call->uniformOffset = glnvg__allocFragUniforms(gl, 1);
@@ -1568,6 +2488,66 @@ static void glnvg__renderTriangles(void* uptr, NVGpaint* paint, NVGcompositeOper
 	frag = nvg__fragUniformPtr(gl, call->uniformOffset);
 	glnvg__convertPaint(gl, frag, paint, scissor, 1.0f, fringe, -1.0f, 0);
 	frag->type = NSVG_SHADER_IMG;
+	frag->sdfScale = sdfScale;
+	frag->sdfBias = sdfBias;
+	call->program = NSVG_SHADER_IMG;
+
+	return;
+
+error:
+	// We get here if call alloc was ok, but something else is not.
+	// Roll back the last call to prevent drawing it.
+	if (gl->ncalls > 0) gl->ncalls--;
+}
+
+static void glnvg__renderTriangles(void* uptr, NVGpaint* paint, NVGcompositeOperationState compositeOperation, NVGscissor* scissor,
+								   const NVGvertex* verts, int nverts, float fringe)
+{
+	glnvg__renderSDFTriangles(uptr, paint, compositeOperation, scissor, verts, nverts, fringe, 0.0f, 0.0f);
+}
+
+static void glnvg__renderShapes(void* uptr, NVGcompositeOperationState compositeOperation, NVGscissor* scissor, float fringe,
+								const NVGshapeVertex* verts, int nverts)
+{
+	GLNVGcontext* gl = (GLNVGcontext*)uptr;
+	GLNVGcall* call = glnvg__allocCall(gl);
+	GLNVGfragUniforms* frag;
+	NVGshapeVertex* dst;
+	NVGpaint paint;
+	int i;
+
+	if (call == NULL) return;
+
+	call->type = GLNVG_SHAPES;
+	call->blendFunc = glnvg__blendCompositeOperation(compositeOperation);
+
+	// Two triangles per quad.
+	call->triangleOffset = glnvg__allocShapeVerts(gl, nverts/4*6);
+	if (call->triangleOffset == -1) goto error;
+	call->triangleCount = nverts/4*6;
+
+	dst = &gl->shapeVerts[call->triangleOffset];
+	for (i = 0; i+4 <= nverts; i += 4) {
+		dst[0] = verts[i+0];
+		dst[1] = verts[i+1];
+		dst[2] = verts[i+2];
+		dst[3] = verts[i+0];
+		dst[4] = verts[i+2];
+		dst[5] = verts[i+3];
+		dst += 6;
+	}
+
+	// Fill shader, only the scissor is used from the paint.
+	call->uniformOffset = glnvg__allocFragUniforms(gl, 1);
+	if (call->uniformOffset == -1) goto error;
+	frag = nvg__fragUniformPtr(gl, call->uniformOffset);
+	memset(&paint, 0, sizeof(paint));
+	nvgTransformIdentity(paint.xform);
+	glnvg__convertPaint(gl, frag, &paint, scissor, 1.0f, fringe, -1.0f, 0);
+	// The texture coordinates hold the shape position, keep the stroke mask out of it.
+	frag->strokeMult = 0.0f;
+	frag->type = NSVG_SHADER_SHAPES;
+	call->program = NSVG_SHADER_SHAPES;
 
 	return;
 
@@ -1583,18 +2563,34 @@ static void glnvg__renderDelete(void* uptr)
 	int i;
 	if (gl == NULL) return;
 
-	glnvg__deleteShader(&gl->shader);
+	for (i = 0; i <= GLNVG_PROG_GENERIC; i++)
+		glnvg__deleteShader(&gl->shaders[i]);
+
+#if NANOVG_GL_USE_MAPPED_STREAM
+	for (i = 0; i < NANOVG_GL_STREAM_FRAMES; i++) {
+		if (gl->fences[i] != NULL)
+			glDeleteSync(gl->fences[i]);
+	}
+#endif
 
 #if NANOVG_GL3
 #if NANOVG_GL_USE_UNIFORMBUFFER
-	if (gl->fragBuf != 0)
-		glDeleteBuffers(1, &gl->fragBuf);
+	if (gl->fragBuf.buf != 0)
+		glDeleteBuffers(1, &gl->fragBuf.buf);
+	if (gl->paintBuf.buf != 0)
+		glDeleteBuffers(1, &gl->paintBuf.buf);
 #endif
 	if (gl->vertArr != 0)
 		glDeleteVertexArrays(1, &gl->vertArr);
 #endif
-	if (gl->vertBuf != 0)
-		glDeleteBuffers(1, &gl->vertBuf);
+	if (gl->vertBuf.buf != 0)
+		glDeleteBuffers(1, &gl->vertBuf.buf);
+	if (gl->styleBuf.buf != 0)
+		glDeleteBuffers(1, &gl->styleBuf.buf);
+	if (gl->indexBuf.buf != 0)
+		glDeleteBuffers(1, &gl->indexBuf.buf);
+	if (gl->shapeBuf.buf != 0)
+		glDeleteBuffers(1, &gl->shapeBuf.buf);
 
 	for (i = 0; i < gl->ntextures; i++) {
 		if (gl->textures[i].tex != 0 && (gl->textures[i].flags & NVG_IMAGE_NODELETE) == 0)
@@ -1602,24 +2598,23 @@ static void glnvg__renderDelete(void* uptr)
 	}
 	free(gl->textures);
 
-	free(gl->paths);
 	free(gl->verts);
+	free(gl->packedVerts);
+	free(gl->styles);
+	free(gl->indices);
+	free(gl->ears);
+	free(gl->shapeVerts);
 	free(gl->uniforms);
+#if NANOVG_GL_USE_UNIFORMBUFFER
+	free(gl->paints);
+#endif
 	free(gl->calls);
 
 	free(gl);
 }
 
 
-#if defined NANOVG_GL2
-NVGcontext* nvgCreateGL2(int flags)
-#elif defined NANOVG_GL3
-NVGcontext* nvgCreateGL3(int flags)
-#elif defined NANOVG_GLES2
-NVGcontext* nvgCreateGLES2(int flags)
-#elif defined NANOVG_GLES3
-NVGcontext* nvgCreateGLES3(int flags)
-#endif
+static NVGcontext* glnvg__createContext(int flags, const char* cacheDir)
 {
 	NVGparams params;
 	NVGcontext* ctx = NULL;
@@ -1632,6 +2627,11 @@ NVGcontext* nvgCreateGLES3(int flags)
 	params.renderCreateTexture = glnvg__renderCreateTexture;
 	params.renderDeleteTexture = glnvg__renderDeleteTexture;
 	params.renderUpdateTexture = glnvg__renderUpdateTexture;
+#if NANOVG_GL_USE_TEXTURE_PAGES
+	// Compact vertices clamp the texture coordinates to [0,1], which leaves no room for the page.
+	if ((flags & NVG_COMPACT_VERTICES) == 0)
+		params.renderResizeTexturePages = glnvg__renderResizeTexturePages;
+#endif
 	params.renderGetTextureSize = glnvg__renderGetTextureSize;
 	params.renderGetImageTextureId = glnvg__renderGetImageTextureId;
 	params.renderViewport = glnvg__renderViewport;
@@ -1640,14 +2640,19 @@ NVGcontext* nvgCreateGLES3(int flags)
 	params.renderFill = glnvg__renderFill;
 	params.renderStroke = glnvg__renderStroke;
 	params.renderTriangles = glnvg__renderTriangles;
+	if (flags & NVG_SDF_TEXT)
+		params.renderSDFTriangles = glnvg__renderSDFTriangles;
+	params.renderShapes = glnvg__renderShapes;
 	params.renderDelete = glnvg__renderDelete;
 	params.userPtr = gl;
 	params.edgeAntiAlias = flags & NVG_ANTIALIAS ? 1 : 0;
 
 	gl->flags = flags;
+	gl->programCache = cacheDir;
 
 	ctx = nvgCreateInternal(&params);
 	if (ctx == NULL) goto error;
+	gl->programCache = NULL;
 
 	return ctx;
 
@@ -1657,6 +2662,30 @@ error:
 	return NULL;
 }
 
+#if defined NANOVG_GL2
+NVGcontext* nvgCreateGL2(int flags)
+#elif defined NANOVG_GL3
+NVGcontext* nvgCreateGL3(int flags)
+#elif defined NANOVG_GLES2
+NVGcontext* nvgCreateGLES2(int flags)
+#elif defined NANOVG_GLES3
+NVGcontext* nvgCreateGLES3(int flags)
+#endif
+{
+	return glnvg__createContext(flags, NULL);
+}
+
+#if defined NANOVG_GL3
+NVGcontext* nvgCreateGL3Cached(int flags, const char* cacheDir)
+#elif defined NANOVG_GLES3
+NVGcontext* nvgCreateGLES3Cached(int flags, const char* cacheDir)
+#endif
+#if NANOVG_GL_USE_PROGRAM_BINARY
+{
+	return glnvg__createContext(flags, cacheDir);
+}
+#endif
+
 #if defined NANOVG_GL2
 void nvgDeleteGL2(NVGcontext* ctx)
 #elif defined NANOVG_GL3
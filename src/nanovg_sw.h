@@ -0,0 +1,1948 @@
+//
+// Copyright (c) 2013 Mikko Mononen memon@inside.org
+//
+// This software is provided 'as-is', without any express or implied
+// warranty.  In no event will the authors be held liable for any damages
+// arising from the use of this software.
+// Permission is granted to anyone to use this software for any purpose,
+// including commercial applications, and to alter it and redistribute it
+// freely, subject to the following restrictions:
+// 1. The origin of this software must not be misrepresented; you must not
+//    claim that you wrote the original software. If you use this software
+//    in a product, an acknowledgment in the product documentation would be
+//    appreciated but is not required.
+// 2. Altered source versions must be plainly marked as such, and must not be
+//    misrepresented as being the original software.
+// 3. This notice may not be removed or altered from any source distribution.
+//
+#ifndef NANOVG_SW_H
+#define NANOVG_SW_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Software renderer for NanoVG. Rasterizes on the CPU into a caller provided RGBA8 buffer,
+// which makes it usable without a GPU, e.g. for thumbnails, server side rendering and tests.
+//
+// The coverage is calculated analytically using an accumulation buffer, so the back-end
+// does not need the anti-aliasing fringes NanoVG generates for the GL back-ends.
+// Paints, scissoring, line styles and composite operations follow the GL back-end.
+//
+//		#define NANOVG_SW_IMPLEMENTATION
+//		#include "nanovg_sw.h"
+//		...
+//		NVGcontext* vg = nvgCreateSW(0);
+//		nvgswSetFramebuffer(vg, pixels, width, height, width*4);
+//		nvgBeginFrame(vg, width, height, 1.0f);
+//		...
+//		nvgEndFrame(vg);
+
+// Create flags
+
+enum NVGswCreateFlags {
+	// Flag indicating that fills use the even-odd fill rule instead of the non-zero fill rule.
+	NVG_SW_EVENODD		= 1<<0,
+	// Flag indicating that glyphs are cached once as signed distance fields and turned into coverage
+	// when shading, which keeps text sharp when scaled.
+	NVG_SW_SDF_TEXT		= 1<<1,
+};
+
+// Creates NanoVG context which renders with the CPU.
+// Flags should be combination of the create flags above.
+NVGcontext* nvgCreateSW(int flags);
+void nvgDeleteSW(NVGcontext* ctx);
+
+// Sets the buffer the frames are rendered into. The buffer holds w*h premultiplied RGBA8 pixels
+// starting from the top row, stride is the distance between rows in bytes.
+// The window size passed to nvgBeginFrame() is scaled to cover the whole buffer.
+void nvgswSetFramebuffer(NVGcontext* ctx, void* pixels, int w, int h, int stride);
+
+// Sets the number of threads used for rendering, including the calling thread. When more than one
+// thread is used, the calls are binned into tiles which are rasterized in parallel.
+// Zero or negative count uses one thread per CPU. Returns the number of threads in use.
+// Threads can be disabled by defining NANOVG_SW_NO_THREADS.
+int nvgswSetThreadCount(NVGcontext* ctx, int count);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* NANOVG_SW_H */
+
+#ifdef NANOVG_SW_IMPLEMENTATION
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include "nanovg.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define NANOVG_SW_SSE2 1
+#endif
+
+#ifndef NANOVG_SW_NO_THREADS
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <pthread.h>
+#include <unistd.h>
+#endif
+#endif
+
+// Size of the tiles in pixels when rendering with multiple threads.
+#ifndef NANOVG_SW_TILE_SIZE
+#define NANOVG_SW_TILE_SIZE 64
+#endif
+
+#ifndef NANOVG_SW_MAX_THREADS
+#define NANOVG_SW_MAX_THREADS 64
+#endif
+
+enum SWNVGcallType {
+	SWNVG_NONE = 0,
+	SWNVG_FILL,
+	SWNVG_STROKE,
+	SWNVG_TRIANGLES,
+	SWNVG_SHAPES,
+};
+
+enum SWNVGpaintType {
+	SWNVG_PAINT_COLOR,
+	SWNVG_PAINT_GRAD,
+	SWNVG_PAINT_IMG,
+};
+
+struct SWNVGtexture {
+	int id;
+	unsigned char* data;	// Pages one below the other.
+	int width, height;
+	int pages;
+	int type;
+	int flags;
+};
+typedef struct SWNVGtexture SWNVGtexture;
+
+struct SWNVGpaint {
+	float scissorMat[6];
+	float scissorExt[2];
+	float scissorScale[2];
+	float paintMat[6];
+	NVGcolor innerCol;
+	NVGcolor outerCol;
+	float extent[2];
+	float radius;
+	float feather;
+	int type;
+	int texType;
+	int image;
+	int scissor;
+	int lineStyle;
+	float sdf[2];	// Coverage scale and bias of a signed distance field texture, zero scale for others.
+};
+typedef struct SWNVGpaint SWNVGpaint;
+
+struct SWNVGcall {
+	int type;
+	int pathOffset;
+	int pathCount;
+	int triangleOffset;
+	int triangleCount;
+	float bounds[4];
+	SWNVGpaint paint;
+	NVGcompositeOperationState blend;
+};
+typedef struct SWNVGcall SWNVGcall;
+
+struct SWNVGpath {
+	int offset;
+	int count;
+};
+typedef struct SWNVGpath SWNVGpath;
+
+// Scratch buffers used while rasterizing a call into a region of the framebuffer.
+struct SWNVGraster {
+	int x0, y0, x1, y1;
+	int w, h, stride;
+	float* cells;
+	int ccells;
+	int* spans;
+	int cspans;
+	float* attrs;
+	int cattrs;
+	float* cover;
+	int ccover;
+};
+typedef struct SWNVGraster SWNVGraster;
+
+struct SWNVGcontext;
+
+struct SWNVGworker {
+	struct SWNVGcontext* sw;
+	SWNVGraster raster;
+	int index;
+	// Last frame started by the worker.
+	int generation;
+	// Remaining tiles of the worker, begin in low and end in high 32 bits. Other workers steal from the end.
+	unsigned long long tiles;
+#ifndef NANOVG_SW_NO_THREADS
+#ifdef _WIN32
+	HANDLE thread;
+#else
+	pthread_t thread;
+#endif
+#endif
+};
+typedef struct SWNVGworker SWNVGworker;
+
+struct SWNVGcontext {
+	SWNVGtexture* textures;
+	int ntextures;
+	int ctextures;
+	int textureId;
+	float view[2];
+	int flags;
+
+	unsigned char* pixels;
+	int width, height, stride;
+
+	// Per frame buffers
+	SWNVGcall* calls;
+	int ccalls;
+	int ncalls;
+	SWNVGpath* paths;
+	int cpaths;
+	int npaths;
+	NVGvertex* verts;
+	int cverts;
+	int nverts;
+	NVGshapeVertex* shapeVerts;
+	int cshapeVerts;
+	int nshapeVerts;
+
+	// Worker 0 is the thread calling nvgEndFrame().
+	SWNVGworker* workers;
+	int nworkers;
+
+	// Calls binned to tiles
+	int tilesX, tilesY;
+	int* tileOffsets;
+	int ctileOffsets;
+	int* tileCalls;
+	int ctileCalls;
+
+#ifndef NANOVG_SW_NO_THREADS
+#ifdef _WIN32
+	CRITICAL_SECTION lock;
+	CONDITION_VARIABLE start;
+	CONDITION_VARIABLE done;
+#else
+	pthread_mutex_t lock;
+	pthread_cond_t start;
+	pthread_cond_t done;
+#endif
+	int generation;
+	int pending;
+	int quit;
+#endif
+};
+typedef struct SWNVGcontext SWNVGcontext;
+
+static int swnvg__maxi(int a, int b) { return a > b ? a : b; }
+static int swnvg__mini(int a, int b) { return a < b ? a : b; }
+static float swnvg__minf(float a, float b) { return a < b ? a : b; }
+static float swnvg__maxf(float a, float b) { return a > b ? a : b; }
+static float swnvg__absf(float a) { return a >= 0.0f ? a : -a; }
+static float swnvg__clampf(float a, float mn, float mx) { return a < mn ? mn : (a > mx ? mx : a); }
+
+static SWNVGtexture* swnvg__allocTexture(SWNVGcontext* sw)
+{
+	SWNVGtexture* tex = NULL;
+	int i;
+
+	for (i = 0; i < sw->ntextures; i++) {
+		if (sw->textures[i].id == 0) {
+			tex = &sw->textures[i];
+			break;
+		}
+	}
+	if (tex == NULL) {
+		if (sw->ntextures+1 > sw->ctextures) {
+			SWNVGtexture* textures;
+			int ctextures = swnvg__maxi(sw->ntextures+1, 4) +  sw->ctextures/2; // 1.5x Overallocate
+			textures = (SWNVGtexture*)realloc(sw->textures, sizeof(SWNVGtexture)*ctextures);
+			if (textures == NULL) return NULL;
+			sw->textures = textures;
+			sw->ctextures = ctextures;
+		}
+		tex = &sw->textures[sw->ntextures++];
+	}
+
+	memset(tex, 0, sizeof(*tex));
+	tex->id = ++sw->textureId;
+
+	return tex;
+}
+
+static SWNVGtexture* swnvg__findTexture(SWNVGcontext* sw, int id)
+{
+	int i;
+	for (i = 0; i < sw->ntextures; i++)
+		if (sw->textures[i].id == id)
+			return &sw->textures[i];
+	return NULL;
+}
+
+static int swnvg__renderCreate(void* uptr)
+{
+	SWNVGcontext* sw = (SWNVGcontext*)uptr;
+
+	sw->workers = (SWNVGworker*)malloc(sizeof(SWNVGworker));
+	if (sw->workers == NULL) return 0;
+	memset(sw->workers, 0, sizeof(SWNVGworker));
+	sw->workers[0].sw = sw;
+	sw->nworkers = 1;
+
+#ifndef NANOVG_SW_NO_THREADS
+#ifdef _WIN32
+	InitializeCriticalSection(&sw->lock);
+	InitializeConditionVariable(&sw->start);
+	InitializeConditionVariable(&sw->done);
+#else
+	pthread_mutex_init(&sw->lock, NULL);
+	pthread_cond_init(&sw->start, NULL);
+	pthread_cond_init(&sw->done, NULL);
+#endif
+#endif
+
+	return 1;
+}
+
+static int swnvg__renderCreateTexture(void* uptr, int type, int w, int h, int imageFlags, const unsigned char* data)
+{
+	SWNVGcontext* sw = (SWNVGcontext*)uptr;
+	SWNVGtexture* tex = swnvg__allocTexture(sw);
+	int bpp = type == NVG_TEXTURE_RGBA ? 4 : 1;
+
+	if (tex == NULL) return 0;
+
+	tex->data = (unsigned char*)malloc(w*h*bpp);
+	if (tex->data == NULL) {
+		tex->id = 0;
+		return 0;
+	}
+	if (data != NULL)
+		memcpy(tex->data, data, w*h*bpp);
+	else
+		memset(tex->data, 0, w*h*bpp);
+	tex->width = w;
+	tex->height = h;
+	tex->pages = 1;
+	tex->type = type;
+	tex->flags = imageFlags;
+
+	return tex->id;
+}
+
+static int swnvg__renderDeleteTexture(void* uptr, int image)
+{
+	SWNVGcontext* sw = (SWNVGcontext*)uptr;
+	SWNVGtexture* tex = swnvg__findTexture(sw, image);
+	if (tex == NULL) return 0;
+	free(tex->data);
+	memset(tex, 0, sizeof(*tex));
+	return 1;
+}
+
+static int swnvg__renderUpdateTexture(void* uptr, int image, int x, int y, int w, int h, const unsigned char* data)
+{
+	SWNVGcontext* sw = (SWNVGcontext*)uptr;
+	SWNVGtexture* tex = swnvg__findTexture(sw, image);
+	int bpp, i;
+
+	if (tex == NULL) return 0;
+	bpp = tex->type == NVG_TEXTURE_RGBA ? 4 : 1;
+
+	// The data contains the whole image, copy the updated rectangle.
+	for (i = y; i < y+h; i++)
+		memcpy(&tex->data[(i*tex->width + x)*bpp], &data[(i*tex->width + x)*bpp], w*bpp);
+
+	return 1;
+}
+
+static int swnvg__renderResizeTexturePages(void* uptr, int image, int pages)
+{
+	SWNVGcontext* sw = (SWNVGcontext*)uptr;
+	SWNVGtexture* tex = swnvg__findTexture(sw, image);
+	int pageSize;
+	unsigned char* data;
+
+	if (tex == NULL || tex->type != NVG_TEXTURE_ALPHA) return 0;
+	pageSize = tex->width * tex->height;
+	data = (unsigned char*)realloc(tex->data, pageSize * pages);
+	if (data == NULL) return 0;
+	if (pages > tex->pages)
+		memset(&data[pageSize * tex->pages], 0, pageSize * (pages - tex->pages));
+	tex->data = data;
+	tex->pages = pages;
+
+	return 1;
+}
+
+static int swnvg__renderGetTextureSize(void* uptr, int image, int* w, int* h)
+{
+	SWNVGcontext* sw = (SWNVGcontext*)uptr;
+	SWNVGtexture* tex = swnvg__findTexture(sw, image);
+	if (tex == NULL) return 0;
+	*w = tex->width;
+	*h = tex->height;
+	return 1;
+}
+
+static int swnvg__renderGetImageTextureId(void* uptr, int handle)
+{
+	SWNVGcontext* sw = (SWNVGcontext*)uptr;
+	return swnvg__findTexture(sw, handle) != NULL ? handle : -1;
+}
+
+static void swnvg__renderViewport(void* uptr, float width, float height, float devicePixelRatio)
+{
+	SWNVGcontext* sw = (SWNVGcontext*)uptr;
+	NVG_NOTUSED(devicePixelRatio);
+	sw->view[0] = width;
+	sw->view[1] = height;
+}
+
+static NVGcolor swnvg__premulColor(NVGcolor c)
+{
+	c.r *= c.a;
+	c.g *= c.a;
+	c.b *= c.a;
+	return c;
+}
+
+static int swnvg__convertPaint(SWNVGcontext* sw, SWNVGpaint* frag, NVGpaint* paint, NVGscissor* scissor, float fringe, int lineStyle)
+{
+	SWNVGtexture* tex = NULL;
+
+	memset(frag, 0, sizeof(*frag));
+
+	frag->innerCol = swnvg__premulColor(paint->innerColor);
+	frag->outerCol = swnvg__premulColor(paint->outerColor);
+	frag->lineStyle = lineStyle;
+	if (scissor->extent[0] < -0.5f || scissor->extent[1] < -0.5f) {
+		frag->scissor = 0;
+	} else {
+		frag->scissor = 1;
+		nvgTransformInverse(frag->scissorMat, scissor->xform);
+		frag->scissorExt[0] = scissor->extent[0];
+		frag->scissorExt[1] = scissor->extent[1];
+		frag->scissorScale[0] = sqrtf(scissor->xform[0]*scissor->xform[0] + scissor->xform[2]*scissor->xform[2]) / fringe;
+		frag->scissorScale[1] = sqrtf(scissor->xform[1]*scissor->xform[1] + scissor->xform[3]*scissor->xform[3]) / fringe;
+	}
+
+	memcpy(frag->extent, paint->extent, sizeof(frag->extent));
+
+	if (paint->image != 0) {
+		tex = swnvg__findTexture(sw, paint->image);
+		if (tex == NULL) return 0;
+		if ((tex->flags & NVG_IMAGE_FLIPY) != 0) {
+			float m1[6], m2[6];
+			nvgTransformTranslate(m1, 0.0f, frag->extent[1] * 0.5f);
+			nvgTransformMultiply(m1, paint->xform);
+			nvgTransformScale(m2, 1.0f, -1.0f);
+			nvgTransformMultiply(m2, m1);
+			nvgTransformTranslate(m1, 0.0f, -frag->extent[1] * 0.5f);
+			nvgTransformMultiply(m1, m2);
+			nvgTransformInverse(frag->paintMat, m1);
+		} else {
+			nvgTransformInverse(frag->paintMat, paint->xform);
+		}
+		frag->type = SWNVG_PAINT_IMG;
+		frag->image = paint->image;
+		if (tex->type == NVG_TEXTURE_RGBA)
+			frag->texType = (tex->flags & NVG_IMAGE_PREMULTIPLIED) ? 0 : 1;
+		else
+			frag->texType = 2;
+	} else {
+		frag->type = SWNVG_PAINT_GRAD;
+		frag->radius = paint->radius;
+		frag->feather = paint->feather;
+		nvgTransformInverse(frag->paintMat, paint->xform);
+		// Gradients with same inner and outer color are just solid color.
+		if (memcmp(&frag->innerCol, &frag->outerCol, sizeof(NVGcolor)) == 0)
+			frag->type = SWNVG_PAINT_COLOR;
+	}
+
+	return 1;
+}
+
+static SWNVGcall* swnvg__allocCall(SWNVGcontext* sw)
+{
+	SWNVGcall* ret = NULL;
+	if (sw->ncalls+1 > sw->ccalls) {
+		SWNVGcall* calls;
+		int ccalls = swnvg__maxi(sw->ncalls+1, 128) + sw->ccalls/2; // 1.5x Overallocate
+		calls = (SWNVGcall*)realloc(sw->calls, sizeof(SWNVGcall) * ccalls);
+		if (calls == NULL) return NULL;
+		sw->calls = calls;
+		sw->ccalls = ccalls;
+	}
+	ret = &sw->calls[sw->ncalls++];
+	memset(ret, 0, sizeof(SWNVGcall));
+	return ret;
+}
+
+static int swnvg__allocPaths(SWNVGcontext* sw, int n)
+{
+	int ret = 0;
+	if (sw->npaths+n > sw->cpaths) {
+		SWNVGpath* paths;
+		int cpaths = swnvg__maxi(sw->npaths + n, 128) + sw->cpaths/2; // 1.5x Overallocate
+		paths = (SWNVGpath*)realloc(sw->paths, sizeof(SWNVGpath) * cpaths);
+		if (paths == NULL) return -1;
+		sw->paths = paths;
+		sw->cpaths = cpaths;
+	}
+	ret = sw->npaths;
+	sw->npaths += n;
+	return ret;
+}
+
+static int swnvg__allocVerts(SWNVGcontext* sw, int n)
+{
+	int ret = 0;
+	if (sw->nverts+n > sw->cverts) {
+		NVGvertex* verts;
+		int cverts = swnvg__maxi(sw->nverts + n, 4096) + sw->cverts/2; // 1.5x Overallocate
+		verts = (NVGvertex*)realloc(sw->verts, sizeof(NVGvertex) * cverts);
+		if (verts == NULL) return -1;
+		sw->verts = verts;
+		sw->cverts = cverts;
+	}
+	ret = sw->nverts;
+	sw->nverts += n;
+	return ret;
+}
+
+static int swnvg__allocShapeVerts(SWNVGcontext* sw, int n)
+{
+	int ret = 0;
+	if (sw->nshapeVerts+n > sw->cshapeVerts) {
+		NVGshapeVertex* verts;
+		int cverts = swnvg__maxi(sw->nshapeVerts + n, 4096) + sw->cshapeVerts/2; // 1.5x Overallocate
+		verts = (NVGshapeVertex*)realloc(sw->shapeVerts, sizeof(NVGshapeVertex) * cverts);
+		if (verts == NULL) return -1;
+		sw->shapeVerts = verts;
+		sw->cshapeVerts = cverts;
+	}
+	ret = sw->nshapeVerts;
+	sw->nshapeVerts += n;
+	return ret;
+}
+
+static void swnvg__initBounds(float* bounds)
+{
+	bounds[0] = bounds[1] = 1e6f;
+	bounds[2] = bounds[3] = -1e6f;
+}
+
+static void swnvg__addBounds(float* bounds, const NVGvertex* verts, int nverts)
+{
+	int i;
+	for (i = 0; i < nverts; i++) {
+		bounds[0] = swnvg__minf(bounds[0], verts[i].x);
+		bounds[1] = swnvg__minf(bounds[1], verts[i].y);
+		bounds[2] = swnvg__maxf(bounds[2], verts[i].x);
+		bounds[3] = swnvg__maxf(bounds[3], verts[i].y);
+	}
+}
+
+static void swnvg__clipBoundsToScissor(float* bounds, NVGscissor* scissor)
+{
+	float ex, ey;
+	if (scissor->extent[0] < -0.5f || scissor->extent[1] < -0.5f)
+		return;
+	// Extents of the transformed scissor rectangle, with some room for the anti-aliased edge.
+	ex = scissor->extent[0]*swnvg__absf(scissor->xform[0]) + scissor->extent[1]*swnvg__absf(scissor->xform[2]) + 1.0f;
+	ey = scissor->extent[0]*swnvg__absf(scissor->xform[1]) + scissor->extent[1]*swnvg__absf(scissor->xform[3]) + 1.0f;
+	bounds[0] = swnvg__maxf(bounds[0], scissor->xform[4] - ex);
+	bounds[1] = swnvg__maxf(bounds[1], scissor->xform[5] - ey);
+	bounds[2] = swnvg__minf(bounds[2], scissor->xform[4] + ex);
+	bounds[3] = swnvg__minf(bounds[3], scissor->xform[5] + ey);
+}
+
+static void swnvg__renderFill(void* uptr, NVGpaint* paint, NVGcompositeOperationState compositeOperation, NVGscissor* scissor, float fringe,
+							  const float* bounds, const NVGpath* paths, int npaths)
+{
+	SWNVGcontext* sw = (SWNVGcontext*)uptr;
+	SWNVGcall* call = swnvg__allocCall(sw);
+	int i, maxverts, offset;
+
+	if (call == NULL) return;
+
+	call->type = SWNVG_FILL;
+	call->pathOffset = swnvg__allocPaths(sw, npaths);
+	if (call->pathOffset == -1) goto error;
+	call->pathCount = npaths;
+	call->blend = compositeOperation;
+	memcpy(call->bounds, bounds, sizeof(call->bounds));
+	swnvg__clipBoundsToScissor(call->bounds, scissor);
+
+	// Only the fill polygons are needed, the coverage is calculated from the outline.
+	maxverts = 0;
+	for (i = 0; i < npaths; i++)
+		maxverts += paths[i].nfill;
+	offset = swnvg__allocVerts(sw, maxverts);
+	if (offset == -1) goto error;
+
+	for (i = 0; i < npaths; i++) {
+		SWNVGpath* copy = &sw->paths[call->pathOffset + i];
+		const NVGpath* path = &paths[i];
+		copy->offset = offset;
+		copy->count = path->nfill;
+		memcpy(&sw->verts[offset], path->fill, sizeof(NVGvertex) * path->nfill);
+		offset += path->nfill;
+	}
+
+	if (swnvg__convertPaint(sw, &call->paint, paint, scissor, fringe, 0) == 0) goto error;
+
+	return;
+
+error:
+	// We get here if call alloc was ok, but something else is not.
+	// Roll back the last call to prevent drawing it.
+	if (sw->ncalls > 0) sw->ncalls--;
+}
+
+static void swnvg__renderStroke(void* uptr, NVGpaint* paint, NVGcompositeOperationState compositeOperation, NVGscissor* scissor, float fringe,
+								float strokeWidth, int lineStyle, const NVGpath* paths, int npaths)
+{
+	SWNVGcontext* sw = (SWNVGcontext*)uptr;
+	SWNVGcall* call = swnvg__allocCall(sw);
+	int i, j, maxverts, offset;
+	float scale;
+
+	if (call == NULL) return;
+
+	call->type = SWNVG_STROKE;
+	call->pathOffset = swnvg__allocPaths(sw, npaths);
+	if (call->pathOffset == -1) goto error;
+	call->pathCount = npaths;
+	call->blend = compositeOperation;
+
+	maxverts = 0;
+	for (i = 0; i < npaths; i++)
+		maxverts += paths[i].nstroke;
+	offset = swnvg__allocVerts(sw, maxverts);
+	if (offset == -1) goto error;
+
+	// The stroke coordinates are normalized by the stroke half width, which includes half of
+	// the fringe when anti-aliasing. Scale them so that line styles match the GL back-end.
+	scale = strokeWidth*0.5f / (strokeWidth*0.5f + fringe*0.5f);
+
+	swnvg__initBounds(call->bounds);
+	for (i = 0; i < npaths; i++) {
+		SWNVGpath* copy = &sw->paths[call->pathOffset + i];
+		const NVGpath* path = &paths[i];
+		copy->offset = offset;
+		copy->count = path->nstroke;
+		memcpy(&sw->verts[offset], path->stroke, sizeof(NVGvertex) * path->nstroke);
+		if (lineStyle > 1) {
+			for (j = 0; j < path->nstroke; j++) {
+				sw->verts[offset+j].s *= scale;
+				sw->verts[offset+j].t *= scale;
+			}
+		}
+		swnvg__addBounds(call->bounds, path->stroke, path->nstroke);
+		offset += path->nstroke;
+	}
+	swnvg__clipBoundsToScissor(call->bounds, scissor);
+
+	if (swnvg__convertPaint(sw, &call->paint, paint, scissor, fringe, lineStyle) == 0) goto error;
+
+	return;
+
+error:
+	// We get here if call alloc was ok, but something else is not.
+	// Roll back the last call to prevent drawing it.
+	if (sw->ncalls > 0) sw->ncalls--;
+}
+
+static void swnvg__renderSDFTriangles(void* uptr, NVGpaint* paint, NVGcompositeOperationState compositeOperation, NVGscissor* scissor,
+									  const NVGvertex* verts, int nverts, float fringe, float sdfScale, float sdfBias)
+{
+	SWNVGcontext* sw = (SWNVGcontext*)uptr;
+	SWNVGcall* call = swnvg__allocCall(sw);
+
+	if (call == NULL) return;
+
+	call->type = SWNVG_TRIANGLES;
+	call->blend = compositeOperation;
+
+	call->triangleOffset = swnvg__allocVerts(sw, nverts);
+	if (call->triangleOffset == -1) goto error;
+	call->triangleCount = nverts;
+
+	memcpy(&sw->verts[call->triangleOffset], verts, sizeof(NVGvertex) * nverts);
+	swnvg__initBounds(call->bounds);
+	swnvg__addBounds(call->bounds, verts, nverts);
+	swnvg__clipBoundsToScissor(call->bounds, scissor);
+
+	if (swnvg__convertPaint(sw, &call->paint, paint, scissor, fringe, 0) == 0) goto error;
+	call->paint.sdf[0] = sdfScale;
+	call->paint.sdf[1] = sdfBias;
+
+	return;
+
+error:
+	// We get here if call alloc was ok, but something else is not.
+	// Roll back the last call to prevent drawing it.
+	if (sw->ncalls > 0) sw->ncalls--;
+}
+
+static void swnvg__renderTriangles(void* uptr, NVGpaint* paint, NVGcompositeOperationState compositeOperation, NVGscissor* scissor,
+								   const NVGvertex* verts, int nverts, float fringe)
+{
+	swnvg__renderSDFTriangles(uptr, paint, compositeOperation, scissor, verts, nverts, fringe, 0.0f, 0.0f);
+}
+
+static void swnvg__renderShapes(void* uptr, NVGcompositeOperationState compositeOperation, NVGscissor* scissor, float fringe,
+								const NVGshapeVertex* verts, int nverts)
+{
+	SWNVGcontext* sw = (SWNVGcontext*)uptr;
+	SWNVGcall* call = swnvg__allocCall(sw);
+	NVGpaint paint;
+	int i;
+
+	if (call == NULL) return;
+
+	call->type = SWNVG_SHAPES;
+	call->blend = compositeOperation;
+
+	call->triangleOffset = swnvg__allocShapeVerts(sw, nverts);
+	if (call->triangleOffset == -1) goto error;
+	call->triangleCount = nverts;
+
+	memcpy(&sw->shapeVerts[call->triangleOffset], verts, sizeof(NVGshapeVertex) * nverts);
+	swnvg__initBounds(call->bounds);
+	for (i = 0; i < nverts; i++) {
+		call->bounds[0] = swnvg__minf(call->bounds[0], verts[i].x);
+		call->bounds[1] = swnvg__minf(call->bounds[1], verts[i].y);
+		call->bounds[2] = swnvg__maxf(call->bounds[2], verts[i].x);
+		call->bounds[3] = swnvg__maxf(call->bounds[3], verts[i].y);
+	}
+	// The quads are not grown for the anti-aliased edge, coverage is calculated per pixel.
+	call->bounds[0] -= fringe;
+	call->bounds[1] -= fringe;
+	call->bounds[2] += fringe;
+	call->bounds[3] += fringe;
+	swnvg__clipBoundsToScissor(call->bounds, scissor);
+
+	// Only the scissor is used from the paint, the color comes from the vertices.
+	memset(&paint, 0, sizeof(paint));
+	nvgTransformIdentity(paint.xform);
+	if (swnvg__convertPaint(sw, &call->paint, &paint, scissor, fringe, 0) == 0) goto error;
+
+	return;
+
+error:
+	// We get here if call alloc was ok, but something else is not.
+	// Roll back the last call to prevent drawing it.
+	if (sw->ncalls > 0) sw->ncalls--;
+}
+
+//
+// Rasterizer
+//
+// The coverage is accumulated into cells, each line segment adds its signed area to the cells
+// it crosses, so that the prefix sum along a row gives the winding weighted coverage of each pixel.
+// Segments left of the raster region are accumulated at its left edge, segments right of it
+// cannot affect it. The cells are cleared while they are read back.
+
+static int swnvg__reserveCover(SWNVGraster* r, int n)
+{
+	if (n > r->ccover) {
+		float* cover;
+		int ccover = swnvg__maxi(n, 256) + r->ccover/2; // 1.5x Overallocate
+		cover = (float*)realloc(r->cover, sizeof(float) * ccover);
+		if (cover == NULL) return 0;
+		r->cover = cover;
+		r->ccover = ccover;
+	}
+	return 1;
+}
+
+static int swnvg__rasterBegin(SWNVGraster* r, int x0, int y0, int x1, int y1, int attrs)
+{
+	int i, ncells, nspans, npixels;
+
+	r->x0 = x0;
+	r->y0 = y0;
+	r->x1 = x1;
+	r->y1 = y1;
+	r->w = x1 - x0;
+	r->h = y1 - y0;
+	r->stride = r->w + 2;
+
+	ncells = r->stride * r->h;
+	if (ncells > r->ccells) {
+		float* cells;
+		int ccells = swnvg__maxi(ncells, 4096) + r->ccells/2; // 1.5x Overallocate
+		cells = (float*)realloc(r->cells, sizeof(float) * ccells);
+		if (cells == NULL) return 0;
+		// New cells need to be cleared, the rest are kept clear by the rasterizer.
+		memset(cells, 0, sizeof(float) * ccells);
+		r->cells = cells;
+		r->ccells = ccells;
+	}
+
+	nspans = r->h * 2;
+	if (nspans > r->cspans) {
+		int* spans;
+		int cspans = swnvg__maxi(nspans, 256) + r->cspans/2; // 1.5x Overallocate
+		spans = (int*)realloc(r->spans, sizeof(int) * cspans);
+		if (spans == NULL) return 0;
+		r->spans = spans;
+		r->cspans = cspans;
+	}
+	for (i = 0; i < r->h; i++) {
+		r->spans[i*2+0] = r->stride;
+		r->spans[i*2+1] = -1;
+	}
+
+	if (swnvg__reserveCover(r, r->w + 4) == 0) return 0;
+
+	if (attrs) {
+		// Per pixel attributes: u, v, and distance to the triangle the attributes came from.
+		npixels = r->w * r->h;
+		if (npixels*3 > r->cattrs) {
+			float* attrs;
+			int cattrs = swnvg__maxi(npixels*3, 4096) + r->cattrs/2; // 1.5x Overallocate
+			attrs = (float*)realloc(r->attrs, sizeof(float) * cattrs);
+			if (attrs == NULL) return 0;
+			r->attrs = attrs;
+			r->cattrs = cattrs;
+		}
+		for (i = 0; i < npixels; i++)
+			r->attrs[i*3+2] = -1e6f;
+	}
+
+	return 1;
+}
+
+static void swnvg__touchCells(SWNVGraster* r, int y, int x0, int x1)
+{
+	int* span = &r->spans[y*2];
+	if (x0 < span[0]) span[0] = x0;
+	if (x1 > span[1]) span[1] = x1;
+}
+
+// Accumulates line segment, x must be in range [0..w].
+static void swnvg__accumLine(SWNVGraster* r, float x0, float y0, float x1, float y1)
+{
+	float dir, dxdy, x, w = (float)r->w;
+	int y, ystart, yend;
+
+	if (y0 == y1) return;
+	if (y0 < y1) {
+		dir = 1.0f;
+	} else {
+		float t;
+		dir = -1.0f;
+		t = x0; x0 = x1; x1 = t;
+		t = y0; y0 = y1; y1 = t;
+	}
+	dxdy = (x1 - x0) / (y1 - y0);
+	x = x0;
+	if (y0 < 0.0f) {
+		x -= y0 * dxdy;
+		y0 = 0.0f;
+	}
+	if (y1 > (float)r->h)
+		y1 = (float)r->h;
+	if (y0 >= y1) return;
+
+	ystart = (int)y0;
+	yend = swnvg__mini(r->h, (int)ceilf(y1));
+	for (y = ystart; y < yend; y++) {
+		float* row = &r->cells[y * r->stride];
+		float dy = swnvg__minf((float)(y+1), y1) - swnvg__maxf((float)y, y0);
+		float xnext = swnvg__clampf(x + dxdy * dy, 0.0f, w);
+		float d = dy * dir;
+		float xa = swnvg__minf(x, xnext);
+		float xb = swnvg__maxf(x, xnext);
+		float xafloor = floorf(xa);
+		float xbceil = ceilf(xb);
+		int xai = (int)xafloor;
+		int xbi = (int)xbceil;
+		if (xbi <= xai + 1) {
+			// Segment within one pixel.
+			float xmf = 0.5f * (x + xnext) - xafloor;
+			row[xai] += d - d * xmf;
+			row[xai+1] += d * xmf;
+			swnvg__touchCells(r, y, xai, xai+1);
+		} else {
+			float s = 1.0f / (xb - xa);
+			float xaf = xa - xafloor;
+			float a0 = 0.5f * s * (1.0f - xaf) * (1.0f - xaf);
+			float xbf = xb - xbceil + 1.0f;
+			float am = 0.5f * s * xbf * xbf;
+			row[xai] += d * a0;
+			if (xbi == xai + 2) {
+				row[xai+1] += d * (1.0f - a0 - am);
+			} else {
+				float a1 = s * (1.5f - xaf);
+				float a2;
+				int xi;
+				row[xai+1] += d * (a1 - a0);
+				for (xi = xai + 2; xi < xbi - 1; xi++)
+					row[xi] += d * s;
+				a2 = a1 + (float)(xbi - xai - 3) * s;
+				row[xbi-1] += d * (1.0f - a2 - am);
+			}
+			row[xbi] += d * am;
+			swnvg__touchCells(r, y, xai, xbi);
+		}
+		x = xnext;
+	}
+}
+
+// Adds line segment in pixel coordinates.
+static void swnvg__rasterLine(SWNVGraster* r, float x0, float y0, float x1, float y1)
+{
+	float w = (float)r->w, h = (float)r->h;
+
+	x0 -= (float)r->x0;
+	y0 -= (float)r->y0;
+	x1 -= (float)r->x0;
+	y1 -= (float)r->y0;
+
+	if (y0 == y1) return;
+	if ((y0 <= 0.0f && y1 <= 0.0f) || (y0 >= h && y1 >= h)) return;
+	if (x0 >= w && x1 >= w) return;
+	if (x0 <= 0.0f && x1 <= 0.0f) {
+		swnvg__accumLine(r, 0.0f, y0, 0.0f, y1);
+		return;
+	}
+
+	// Split at left edge, the part left of the region is accumulated at the edge.
+	if (x0 < 0.0f || x1 < 0.0f) {
+		float ym = y0 + (0.0f - x0) / (x1 - x0) * (y1 - y0);
+		if (x0 < 0.0f) {
+			swnvg__accumLine(r, 0.0f, y0, 0.0f, ym);
+			x0 = 0.0f;
+			y0 = ym;
+		} else {
+			swnvg__accumLine(r, 0.0f, ym, 0.0f, y1);
+			x1 = 0.0f;
+			y1 = ym;
+		}
+	}
+	// Split at right edge, the part right of the region does not contribute.
+	if (x0 > w || x1 > w) {
+		float ym = y0 + (w - x0) / (x1 - x0) * (y1 - y0);
+		if (x0 > w) {
+			x0 = w;
+			y0 = ym;
+		} else {
+			x1 = w;
+			y1 = ym;
+		}
+	}
+
+	swnvg__accumLine(r, x0, y0, x1, y1);
+}
+
+static void swnvg__rasterTriangle(SWNVGraster* r, float ax, float ay, float bx, float by, float cx, float cy)
+{
+	float area = (bx - ax)*(cy - ay) - (by - ay)*(cx - ax);
+	if (area == 0.0f) return;
+	// Use same orientation for all triangles so that overlapping triangles add up instead of cancelling.
+	if (area < 0.0f) {
+		float t;
+		t = bx; bx = cx; cx = t;
+		t = by; by = cy; cy = t;
+	}
+	swnvg__rasterLine(r, ax, ay, bx, by);
+	swnvg__rasterLine(r, bx, by, cx, cy);
+	swnvg__rasterLine(r, cx, cy, ax, ay);
+}
+
+// Stores interpolated attributes for the pixels inside, or less than a pixel outside the triangle.
+// If several triangles overlap a pixel, the one the pixel is deepest inside wins.
+static void swnvg__rasterAttrs(SWNVGraster* r, const NVGvertex* a, const NVGvertex* b, const NVGvertex* c,
+							   float sx, float sy, int st)
+{
+	float ax = a->x*sx, ay = a->y*sy;
+	float bx = b->x*sx, by = b->y*sy;
+	float cx = c->x*sx, cy = c->y*sy;
+	float au = st ? a->s : a->u, av = st ? a->t : a->v;
+	float bu = st ? b->s : b->u, bv = st ? b->t : b->v;
+	float cu = st ? c->s : c->u, cv = st ? c->t : c->v;
+	float area = (bx - ax)*(cy - ay) - (by - ay)*(cx - ax);
+	float ia, da, db, dc, la, lb, lc;
+	int x, y, x0, y0, x1, y1;
+
+	if (swnvg__absf(area) < 1e-6f) return;
+	ia = 1.0f / area;
+	// Scale from barycentric coordinate to distance from the opposite edge.
+	da = swnvg__absf(area) / swnvg__maxf(1e-6f, sqrtf((cx-bx)*(cx-bx) + (cy-by)*(cy-by)));
+	db = swnvg__absf(area) / swnvg__maxf(1e-6f, sqrtf((ax-cx)*(ax-cx) + (ay-cy)*(ay-cy)));
+	dc = swnvg__absf(area) / swnvg__maxf(1e-6f, sqrtf((bx-ax)*(bx-ax) + (by-ay)*(by-ay)));
+
+	x0 = swnvg__maxi(r->x0, (int)floorf(swnvg__minf(ax, swnvg__minf(bx, cx))) - 1);
+	y0 = swnvg__maxi(r->y0, (int)floorf(swnvg__minf(ay, swnvg__minf(by, cy))) - 1);
+	x1 = swnvg__mini(r->x1, (int)ceilf(swnvg__maxf(ax, swnvg__maxf(bx, cx))) + 1);
+	y1 = swnvg__mini(r->y1, (int)ceilf(swnvg__maxf(ay, swnvg__maxf(by, cy))) + 1);
+
+	for (y = y0; y < y1; y++) {
+		float py = (float)y + 0.5f;
+		float* attr = &r->attrs[((y - r->y0) * r->w + (x0 - r->x0)) * 3];
+		for (x = x0; x < x1; x++, attr += 3) {
+			float px = (float)x + 0.5f;
+			float d;
+			la = ((bx - px)*(cy - py) - (by - py)*(cx - px)) * ia;
+			lb = ((cx - px)*(ay - py) - (cy - py)*(ax - px)) * ia;
+			lc = 1.0f - la - lb;
+			d = swnvg__minf(la*da, swnvg__minf(lb*db, lc*dc));
+			if (d < -1.0f || d <= attr[2]) continue;
+			attr[0] = la*au + lb*bu + lc*cu;
+			attr[1] = la*av + lb*bv + lc*cv;
+			attr[2] = d;
+		}
+	}
+}
+
+// Prefix sums one row of cells into coverage, and clears the cells.
+static float swnvg__accumRow(float* cells, float* cover, int n, float acc, int evenOdd)
+{
+	int i = 0;
+#if NANOVG_SW_SSE2
+	if (!evenOdd) {
+		__m128 sum = _mm_set1_ps(acc);
+		const __m128 one = _mm_set1_ps(1.0f);
+		const __m128 mask = _mm_castsi128_ps(_mm_set1_epi32(0x7fffffff));
+		const __m128 zero = _mm_setzero_ps();
+		for (; i+4 <= n; i += 4) {
+			__m128 x = _mm_loadu_ps(&cells[i]);
+			x = _mm_add_ps(x, _mm_castsi128_ps(_mm_slli_si128(_mm_castps_si128(x), 4)));
+			x = _mm_add_ps(x, _mm_castsi128_ps(_mm_slli_si128(_mm_castps_si128(x), 8)));
+			x = _mm_add_ps(x, sum);
+			_mm_storeu_ps(&cover[i], _mm_min_ps(_mm_and_ps(x, mask), one));
+			_mm_storeu_ps(&cells[i], zero);
+			sum = _mm_shuffle_ps(x, x, _MM_SHUFFLE(3,3,3,3));
+		}
+		acc = _mm_cvtss_f32(sum);
+	}
+#endif
+	for (; i < n; i++) {
+		float a;
+		acc += cells[i];
+		cells[i] = 0.0f;
+		a = swnvg__absf(acc);
+		if (evenOdd) {
+			a = fmodf(a, 2.0f);
+			if (a > 1.0f) a = 2.0f - a;
+		}
+		cover[i] = swnvg__minf(a, 1.0f);
+	}
+	return acc;
+}
+
+//
+// Shading
+//
+
+static float swnvg__sdroundrect(float px, float py, float ex, float ey, float rad)
+{
+	float dx = swnvg__absf(px) - (ex - rad);
+	float dy = swnvg__absf(py) - (ey - rad);
+	float mx = swnvg__maxf(dx, 0.0f), my = swnvg__maxf(dy, 0.0f);
+	return swnvg__minf(swnvg__maxf(dx, dy), 0.0f) + sqrtf(mx*mx + my*my) - rad;
+}
+
+static float swnvg__scissorMask(const SWNVGpaint* p, float x, float y)
+{
+	const float* m = p->scissorMat;
+	float sx = swnvg__absf(m[0]*x + m[2]*y + m[4]) - p->scissorExt[0];
+	float sy = swnvg__absf(m[1]*x + m[3]*y + m[5]) - p->scissorExt[1];
+	sx = 0.5f - sx * p->scissorScale[0];
+	sy = 0.5f - sy * p->scissorScale[1];
+	return swnvg__clampf(sx, 0.0f, 1.0f) * swnvg__clampf(sy, 0.0f, 1.0f);
+}
+
+static float swnvg__smoothstep(float x)
+{
+	x = swnvg__clampf(x, 0.0f, 1.0f);
+	return x*x*(3.0f - 2.0f*x);
+}
+
+static float swnvg__fract(float x)
+{
+	return x - floorf(x);
+}
+
+// Line style patterns, see the fragment shader in nanovg_gl.h.
+static float swnvg__lineStyleMask(int lineStyle, float s, float t)
+{
+	float ux = 0.5f * s, uy = 0.5f * t;
+	if (lineStyle == NVG_LINE_DASHED) {
+		float fy = swnvg__fract(uy / 4.0f);
+		float w = fy <= 0.5f ? 1.0f : 0.0f;
+		fy *= 4.0f;
+		if (fy >= 1.5f)
+			fy -= 1.5f;
+		else if (fy <= 0.5f)
+			fy = 0.5f - fy;
+		else
+			fy = 0.0f;
+		return w * swnvg__smoothstep(6.0f * (0.25f - (ux*ux + fy*fy)));
+	} else if (lineStyle == NVG_LINE_DOTTED) {
+		float fy = 4.0f * swnvg__fract(uy / 4.0f) - 0.5f;
+		return swnvg__smoothstep(6.0f * (0.25f - (ux*ux + fy*fy)));
+	} else if (lineStyle == NVG_LINE_GLOW) {
+		return swnvg__smoothstep(1.0f - 2.0f * swnvg__absf(ux));
+	}
+	return 1.0f;
+}
+
+static void swnvg__texel(const SWNVGtexture* tex, int x, int y, float* c)
+{
+	if (tex->flags & NVG_IMAGE_REPEATX) {
+		x %= tex->width;
+		if (x < 0) x += tex->width;
+	} else {
+		x = x < 0 ? 0 : (x >= tex->width ? tex->width-1 : x);
+	}
+	if (tex->flags & NVG_IMAGE_REPEATY) {
+		y %= tex->height;
+		if (y < 0) y += tex->height;
+	} else {
+		int h = tex->height * tex->pages;
+		y = y < 0 ? 0 : (y >= h ? h-1 : y);
+	}
+	if (tex->type == NVG_TEXTURE_RGBA) {
+		const unsigned char* p = &tex->data[(y*tex->width + x)*4];
+		c[0] = p[0] * (1.0f/255.0f);
+		c[1] = p[1] * (1.0f/255.0f);
+		c[2] = p[2] * (1.0f/255.0f);
+		c[3] = p[3] * (1.0f/255.0f);
+	} else {
+		c[0] = c[1] = c[2] = c[3] = tex->data[y*tex->width + x] * (1.0f/255.0f);
+	}
+}
+
+static void swnvg__sampleTexture(const SWNVGtexture* tex, float u, float v, float* c)
+{
+	float x = u * tex->width - 0.5f;
+	float y = v * tex->height - 0.5f;
+	if (tex->flags & NVG_IMAGE_NEAREST) {
+		swnvg__texel(tex, (int)floorf(x + 0.5f), (int)floorf(y + 0.5f), c);
+	} else {
+		float c00[4], c10[4], c01[4], c11[4];
+		float fx = floorf(x), fy = floorf(y);
+		float tx = x - fx, ty = y - fy;
+		int ix = (int)fx, iy = (int)fy, i;
+		swnvg__texel(tex, ix, iy, c00);
+		swnvg__texel(tex, ix+1, iy, c10);
+		swnvg__texel(tex, ix, iy+1, c01);
+		swnvg__texel(tex, ix+1, iy+1, c11);
+		for (i = 0; i < 4; i++)
+			c[i] = (c00[i]*(1.0f-tx) + c10[i]*tx)*(1.0f-ty) + (c01[i]*(1.0f-tx) + c11[i]*tx)*ty;
+	}
+}
+
+static void swnvg__textureColor(const SWNVGpaint* p, const SWNVGtexture* tex, float u, float v, float* c)
+{
+	if (tex == NULL) {
+		c[0] = c[1] = c[2] = c[3] = 0.0f;
+		return;
+	}
+	swnvg__sampleTexture(tex, u, v, c);
+	if (p->texType == 1) {
+		c[0] *= c[3];
+		c[1] *= c[3];
+		c[2] *= c[3];
+	}
+	if (p->sdf[0] != 0.0f)
+		c[0] = c[1] = c[2] = c[3] = swnvg__clampf(c[0]*p->sdf[0] + p->sdf[1], 0.0f, 1.0f);
+}
+
+static float swnvg__blendFactor(int factor, const float* src, const float* dst, int i)
+{
+	switch (factor) {
+	case NVG_ZERO: return 0.0f;
+	case NVG_ONE: return 1.0f;
+	case NVG_SRC_COLOR: return src[i];
+	case NVG_ONE_MINUS_SRC_COLOR: return 1.0f - src[i];
+	case NVG_DST_COLOR: return dst[i];
+	case NVG_ONE_MINUS_DST_COLOR: return 1.0f - dst[i];
+	case NVG_SRC_ALPHA: return src[3];
+	case NVG_ONE_MINUS_SRC_ALPHA: return 1.0f - src[3];
+	case NVG_DST_ALPHA: return dst[3];
+	case NVG_ONE_MINUS_DST_ALPHA: return 1.0f - dst[3];
+	case NVG_SRC_ALPHA_SATURATE: return i < 3 ? swnvg__minf(src[3], 1.0f - dst[3]) : 1.0f;
+	}
+	return 0.0f;
+}
+
+static void swnvg__blendPixel(unsigned char* d, const float* src, const NVGcompositeOperationState* op)
+{
+	float dst[4], out[4];
+	int i;
+	for (i = 0; i < 4; i++)
+		dst[i] = d[i] * (1.0f/255.0f);
+	for (i = 0; i < 4; i++) {
+		float sf = swnvg__blendFactor(i < 3 ? op->srcRGB : op->srcAlpha, src, dst, i);
+		float df = swnvg__blendFactor(i < 3 ? op->dstRGB : op->dstAlpha, src, dst, i);
+		out[i] = swnvg__clampf(src[i]*sf + dst[i]*df, 0.0f, 1.0f);
+	}
+	for (i = 0; i < 4; i++)
+		d[i] = (unsigned char)(out[i] * 255.0f + 0.5f);
+}
+
+// Blends solid color with source-over, this is the common case for UI rendering.
+static void swnvg__blendSolidSpan(unsigned char* dst, const float* cover, int n, const NVGcolor* color)
+{
+	int i;
+#if NANOVG_SW_SSE2
+	const __m128 col = _mm_mul_ps(_mm_setr_ps(color->r, color->g, color->b, color->a), _mm_set1_ps(255.0f));
+	const __m128 half = _mm_set1_ps(0.5f);
+	const __m128i zero = _mm_setzero_si128();
+	for (i = 0; i < n; i++, dst += 4) {
+		__m128 c = _mm_set1_ps(cover[i]);
+		__m128 s, ia, d;
+		__m128i p;
+		int v;
+		if (cover[i] <= 0.0f) continue;
+		s = _mm_mul_ps(col, c);
+		ia = _mm_set1_ps(1.0f - color->a * cover[i]);
+		memcpy(&v, dst, 4);
+		p = _mm_unpacklo_epi16(_mm_unpacklo_epi8(_mm_cvtsi32_si128(v), zero), zero);
+		d = _mm_add_ps(_mm_add_ps(s, _mm_mul_ps(_mm_cvtepi32_ps(p), ia)), half);
+		p = _mm_cvttps_epi32(d);
+		p = _mm_packs_epi32(p, p);
+		p = _mm_packus_epi16(p, p);
+		v = _mm_cvtsi128_si32(p);
+		memcpy(dst, &v, 4);
+	}
+#else
+	float col[4];
+	col[0] = color->r * 255.0f;
+	col[1] = color->g * 255.0f;
+	col[2] = color->b * 255.0f;
+	col[3] = color->a * 255.0f;
+	for (i = 0; i < n; i++, dst += 4) {
+		float c = cover[i], ia;
+		int j;
+		if (c <= 0.0f) continue;
+		ia = 1.0f - color->a * c;
+		for (j = 0; j < 4; j++)
+			dst[j] = (unsigned char)swnvg__minf(col[j]*c + dst[j]*ia + 0.5f, 255.0f);
+	}
+#endif
+}
+
+static int swnvg__isSourceOver(const NVGcompositeOperationState* op)
+{
+	return op->srcRGB == NVG_ONE && op->dstRGB == NVG_ONE_MINUS_SRC_ALPHA &&
+		op->srcAlpha == NVG_ONE && op->dstAlpha == NVG_ONE_MINUS_SRC_ALPHA;
+}
+
+// Shades and blends a span of pixels in row y starting at x.
+static void swnvg__shadeSpan(SWNVGcontext* sw, const SWNVGcall* call, const SWNVGtexture* tex, SWNVGraster* r,
+							 int x, int y, int n, const float* cover, float sx, float sy)
+{
+	const SWNVGpaint* p = &call->paint;
+	unsigned char* dst = &sw->pixels[y*sw->stride + x*4];
+	int needAttrs = call->type == SWNVG_TRIANGLES || p->lineStyle > 1;
+	const float* attr = needAttrs ? &r->attrs[((y - r->y0) * r->w + (x - r->x0)) * 3] : NULL;
+	float py = ((float)y + 0.5f) / sy;
+	float src[4];
+	int i, j;
+
+	if (p->type == SWNVG_PAINT_COLOR && !p->scissor && p->lineStyle <= 1 &&
+		call->type != SWNVG_TRIANGLES && swnvg__isSourceOver(&call->blend)) {
+		swnvg__blendSolidSpan(dst, cover, n, &p->innerCol);
+		return;
+	}
+
+	for (i = 0; i < n; i++, dst += 4) {
+		float px = ((float)(x + i) + 0.5f) / sx;
+		float alpha = cover[i];
+		if (alpha <= 0.0f && (call->blend.dstRGB != NVG_ZERO || call->blend.dstAlpha != NVG_ZERO))
+			continue;
+
+		if (p->scissor)
+			alpha *= swnvg__scissorMask(p, px, py);
+
+		if (call->type == SWNVG_TRIANGLES) {
+			// Textured triangles, color comes from the interpolated texture coordinates.
+			swnvg__textureColor(p, tex, attr[i*3+0], attr[i*3+1], src);
+			for (j = 0; j < 4; j++)
+				src[j] *= p->innerCol.rgba[j];
+		} else {
+			if (p->lineStyle > 1)
+				alpha *= swnvg__lineStyleMask(p->lineStyle, attr[i*3+0], attr[i*3+1]);
+			if (p->type == SWNVG_PAINT_COLOR) {
+				for (j = 0; j < 4; j++)
+					src[j] = p->innerCol.rgba[j];
+			} else if (p->type == SWNVG_PAINT_GRAD) {
+				const float* m = p->paintMat;
+				float ptx = m[0]*px + m[2]*py + m[4];
+				float pty = m[1]*px + m[3]*py + m[5];
+				float d = swnvg__clampf((swnvg__sdroundrect(ptx, pty, p->extent[0], p->extent[1], p->radius) + p->feather*0.5f) / p->feather, 0.0f, 1.0f);
+				for (j = 0; j < 4; j++)
+					src[j] = p->innerCol.rgba[j] + (p->outerCol.rgba[j] - p->innerCol.rgba[j]) * d;
+			} else {
+				const float* m = p->paintMat;
+				float ptx = (m[0]*px + m[2]*py + m[4]) / p->extent[0];
+				float pty = (m[1]*px + m[3]*py + m[5]) / p->extent[1];
+				swnvg__textureColor(p, tex, ptx, pty, src);
+				for (j = 0; j < 4; j++)
+					src[j] *= p->innerCol.rgba[j];
+			}
+		}
+
+		for (j = 0; j < 4; j++)
+			src[j] *= alpha;
+		swnvg__blendPixel(dst, src, &call->blend);
+	}
+}
+
+// Converts the accumulated coverage to spans and shades them.
+static void swnvg__resolveRaster(SWNVGcontext* sw, SWNVGraster* r, const SWNVGcall* call, const SWNVGtexture* tex,
+								 int evenOdd, float sx, float sy)
+{
+	int i, y;
+	for (y = 0; y < r->h; y++) {
+		const int* span = &r->spans[y*2];
+		float* cells = &r->cells[y * r->stride];
+		float acc;
+		int x0, x1;
+		if (span[1] < span[0]) continue;
+		x0 = span[0];
+		x1 = swnvg__mini(span[1], r->w - 1);
+		acc = swnvg__accumRow(&cells[x0], r->cover, x1 - x0 + 1, 0.0f, evenOdd);
+		// Clear the cells right of the region.
+		for (i = x1 + 1; i <= span[1]; i++)
+			cells[i] = 0.0f;
+		swnvg__shadeSpan(sw, call, tex, r, r->x0 + x0, r->y0 + y, x1 - x0 + 1, r->cover, sx, sy);
+		// Shapes which continue past the right edge of the region have constant coverage after the last edge.
+		if (swnvg__absf(acc) > 1e-4f && x1 + 1 < r->w) {
+			float a = swnvg__absf(acc);
+			int n = r->w - (x1 + 1);
+			if (evenOdd) {
+				a = fmodf(a, 2.0f);
+				if (a > 1.0f) a = 2.0f - a;
+			}
+			a = swnvg__minf(a, 1.0f);
+			for (i = 0; i < n; i++)
+				r->cover[i] = a;
+			swnvg__shadeSpan(sw, call, tex, r, r->x0 + x1 + 1, r->y0 + y, n, r->cover, sx, sy);
+		}
+	}
+}
+
+// Draws one shape quad of a shape batch. The coverage comes from the distance to the rounded
+// rectangle, in the local coordinates of the quad which map linearly to the pixels.
+static void swnvg__drawShape(SWNVGcontext* sw, SWNVGraster* r, const SWNVGcall* call, const NVGshapeVertex* v,
+							 const int* region, float sx, float sy)
+{
+	const SWNVGpaint* p = &call->paint;
+	float ox = v[0].x*sx, oy = v[0].y*sy;
+	float ux = v[3].x*sx - ox, uy = v[3].y*sy - oy;
+	float vx = v[1].x*sx - ox, vy = v[1].y*sy - oy;
+	float du = v[3].u - v[0].u, dv = v[1].v - v[0].v;
+	float det = ux*vy - uy*vx;
+	float dudx, dudy, dvdx, dvdy, k, minx, miny, maxx, maxy;
+	float src[4];
+	NVGcolor color;
+	int x, y, x0, y0, x1, y1, i, j, fast;
+
+	if (swnvg__absf(det) < 1e-6f || du == 0.0f || dv == 0.0f) return;
+
+	// Local coordinate steps per pixel, and pixels per local unit for the anti-aliased edge.
+	dudx = vy / det * du;
+	dudy = -vx / det * du;
+	dvdx = -uy / det * dv;
+	dvdy = ux / det * dv;
+	k = sqrtf(swnvg__absf(det / (du*dv)));
+
+	minx = swnvg__minf(swnvg__minf(ox, ox + ux), swnvg__minf(ox + vx, ox + ux + vx));
+	miny = swnvg__minf(swnvg__minf(oy, oy + uy), swnvg__minf(oy + vy, oy + uy + vy));
+	maxx = swnvg__maxf(swnvg__maxf(ox, ox + ux), swnvg__maxf(ox + vx, ox + ux + vx));
+	maxy = swnvg__maxf(swnvg__maxf(oy, oy + uy), swnvg__maxf(oy + vy, oy + uy + vy));
+	x0 = swnvg__maxi(region[0], (int)floorf(minx) - 1);
+	y0 = swnvg__maxi(region[1], (int)floorf(miny) - 1);
+	x1 = swnvg__mini(region[2], (int)ceilf(maxx) + 1);
+	y1 = swnvg__mini(region[3], (int)ceilf(maxy) + 1);
+	if (x0 >= x1 || y0 >= y1) return;
+	if (swnvg__reserveCover(r, x1 - x0) == 0) return;
+
+	for (i = 0; i < 4; i++)
+		color.rgba[i] = v[0].color[i] * (1.0f/255.0f);
+	fast = !p->scissor && swnvg__isSourceOver(&call->blend);
+
+	for (y = y0; y < y1; y++) {
+		float py = (float)y + 0.5f - oy;
+		float px = (float)x0 + 0.5f - ox;
+		float u = v[0].u + px*dudx + py*dudy;
+		float w = v[0].v + px*dvdx + py*dvdy;
+		unsigned char* dst = &sw->pixels[y*sw->stride + x0*4];
+		for (x = 0; x < x1 - x0; x++) {
+			float d = swnvg__sdroundrect(u, w, v[0].ex, v[0].ey, v[0].radius);
+			r->cover[x] = swnvg__clampf(0.5f - d*k, 0.0f, 1.0f);
+			u += dudx;
+			w += dvdx;
+		}
+		if (fast) {
+			swnvg__blendSolidSpan(dst, r->cover, x1 - x0, &color);
+			continue;
+		}
+		for (x = 0; x < x1 - x0; x++, dst += 4) {
+			float alpha = r->cover[x];
+			if (alpha <= 0.0f && (call->blend.dstRGB != NVG_ZERO || call->blend.dstAlpha != NVG_ZERO))
+				continue;
+			if (p->scissor)
+				alpha *= swnvg__scissorMask(p, ((float)(x0 + x) + 0.5f) / sx, ((float)y + 0.5f) / sy);
+			for (j = 0; j < 4; j++)
+				src[j] = color.rgba[j] * alpha;
+			swnvg__blendPixel(dst, src, &call->blend);
+		}
+	}
+}
+
+static int swnvg__rasterRegion(const float* bounds, int cx0, int cy0, int cx1, int cy1, float sx, float sy, int* region)
+{
+	if (bounds[0] > bounds[2] || bounds[1] > bounds[3]) return 0;
+	region[0] = swnvg__maxi(cx0, (int)floorf(bounds[0] * sx));
+	region[1] = swnvg__maxi(cy0, (int)floorf(bounds[1] * sy));
+	region[2] = swnvg__mini(cx1, (int)ceilf(bounds[2] * sx) + 1);
+	region[3] = swnvg__mini(cy1, (int)ceilf(bounds[3] * sy) + 1);
+	return region[0] < region[2] && region[1] < region[3];
+}
+
+// Draws call clipped to the region cx0,cy0 - cx1,cy1 of the framebuffer.
+static void swnvg__drawCall(SWNVGcontext* sw, SWNVGraster* r, const SWNVGcall* call, int cx0, int cy0, int cx1, int cy1, float sx, float sy)
+{
+	const SWNVGpaint* p = &call->paint;
+	const SWNVGtexture* tex = NULL;
+	int evenOdd = call->type == SWNVG_FILL && (sw->flags & NVG_SW_EVENODD) != 0;
+	int region[4], i, j;
+
+	if (swnvg__rasterRegion(call->bounds, cx0, cy0, cx1, cy1, sx, sy, region) == 0) return;
+
+	if (p->type == SWNVG_PAINT_IMG || call->type == SWNVG_TRIANGLES)
+		tex = swnvg__findTexture(sw, p->image);
+
+	if (call->type == SWNVG_FILL) {
+		if (swnvg__rasterBegin(r, region[0], region[1], region[2], region[3], 0) == 0) return;
+		for (i = 0; i < call->pathCount; i++) {
+			const SWNVGpath* path = &sw->paths[call->pathOffset + i];
+			const NVGvertex* verts = &sw->verts[path->offset];
+			for (j = 0; j < path->count; j++) {
+				const NVGvertex* v0 = &verts[j];
+				const NVGvertex* v1 = &verts[(j+1) % path->count];
+				swnvg__rasterLine(r, v0->x*sx, v0->y*sy, v1->x*sx, v1->y*sy);
+			}
+		}
+		swnvg__resolveRaster(sw, r, call, tex, evenOdd, sx, sy);
+	} else if (call->type == SWNVG_STROKE) {
+		// The stroke is union of its triangles, so overlapping parts are not blended twice.
+		int needAttrs = p->lineStyle > 1;
+		if (swnvg__rasterBegin(r, region[0], region[1], region[2], region[3], needAttrs) == 0) return;
+		for (i = 0; i < call->pathCount; i++) {
+			const SWNVGpath* path = &sw->paths[call->pathOffset + i];
+			const NVGvertex* verts = &sw->verts[path->offset];
+			for (j = 0; j+2 < path->count; j++) {
+				swnvg__rasterTriangle(r, verts[j].x*sx, verts[j].y*sy, verts[j+1].x*sx, verts[j+1].y*sy, verts[j+2].x*sx, verts[j+2].y*sy);
+				if (needAttrs)
+					swnvg__rasterAttrs(r, &verts[j], &verts[j+1], &verts[j+2], sx, sy, 1);
+			}
+		}
+		swnvg__resolveRaster(sw, r, call, tex, 0, sx, sy);
+	} else if (call->type == SWNVG_TRIANGLES) {
+		// Triangles are blended separately like on the GPU, so that overlapping glyphs add up.
+		// Pairs of triangles are rasterized together to avoid seams inside quads.
+		const NVGvertex* verts = &sw->verts[call->triangleOffset];
+		for (j = 0; j+2 < call->triangleCount; j += 6) {
+			int n = swnvg__mini(6, call->triangleCount - j) / 3 * 3;
+			float bounds[4];
+			int quad[4];
+			swnvg__initBounds(bounds);
+			swnvg__addBounds(bounds, &verts[j], n);
+			if (swnvg__rasterRegion(bounds, region[0], region[1], region[2], region[3], sx, sy, quad) == 0) continue;
+			if (swnvg__rasterBegin(r, quad[0], quad[1], quad[2], quad[3], 1) == 0) return;
+			for (i = j; i < j+n; i += 3) {
+				swnvg__rasterTriangle(r, verts[i].x*sx, verts[i].y*sy, verts[i+1].x*sx, verts[i+1].y*sy, verts[i+2].x*sx, verts[i+2].y*sy);
+				swnvg__rasterAttrs(r, &verts[i], &verts[i+1], &verts[i+2], sx, sy, 0);
+			}
+			swnvg__resolveRaster(sw, r, call, tex, 0, sx, sy);
+		}
+	} else if (call->type == SWNVG_SHAPES) {
+		// Shapes are blended separately like on the GPU.
+		const NVGshapeVertex* verts = &sw->shapeVerts[call->triangleOffset];
+		for (j = 0; j+4 <= call->triangleCount; j += 4)
+			swnvg__drawShape(sw, r, call, &verts[j], region, sx, sy);
+	}
+}
+
+static void swnvg__renderCancel(void* uptr)
+{
+	SWNVGcontext* sw = (SWNVGcontext*)uptr;
+	sw->nverts = 0;
+	sw->nshapeVerts = 0;
+	sw->npaths = 0;
+	sw->ncalls = 0;
+}
+
+static void swnvg__freeRaster(SWNVGraster* r)
+{
+	free(r->cells);
+	free(r->spans);
+	free(r->attrs);
+	free(r->cover);
+	memset(r, 0, sizeof(*r));
+}
+
+#ifndef NANOVG_SW_NO_THREADS
+
+//
+// Threads
+//
+// The calls are binned to tiles which are rendered by a pool of workers. Each worker starts with
+// a contiguous range of tiles, and steals half of the remaining tiles from others when done.
+// Each tile is rendered by one worker, in call order.
+
+#ifdef _WIN32
+static void swnvg__lock(SWNVGcontext* sw) { EnterCriticalSection(&sw->lock); }
+static void swnvg__unlock(SWNVGcontext* sw) { LeaveCriticalSection(&sw->lock); }
+static void swnvg__wait(SWNVGcontext* sw, CONDITION_VARIABLE* cond) { SleepConditionVariableCS(cond, &sw->lock, INFINITE); }
+static void swnvg__broadcast(CONDITION_VARIABLE* cond) { WakeAllConditionVariable(cond); }
+#else
+static void swnvg__lock(SWNVGcontext* sw) { pthread_mutex_lock(&sw->lock); }
+static void swnvg__unlock(SWNVGcontext* sw) { pthread_mutex_unlock(&sw->lock); }
+static void swnvg__wait(SWNVGcontext* sw, pthread_cond_t* cond) { pthread_cond_wait(cond, &sw->lock); }
+static void swnvg__broadcast(pthread_cond_t* cond) { pthread_cond_broadcast(cond); }
+#endif
+
+static unsigned long long swnvg__loadTiles(unsigned long long* tiles)
+{
+#ifdef _MSC_VER
+	return (unsigned long long)InterlockedCompareExchange64((volatile LONGLONG*)tiles, 0, 0);
+#else
+	return __atomic_load_n(tiles, __ATOMIC_ACQUIRE);
+#endif
+}
+
+static int swnvg__casTiles(unsigned long long* tiles, unsigned long long expected, unsigned long long desired)
+{
+#ifdef _MSC_VER
+	return (unsigned long long)InterlockedCompareExchange64((volatile LONGLONG*)tiles, (LONGLONG)desired, (LONGLONG)expected) == expected;
+#else
+	return __atomic_compare_exchange_n(tiles, &expected, desired, 0, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE);
+#endif
+}
+
+static unsigned long long swnvg__packTiles(int begin, int end)
+{
+	return (unsigned long long)(unsigned int)begin | ((unsigned long long)(unsigned int)end << 32);
+}
+
+static void swnvg__storeTiles(unsigned long long* tiles, int begin, int end)
+{
+	unsigned long long r;
+	do {
+		r = swnvg__loadTiles(tiles);
+	} while (!swnvg__casTiles(tiles, r, swnvg__packTiles(begin, end)));
+}
+
+// Takes the next tile from the worker's own range.
+static int swnvg__popTile(SWNVGworker* w)
+{
+	for (;;) {
+		unsigned long long r = swnvg__loadTiles(&w->tiles);
+		int begin = (int)(r & 0xffffffffu), end = (int)(r >> 32);
+		if (begin >= end) return -1;
+		if (swnvg__casTiles(&w->tiles, r, swnvg__packTiles(begin+1, end)))
+			return begin;
+	}
+}
+
+// Steals half of the remaining tiles of another worker, returns the first of them.
+static int swnvg__stealTile(SWNVGworker* w)
+{
+	SWNVGcontext* sw = w->sw;
+	int i;
+	for (i = 1; i < sw->nworkers; i++) {
+		SWNVGworker* victim = &sw->workers[(w->index + i) % sw->nworkers];
+		for (;;) {
+			unsigned long long r = swnvg__loadTiles(&victim->tiles);
+			int begin = (int)(r & 0xffffffffu), end = (int)(r >> 32);
+			int n = (end - begin + 1) / 2;
+			if (begin >= end) break;
+			if (swnvg__casTiles(&victim->tiles, r, swnvg__packTiles(begin, end - n))) {
+				swnvg__storeTiles(&w->tiles, end - n + 1, end);
+				return end - n;
+			}
+		}
+	}
+	return -1;
+}
+
+static void swnvg__runWorker(SWNVGworker* w)
+{
+	SWNVGcontext* sw = w->sw;
+	float sx = (float)sw->width / sw->view[0];
+	float sy = (float)sw->height / sw->view[1];
+	int tile, i;
+
+	for (;;) {
+		int x0, y0, x1, y1;
+		tile = swnvg__popTile(w);
+		if (tile == -1)
+			tile = swnvg__stealTile(w);
+		if (tile == -1)
+			break;
+		x0 = (tile % sw->tilesX) * NANOVG_SW_TILE_SIZE;
+		y0 = (tile / sw->tilesX) * NANOVG_SW_TILE_SIZE;
+		x1 = swnvg__mini(x0 + NANOVG_SW_TILE_SIZE, sw->width);
+		y1 = swnvg__mini(y0 + NANOVG_SW_TILE_SIZE, sw->height);
+		for (i = sw->tileOffsets[tile]; i < sw->tileOffsets[tile+1]; i++)
+			swnvg__drawCall(sw, &w->raster, &sw->calls[sw->tileCalls[i]], x0, y0, x1, y1, sx, sy);
+	}
+}
+
+#ifdef _WIN32
+static DWORD WINAPI swnvg__workerThread(LPVOID arg)
+#else
+static void* swnvg__workerThread(void* arg)
+#endif
+{
+	SWNVGworker* w = (SWNVGworker*)arg;
+	SWNVGcontext* sw = w->sw;
+	int generation = w->generation;
+
+	swnvg__lock(sw);
+	for (;;) {
+		while (sw->generation == generation && !sw->quit)
+			swnvg__wait(sw, &sw->start);
+		if (sw->quit)
+			break;
+		generation = sw->generation;
+		swnvg__unlock(sw);
+
+		swnvg__runWorker(w);
+
+		swnvg__lock(sw);
+		if (--sw->pending == 0)
+			swnvg__broadcast(&sw->done);
+	}
+	swnvg__unlock(sw);
+
+	return 0;
+}
+
+static int swnvg__startThread(SWNVGworker* w)
+{
+	// Taken before the thread runs, a frame may be started before the thread gets the lock.
+	w->generation = w->sw->generation;
+#ifdef _WIN32
+	w->thread = CreateThread(NULL, 0, swnvg__workerThread, w, 0, NULL);
+	return w->thread != NULL;
+#else
+	return pthread_create(&w->thread, NULL, swnvg__workerThread, w) == 0;
+#endif
+}
+
+static void swnvg__joinThread(SWNVGworker* w)
+{
+#ifdef _WIN32
+	WaitForSingleObject(w->thread, INFINITE);
+	CloseHandle(w->thread);
+#else
+	pthread_join(w->thread, NULL);
+#endif
+}
+
+static void swnvg__stopWorkers(SWNVGcontext* sw)
+{
+	int i;
+	if (sw->nworkers <= 1) return;
+	swnvg__lock(sw);
+	sw->quit = 1;
+	swnvg__broadcast(&sw->start);
+	swnvg__unlock(sw);
+	for (i = 1; i < sw->nworkers; i++)
+		swnvg__joinThread(&sw->workers[i]);
+	sw->quit = 0;
+}
+
+static int swnvg__cpuCount(void)
+{
+#ifdef _WIN32
+	SYSTEM_INFO info;
+	GetSystemInfo(&info);
+	return (int)info.dwNumberOfProcessors;
+#else
+	return (int)sysconf(_SC_NPROCESSORS_ONLN);
+#endif
+}
+
+// Builds per tile lists of the calls overlapping each tile.
+static int swnvg__binCalls(SWNVGcontext* sw, float sx, float sy)
+{
+	int ntiles, ntileCalls, i, tx, ty, region[4];
+
+	sw->tilesX = (sw->width + NANOVG_SW_TILE_SIZE-1) / NANOVG_SW_TILE_SIZE;
+	sw->tilesY = (sw->height + NANOVG_SW_TILE_SIZE-1) / NANOVG_SW_TILE_SIZE;
+	ntiles = sw->tilesX * sw->tilesY;
+
+	if (ntiles+1 > sw->ctileOffsets) {
+		int* offsets;
+		int coffsets = swnvg__maxi(ntiles+1, 256) + sw->ctileOffsets/2; // 1.5x Overallocate
+		offsets = (int*)realloc(sw->tileOffsets, sizeof(int) * coffsets);
+		if (offsets == NULL) return 0;
+		sw->tileOffsets = offsets;
+		sw->ctileOffsets = coffsets;
+	}
+	memset(sw->tileOffsets, 0, sizeof(int) * (ntiles+1));
+
+	// Count calls per tile.
+	ntileCalls = 0;
+	for (i = 0; i < sw->ncalls; i++) {
+		if (swnvg__rasterRegion(sw->calls[i].bounds, 0, 0, sw->width, sw->height, sx, sy, region) == 0) continue;
+		for (ty = region[1] / NANOVG_SW_TILE_SIZE; ty <= (region[3]-1) / NANOVG_SW_TILE_SIZE; ty++) {
+			for (tx = region[0] / NANOVG_SW_TILE_SIZE; tx <= (region[2]-1) / NANOVG_SW_TILE_SIZE; tx++) {
+				sw->tileOffsets[ty * sw->tilesX + tx + 1]++;
+				ntileCalls++;
+			}
+		}
+	}
+
+	if (ntileCalls > sw->ctileCalls) {
+		int* tileCalls;
+		int ctileCalls = swnvg__maxi(ntileCalls, 1024) + sw->ctileCalls/2; // 1.5x Overallocate
+		tileCalls = (int*)realloc(sw->tileCalls, sizeof(int) * ctileCalls);
+		if (tileCalls == NULL) return 0;
+		sw->tileCalls = tileCalls;
+		sw->ctileCalls = ctileCalls;
+	}
+
+	for (i = 0; i < ntiles; i++)
+		sw->tileOffsets[i+1] += sw->tileOffsets[i];
+
+	// Fill in the calls, the offsets are used as insert positions and end up shifted by one tile.
+	for (i = 0; i < sw->ncalls; i++) {
+		if (swnvg__rasterRegion(sw->calls[i].bounds, 0, 0, sw->width, sw->height, sx, sy, region) == 0) continue;
+		for (ty = region[1] / NANOVG_SW_TILE_SIZE; ty <= (region[3]-1) / NANOVG_SW_TILE_SIZE; ty++) {
+			for (tx = region[0] / NANOVG_SW_TILE_SIZE; tx <= (region[2]-1) / NANOVG_SW_TILE_SIZE; tx++)
+				sw->tileCalls[sw->tileOffsets[ty * sw->tilesX + tx]++] = i;
+		}
+	}
+	for (i = ntiles; i > 0; i--)
+		sw->tileOffsets[i] = sw->tileOffsets[i-1];
+	sw->tileOffsets[0] = 0;
+
+	return 1;
+}
+
+static void swnvg__renderTiles(SWNVGcontext* sw)
+{
+	int ntiles = sw->tilesX * sw->tilesY;
+	int i;
+
+	for (i = 0; i < sw->nworkers; i++)
+		sw->workers[i].tiles = swnvg__packTiles(ntiles * i / sw->nworkers, ntiles * (i+1) / sw->nworkers);
+
+	swnvg__lock(sw);
+	sw->generation++;
+	sw->pending = sw->nworkers - 1;
+	swnvg__broadcast(&sw->start);
+	swnvg__unlock(sw);
+
+	swnvg__runWorker(&sw->workers[0]);
+
+	swnvg__lock(sw);
+	while (sw->pending > 0)
+		swnvg__wait(sw, &sw->done);
+	swnvg__unlock(sw);
+}
+
+#endif
+
+static void swnvg__renderFlush(void* uptr)
+{
+	SWNVGcontext* sw = (SWNVGcontext*)uptr;
+	int i;
+
+	if (sw->ncalls > 0 && sw->pixels != NULL && sw->view[0] > 0.0f && sw->view[1] > 0.0f) {
+		float sx = (float)sw->width / sw->view[0];
+		float sy = (float)sw->height / sw->view[1];
+#ifndef NANOVG_SW_NO_THREADS
+		if (sw->nworkers > 1 && swnvg__binCalls(sw, sx, sy)) {
+			swnvg__renderTiles(sw);
+		} else
+#endif
+		{
+			for (i = 0; i < sw->ncalls; i++)
+				swnvg__drawCall(sw, &sw->workers[0].raster, &sw->calls[i], 0, 0, sw->width, sw->height, sx, sy);
+		}
+	}
+
+	// Reset calls
+	sw->nverts = 0;
+	sw->nshapeVerts = 0;
+	sw->npaths = 0;
+	sw->ncalls = 0;
+}
+
+static void swnvg__renderDelete(void* uptr)
+{
+	SWNVGcontext* sw = (SWNVGcontext*)uptr;
+	int i;
+	if (sw == NULL) return;
+
+	if (sw->workers != NULL) {
+#ifndef NANOVG_SW_NO_THREADS
+		swnvg__stopWorkers(sw);
+#ifdef _WIN32
+		DeleteCriticalSection(&sw->lock);
+#else
+		pthread_mutex_destroy(&sw->lock);
+		pthread_cond_destroy(&sw->start);
+		pthread_cond_destroy(&sw->done);
+#endif
+#endif
+		for (i = 0; i < sw->nworkers; i++)
+			swnvg__freeRaster(&sw->workers[i].raster);
+		free(sw->workers);
+	}
+
+	for (i = 0; i < sw->ntextures; i++)
+		free(sw->textures[i].data);
+	free(sw->textures);
+
+	free(sw->tileOffsets);
+	free(sw->tileCalls);
+
+	free(sw->paths);
+	free(sw->verts);
+	free(sw->shapeVerts);
+	free(sw->calls);
+
+	free(sw);
+}
+
+NVGcontext* nvgCreateSW(int flags)
+{
+	NVGparams params;
+	NVGcontext* ctx = NULL;
+	SWNVGcontext* sw = (SWNVGcontext*)malloc(sizeof(SWNVGcontext));
+	if (sw == NULL) goto error;
+	memset(sw, 0, sizeof(SWNVGcontext));
+
+	memset(&params, 0, sizeof(params));
+	params.renderCreate = swnvg__renderCreate;
+	params.renderCreateTexture = swnvg__renderCreateTexture;
+	params.renderDeleteTexture = swnvg__renderDeleteTexture;
+	params.renderUpdateTexture = swnvg__renderUpdateTexture;
+	params.renderResizeTexturePages = swnvg__renderResizeTexturePages;
+	params.renderGetTextureSize = swnvg__renderGetTextureSize;
+	params.renderGetImageTextureId = swnvg__renderGetImageTextureId;
+	params.renderViewport = swnvg__renderViewport;
+	params.renderCancel = swnvg__renderCancel;
+	params.renderFlush = swnvg__renderFlush;
+	params.renderFill = swnvg__renderFill;
+	params.renderStroke = swnvg__renderStroke;
+	params.renderTriangles = swnvg__renderTriangles;
+	if (flags & NVG_SW_SDF_TEXT)
+		params.renderSDFTriangles = swnvg__renderSDFTriangles;
+	params.renderShapes = swnvg__renderShapes;
+	params.renderDelete = swnvg__renderDelete;
+	params.userPtr = sw;
+	// Coverage is computed analytically, fringes are not needed.
+	params.edgeAntiAlias = 0;
+
+	sw->flags = flags;
+
+	ctx = nvgCreateInternal(&params);
+	if (ctx == NULL) goto error;
+
+	return ctx;
+
+error:
+	// 'sw' is freed by nvgDeleteInternal.
+	if (ctx != NULL) nvgDeleteInternal(ctx);
+	return NULL;
+}
+
+void nvgDeleteSW(NVGcontext* ctx)
+{
+	nvgDeleteInternal(ctx);
+}
+
+void nvgswSetFramebuffer(NVGcontext* ctx, void* pixels, int w, int h, int stride)
+{
+	SWNVGcontext* sw = (SWNVGcontext*)nvgInternalParams(ctx)->userPtr;
+	sw->pixels = (unsigned char*)pixels;
+	sw->width = w;
+	sw->height = h;
+	sw->stride = stride;
+}
+
+int nvgswSetThreadCount(NVGcontext* ctx, int count)
+{
+	SWNVGcontext* sw = (SWNVGcontext*)nvgInternalParams(ctx)->userPtr;
+#ifdef NANOVG_SW_NO_THREADS
+	NVG_NOTUSED(sw);
+	NVG_NOTUSED(count);
+	return 1;
+#else
+	int i;
+
+	if (count <= 0)
+		count = swnvg__cpuCount();
+	count = swnvg__maxi(1, swnvg__mini(count, NANOVG_SW_MAX_THREADS));
+	if (count == sw->nworkers)
+		return count;
+
+	swnvg__stopWorkers(sw);
+
+	for (i = count; i < sw->nworkers; i++)
+		swnvg__freeRaster(&sw->workers[i].raster);
+	if (count > sw->nworkers) {
+		SWNVGworker* workers = (SWNVGworker*)realloc(sw->workers, sizeof(SWNVGworker) * count);
+		if (workers != NULL) {
+			sw->workers = workers;
+			memset(&sw->workers[sw->nworkers], 0, sizeof(SWNVGworker) * (count - sw->nworkers));
+		} else {
+			count = sw->nworkers;
+		}
+	}
+	sw->nworkers = count;
+
+	for (i = 0; i < sw->nworkers; i++) {
+		sw->workers[i].sw = sw;
+		sw->workers[i].index = i;
+	}
+	for (i = 1; i < sw->nworkers; i++) {
+		if (!swnvg__startThread(&sw->workers[i])) {
+			int j;
+			for (j = i; j < sw->nworkers; j++)
+				swnvg__freeRaster(&sw->workers[j].raster);
+			sw->nworkers = i;
+			break;
+		}
+	}
+
+	return sw->nworkers;
+#endif
+}
+
+#endif /* NANOVG_SW_IMPLEMENTATION */